@@ -63,6 +63,13 @@ function(protobuf_gen)
     set(multi_value)
     cmake_parse_arguments(ARG "${options}" "${single_value}" "${multi_value}" "${ARGN}")
     get_filename_component(filename ${ARG_PROTO} NAME_WE)
+    # protoc places the generated files by the path of the proto relative to
+    # PROTO_PATH, e.g. kuksa/val/v1/val.pb.h
+    get_filename_component(proto_dir ${ARG_PROTO} DIRECTORY)
+    file(RELATIVE_PATH proto_subdir "${ARG_PROTO_PATH}" "${proto_dir}")
+    if(proto_subdir)
+        set(filename "${proto_subdir}/${filename}")
+    endif()
     set(PROTO_SRCS "${ARG_OUTPUT}/${filename}.pb.cc")
     set(PROTO_HDRS "${ARG_OUTPUT}/${filename}.pb.h")
     set(GRPC_SRCS "${ARG_OUTPUT}/${filename}.grpc.pb.cc")
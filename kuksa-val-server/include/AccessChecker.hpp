@@ -31,7 +31,7 @@ class IAuthenticator;
 class AccessChecker : public IAccessChecker {
  private:
   std::shared_ptr<IAuthenticator> tokenValidator;
-  bool checkSignalAccess(const KuksaChannel& channel, const std::string& path, const std::string& requiredPermission);
+  bool checkSignalAccess(const KuksaChannel& channel, const std::string& path, PermissionMatcher::Access requiredPermission);
 
  public:
   AccessChecker(std::shared_ptr<IAuthenticator> vdator);
@@ -0,0 +1,87 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Registry of the connections of a server, handing out their connection
+ *  ids. An id is the index of a slot in a table together with the generation
+ *  of that slot, which changes whenever a connection is removed. So ids of
+ *  closed connections never reach a new connection reusing the slot.
+ *
+ *  Slots hold weak references, looking up a connection takes no lock
+ *  besides the one guarding the atomic shared_ptr access of the slot, and
+ *  finds nothing once the connection is gone, even if it has not been
+ *  removed yet. Adding and removing connections is serialized.
+ */
+
+#ifndef __CONNECTIONREGISTRY_HPP__
+#define __CONNECTIONREGISTRY_HPP__
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "IServer.hpp"
+
+class ConnectionRegistry {
+  public:
+    ConnectionRegistry();
+    ConnectionRegistry(const ConnectionRegistry &) = delete;
+    ConnectionRegistry& operator=(const ConnectionRegistry &) = delete;
+
+    /** Returns the id of the new connection, never 0. Throws
+     *  std::runtime_error if the registry is full */
+    ConnectionId add(std::weak_ptr<IConnection> connection);
+    /** Ignores ids that have already been removed */
+    void remove(ConnectionId id);
+    /** Returns nullptr if the connection has been removed or destroyed */
+    std::shared_ptr<IConnection> find(ConnectionId id) const;
+    size_t size() const;
+
+    static const size_t CHUNK_SIZE = 1024;
+    static const size_t MAX_CHUNKS = 1024;
+
+  private:
+    struct Entry {
+      ConnectionId id;
+      std::weak_ptr<IConnection> connection;
+    };
+    struct Slot {
+      /// read with std::atomic_load, so that lookups need no mutex
+      std::shared_ptr<const Entry> entry;
+      /// generation of the next id handed out for the slot, mutex_ is held
+      uint32_t generation = 1;
+    };
+
+    /// Slots are allocated in chunks that are never moved, lookups read the
+    /// chunk pointers without the mutex
+    std::array<std::atomic<Slot*>, MAX_CHUNKS> chunks_;
+    std::vector<std::unique_ptr<Slot[]>> ownedChunks_;
+
+    mutable std::mutex mutex_;
+    /// Unused slots, reused in the order they were freed
+    std::deque<uint32_t> free_;
+    uint32_t allocated_ = 0;
+    size_t size_ = 0;
+};
+
+#endif
@@ -73,6 +73,16 @@ namespace JsonResponses {
 
   jsoncons::json notSetResponse(std::string request_id, std::string message);
 
+  /** The server is too busy to process the request */
+  jsoncons::json serviceUnavailable(std::string request_id,
+                                    const std::string action,
+                                    std::string message);
+
+  void serviceUnavailable(std::string request_id,
+                          const std::string action,
+                          std::string message,
+                          jsoncons::json& jsonResponse);
+
   std::string getTimeStamp();
 
   void addTimeStampToJSON(jsoncons::json& jsontarget, const std::string suffix="");
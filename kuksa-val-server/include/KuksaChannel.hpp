@@ -24,10 +24,13 @@
 
 #include <stdint.h>
 #include <jsoncons/json.hpp>
+#include <memory>
 #include <string>
 #include <boost/uuid/uuid_io.hpp>  
 #include <boost/functional/hash.hpp>
 #include "kuksa.grpc.pb.h"
+#include "kuksa/val/v1/val.pb.h"
+#include "PermissionMatcher.hpp"
 
 using namespace std;
 using namespace jsoncons;
@@ -45,7 +48,22 @@ struct gRPCUUIDHasher
   }
 };
 
-using gRPCSubscriptionMap_t = std::unordered_map<boost::uuids::uuid, grpc::ServerReaderWriter<::kuksa::SubscribeResponse, ::kuksa::SubscribeRequest>*, gRPCUUIDHasher>;
+/** Stream of a gRPC subscribe call, notifications for the subscriptions
+ *  made on the call are sent to it */
+class IGrpcSubscriptionSink {
+ public:
+  virtual ~IGrpcSubscriptionSink() {}
+  /** Queues resp to be written. Returns false if the call has ended */
+  virtual bool send(const ::kuksa::SubscribeResponse& resp) = 0;
+};
+
+/** Stream of a kuksa.val.v1 subscribe call */
+class IValSubscriptionSink {
+ public:
+  virtual ~IValSubscriptionSink() {}
+  /** Queues update to be written. Returns false if the call has ended */
+  virtual bool send(const ::kuksa::val::v1::EntryUpdate& update) = 0;
+};
 
 
 class KuksaChannel {
@@ -55,23 +73,46 @@ class KuksaChannel {
     WEBSOCKET_SSL,
     HTTP_PLAIN,
     HTTP_SSL,
-    GRPC
+    /// connections on the Unix domain socket
+    WEBSOCKET_LOCAL,
+    HTTP_LOCAL,
+    GRPC,
+    /// calls of the kuksa.val.v1 gRPC API
+    GRPC_VAL_V1
+  };
+  /// How messages are encoded on a Web-Socket connection
+  enum class Encoding {
+    JSON,
+    CBOR,
+    MSGPACK
   };
  private:
-  uint64_t connectionID;
+  uint64_t connectionID = 0;
   bool authorized = false;
   bool modifyTree = false;
   string authToken;
   json permissions;
+  /// permissions compiled for checking access
+  std::shared_ptr<const PermissionMatcher> permissionMatcher;
   Type typeOfConnection;
+  Encoding encoding = Encoding::JSON;
   
  public:
 
   void setConnID(uint64_t conID) { connectionID = conID; }
   void setAuthorized(bool isauth) { authorized = isauth; }
   void setAuthToken(string tok) { authToken = tok; }
-  void setPermissions(json perm) { permissions = perm; }
+  void setPermissions(json perm) {
+    permissions = perm;
+    permissionMatcher = std::make_shared<const PermissionMatcher>(permissions);
+  }
+  /// Grants permissions compiled before, e.g. shared by all channels of a user
+  void setPermissions(json perm, std::shared_ptr<const PermissionMatcher> matcher) {
+    permissions = perm;
+    permissionMatcher = std::move(matcher);
+  }
   void setType(Type type) { typeOfConnection = type; }
+  void setEncoding(Encoding enc) { encoding = enc; }
   void enableModifyTree (){ modifyTree = true; }
 
   uint64_t getConnID() const { return connectionID; }
@@ -79,8 +120,14 @@ class KuksaChannel {
   bool authorizedToModifyTree() const { return modifyTree; }
   string getAuthToken() const { return authToken; }
   json getPermissions() const { return permissions; }
+  /// nullptr if no permissions have been granted
+  const PermissionMatcher* getPermissionMatcher() const { return permissionMatcher.get(); }
   Type getType() const { return typeOfConnection; }
-  std::shared_ptr<gRPCSubscriptionMap_t> grpcSubsMap;
+  Encoding getEncoding() const { return encoding; }
+  /// set for channels of gRPC subscribe calls
+  std::weak_ptr<IGrpcSubscriptionSink> grpcSink;
+  /// set for channels of kuksa.val.v1 subscribe calls
+  std::weak_ptr<IValSubscriptionSink> valSink;
 
   KuksaChannel ( const KuksaChannel & ) = default;
   KuksaChannel (  ) = default;
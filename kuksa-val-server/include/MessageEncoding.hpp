@@ -0,0 +1,55 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Encoding of Web-Socket messages. Clients select CBOR or MessagePack by
+ *  offering the Web-Socket subprotocol "kuksa.cbor" or "kuksa.msgpack" when
+ *  connecting, messages then carry the same data as the JSON messages, but
+ *  are sent as binary frames. Without subprotocol, messages are JSON text.
+ */
+
+#ifndef __MESSAGEENCODING_HPP__
+#define __MESSAGEENCODING_HPP__
+
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+#include "KuksaChannel.hpp"
+
+namespace MessageEncoding {
+  /** Selects the encoding of the first supported subprotocol in the
+   *  comma separated list offered by a client. Returns false if none is
+   *  supported */
+  bool fromSubprotocols(const std::string &offered, KuksaChannel::Encoding &encoding);
+  std::string subprotocol(KuksaChannel::Encoding encoding);
+
+  /** Throws std::exception derived exceptions for malformed messages */
+  jsoncons::json decode(const std::string &message, KuksaChannel::Encoding encoding);
+  /** JSON is encoded without whitespace */
+  std::string encode(const jsoncons::json &message, KuksaChannel::Encoding encoding);
+
+  /** Parts of a subscription notification surrounding the encoded "data"
+   *  member, so that the data can be encoded once for all subscribers */
+  void subscriptionEnvelope(KuksaChannel::Encoding encoding, const std::string &subscriptionId,
+                            std::string &head, std::string &tail);
+}
+
+#endif
@@ -0,0 +1,118 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#ifndef __MPSCRINGBUFFER_HPP__
+#define __MPSCRINGBUFFER_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+/** Bounded lock-free queue for many producers and a single consumer.
+ *
+ *  Every cell carries a sequence number telling whether it is free for the
+ *  producer of a given round or holds data for the consumer (D. Vyukov's
+ *  bounded queue). Producers claim a cell with a CAS on the enqueue position,
+ *  the consumer owns the dequeue position exclusively.
+ */
+template <typename T>
+class MpscRingBuffer {
+  public:
+    /** capacity is rounded up to the next power of two */
+    explicit MpscRingBuffer(size_t capacity) : mask_(roundUp(capacity) - 1),
+        cells_(new Cell[mask_ + 1]), enqueuePos_(0), dequeuePos_(0) {
+      for (size_t i = 0; i <= mask_; i++) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+    MpscRingBuffer(const MpscRingBuffer &) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer &) = delete;
+
+    /** Returns false, and leaves item untouched, if the queue is full.
+     *  May be called from any thread */
+    bool tryPush(T &&item) {
+      size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+      for (;;) {
+        Cell &cell = cells_[pos & mask_];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+          if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+            cell.data = std::move(item);
+            cell.sequence.store(pos + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (diff < 0) {
+          return false;
+        } else {
+          pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /** Returns false if the queue is empty. Consumer thread only */
+    bool tryPop(T &item) {
+      Cell &cell = cells_[dequeuePos_ & mask_];
+      if (cell.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) {
+        return false;
+      }
+      item = std::move(cell.data);
+      cell.data = T();
+      cell.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+      dequeuePos_++;
+      return true;
+    }
+
+    /** Consumer thread only */
+    bool empty() const {
+      return cells_[dequeuePos_ & mask_].sequence.load(std::memory_order_acquire) != dequeuePos_ + 1;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+  private:
+    struct Cell {
+      std::atomic<size_t> sequence;
+      T data;
+    };
+
+    static size_t roundUp(size_t capacity) {
+      if (capacity == 0) {
+        throw std::invalid_argument("MpscRingBuffer capacity must not be 0");
+      }
+      size_t size = 1;
+      while (size < capacity) {
+        size <<= 1;
+      }
+      return size;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    std::atomic<size_t> enqueuePos_;
+    // keep producer and consumer positions on separate cache lines
+    char padding_[64 - sizeof(std::atomic<size_t>)];
+    size_t dequeuePos_;
+};
+
+#endif
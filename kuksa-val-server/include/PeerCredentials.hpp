@@ -0,0 +1,69 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Permissions of clients on the Unix domain socket, by the user running
+ *  them as reported by the kernel (SO_PEERCRED). Users are given by name or
+ *  numeric id, with permissions in the format of the JWT token claims:
+ *
+ *  {
+ *    "gps-feeder": { "kuksa-vss": { "Vehicle.CurrentLocation.*": "rw" } },
+ *    "1001": { "kuksa-vss": { "Vehicle.*": "r" }, "modifyTree": true }
+ *  }
+ */
+
+#ifndef __PEERCREDENTIALS_HPP__
+#define __PEERCREDENTIALS_HPP__
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+#include <jsoncons/json.hpp>
+
+#include "PermissionMatcher.hpp"
+
+class KuksaChannel;
+
+class PeerCredentials {
+  public:
+    /** Throws std::invalid_argument if users is not in the format above */
+    explicit PeerCredentials(const jsoncons::json &users);
+    /** Throws std::runtime_error if the file can not be read */
+    static PeerCredentials fromFile(const std::string &fileName);
+
+    /** Grants the permissions of the user to channel. user is the name of
+     *  the user with id uid, empty if unknown. Returns false if there are
+     *  no permissions for the user */
+    bool authorize(KuksaChannel &channel, uid_t uid, const std::string &user) const;
+
+  private:
+    struct Grant {
+      /// permissions as stored in KuksaChannel
+      std::string permissions;
+      std::shared_ptr<const PermissionMatcher> matcher;
+      bool modifyTree;
+    };
+    std::unordered_map<std::string, Grant> grants_;
+};
+
+#endif
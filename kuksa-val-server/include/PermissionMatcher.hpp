@@ -0,0 +1,111 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#ifndef __PERMISSIONMATCHER_HPP__
+#define __PERMISSIONMATCHER_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+/** The kuksa-vss permissions of a channel, compiled once when they are
+ *  granted. Keys are VSS Gen1 paths, where a path element "*" matches one or
+ *  more path elements and an asterisk within an element matches any part of
+ *  it, e.g. "Vehicle.*" or "Vehicle.Cabin.Door.Row*.IsOpen". A path given
+ *  without asterisk takes precedence, otherwise the last matching pattern in
+ *  key order grants access, as when the patterns were matched as regular
+ *  expressions in turn.
+ *
+ *  Checking a path takes one step per path element and does not allocate,
+ *  plus one walk per "*" in the matching patterns.
+ */
+class PermissionMatcher {
+  public:
+    enum Access : uint8_t {
+      NONE = 0,
+      READ = 1,
+      WRITE = 2
+    };
+
+    /** permissions is an object of paths and "r", "w" or "rw", or such an
+     *  object as JSON string */
+    explicit PermissionMatcher(const jsoncons::json &permissions);
+
+    /** Access granted to the signal at the Gen1 path */
+    uint8_t access(const std::string &path) const;
+    bool allows(const std::string &path, Access required) const {
+      return (access(path) & required) == required;
+    }
+
+  private:
+    /// A path element, referring into the checked path
+    struct Element {
+      const char *data;
+      size_t size;
+    };
+
+    /// Orders elements and keys without copying elements into strings
+    struct ElementLess {
+      using is_transparent = void;
+      bool operator()(const std::string &lh, const std::string &rh) const { return lh < rh; }
+      bool operator()(const std::string &lh, const Element &rh) const { return compare(lh, rh) < 0; }
+      bool operator()(const Element &lh, const std::string &rh) const { return compare(rh, lh) > 0; }
+      static int compare(const std::string &lh, const Element &rh) {
+        int result = std::memcmp(lh.data(), rh.data, std::min(lh.size(), rh.size));
+        if (result != 0) {
+          return result;
+        }
+        return lh.size() < rh.size ? -1 : (lh.size() > rh.size ? 1 : 0);
+      }
+    };
+
+    struct Node {
+      std::map<std::string, std::unique_ptr<Node>, ElementLess> children;
+      /// elements with an asterisk within, e.g. "Row*"
+      std::map<std::string, std::unique_ptr<Node>> globs;
+      /// "*" at this position
+      std::unique_ptr<Node> anyDepth;
+      /// rank of the pattern ending at this node, -1 if there is none
+      int rank = -1;
+      uint8_t access = NONE;
+    };
+
+    struct Match {
+      int rank = -1;
+      uint8_t access = NONE;
+    };
+
+    void insert(const std::string &pattern, int rank, uint8_t access);
+    static void matchNode(const Node &node, const std::string &path, size_t pos, Match &match);
+    /** Returns true if the glob element, with asterisks matching any
+     *  characters, matches element */
+    static bool globMatches(const std::string &glob, const Element &element);
+
+    Node root_;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** REST interface for HTTP clients. Requests are mapped to VISS requests:
+ *
+ *  - GET /vss/<path>[?attribute=targetValue] reads signals (get)
+ *  - GET /vss/<path>?metadata reads metadata (getMetaData)
+ *  - GET /vss?path=<path>&path=<path>... reads several paths at once
+ *  - PUT /vss/<path>[?attribute=targetValue] with a JSON value as body sets
+ *    a signal (set)
+ *
+ *  A GET request accepting "text/event-stream" instead subscribes to the
+ *  paths (subscribe), the notifications are streamed as Server-Sent Events.
+ *
+ *  Paths may be given with "/" or "." as separator. An "Authorization:
+ *  Bearer <token>" header authorizes the connection. GET responses carry an
+ *  ETag derived from the revisions of the signals read, so that pollers
+ *  sending If-None-Match get 304 Not Modified without values being read.
+ */
+
+#ifndef __RESTAPI_HPP__
+#define __RESTAPI_HPP__
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+
+namespace RestApi {
+  struct Request {
+    std::string method;
+    /// request target including query, e.g. "/vss/Vehicle/Speed?attribute=value"
+    std::string target;
+    std::string body;
+    /// values of the If-None-Match and Authorization headers, empty if not sent
+    std::string ifNoneMatch;
+    std::string authorization;
+  };
+
+  struct Response {
+    unsigned status = 200;
+    /// JSON, empty for 204 and 304
+    std::string body;
+    /// quoted entity tag, empty if the response has none
+    std::string etag;
+  };
+
+  /** Processes a VISS request on the connection, see IVssCommandProcessor::processQuery */
+  using QueryHandler = std::function<jsoncons::json(jsoncons::json &request)>;
+  /** Revision tag of a path on the connection, see IVssCommandProcessor::getRevisionTag */
+  using RevisionHandler = std::function<std::string(const std::string &path)>;
+
+  /** Returns true if target is handled by the REST interface */
+  bool isRestTarget(const std::string &target);
+
+  /** token is the one the connection has been authorized with, it is
+   *  updated if the request authorizes with another one */
+  Response handle(const Request &request, const QueryHandler &query,
+                  const RevisionHandler &revision, std::string &token);
+
+  /** Subscribes to the paths of a GET request for an event stream. On
+   *  success, the ids of the new subscriptions are added to subscriptionIds
+   *  and the response has status 200 and no body. Otherwise no subscription
+   *  is left behind */
+  Response subscribe(const Request &request, const QueryHandler &query,
+                     std::string &token, std::vector<std::string> &subscriptionIds);
+
+  /** Splits target into the url decoded VSS path following "/vss/" and the
+   *  query parameters. Returns false if target is not a REST target */
+  bool parseTarget(const std::string &target, std::string &path,
+                   std::multimap<std::string, std::string> &params);
+  /** Token of an Authorization header value, with or without "Bearer " */
+  std::string bearerToken(const std::string &authorization);
+  /** Returns true if the If-None-Match header value lists etag or "*" */
+  bool etagMatches(const std::string &ifNoneMatch, const std::string &etag);
+  /** HTTP status of a VISS response, 200 unless it carries an error */
+  unsigned statusOf(const jsoncons::json &response);
+}
+
+#endif
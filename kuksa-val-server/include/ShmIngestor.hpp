@@ -0,0 +1,120 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#ifndef __SHMINGESTOR_HPP__
+#define __SHMINGESTOR_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/program_options.hpp>
+
+#include "ShmRing.hpp"
+#include "VSSPath.hpp"
+
+class ILogger;
+class IVssDatabase;
+
+/** Applies the values local feeders write to shared memory rings (see
+ *  ShmRing.hpp) to the database, which publishes them to subscribers like
+ *  any other set. One thread drains all rings in batches and sleeps for the
+ *  poll interval whenever they are all empty.
+ */
+class ShmIngestor {
+  public:
+    static constexpr uint32_t DefaultCapacity = 4096;
+    static constexpr uint32_t DefaultSignalCapacity = 256;
+
+    ShmIngestor(std::shared_ptr<ILogger> loggerUtil,
+                std::shared_ptr<IVssDatabase> database,
+                size_t batchSize = 256,
+                std::chrono::microseconds pollInterval = std::chrono::microseconds(200));
+    ~ShmIngestor();
+    ShmIngestor(const ShmIngestor &) = delete;
+    ShmIngestor& operator=(const ShmIngestor &) = delete;
+
+    static boost::program_options::options_description& getOptions();
+
+    /** Creates the ring of a feeder, replacing a stale one left by an
+     *  earlier run. capacity is rounded up to the next power of two. Throws
+     *  std::system_error if the segment can not be created. Must not be
+     *  called after start() */
+    void addFeeder(const std::string &name, uint32_t capacity = DefaultCapacity,
+                   uint32_t signalCapacity = DefaultSignalCapacity);
+
+    void start();
+    void stop();
+
+    /** Applies up to one batch from every ring. Returns the number of
+     *  records taken. Called by the ingestor thread, exposed for tests */
+    size_t drainOnce();
+
+  private:
+    /// Resolution of an entry of the signal table
+    struct Signal {
+      bool resolved = false;
+      /// set if the path exists and is writable
+      boost::optional<VSSPath> path;
+      /// set after a failed set has been logged, until the next one succeeds
+      bool failing = false;
+    };
+
+    /// The feeder can write to the whole segment, so the layout is taken
+    /// from these copies made when creating it, never from the header
+    struct Feeder {
+      std::string name;
+      std::string segment;
+      ShmRing::Header *header = nullptr;
+      size_t size = 0;
+      uint32_t capacity = 0;
+      uint32_t signalCapacity = 0;
+      ShmRing::SignalEntry *signalTable = nullptr;
+      const ShmRing::Record *records = nullptr;
+      /// own copy of the tail, the one in the segment is only published
+      uint64_t tail = 0;
+      /// set after a corrupted head has been logged
+      bool corrupted = false;
+      std::vector<Signal> signals;
+      uint64_t reportedDropped = 0;
+      std::chrono::steady_clock::time_point reportedAt;
+    };
+
+    Signal& resolve(Feeder &feeder, uint32_t id);
+    void apply(Feeder &feeder, const ShmRing::Record &record);
+    void run();
+
+    std::shared_ptr<ILogger> logger_;
+    std::shared_ptr<IVssDatabase> database_;
+    const size_t batchSize_;
+    const std::chrono::microseconds pollInterval_;
+    std::vector<std::unique_ptr<Feeder>> feeders_;
+    std::vector<ShmRing::Record> batch_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,256 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Layout of the POSIX shared memory rings local feeders write signal
+ *  values to, shared by the server (ShmIngestor) and the feeder client
+ *  library.
+ *
+ *  The server creates one segment "/kuksa-feeder-<name>" per configured
+ *  feeder. It starts with a Header, followed by the signal table and the
+ *  record ring:
+ *
+ *  - The signal table holds the VSS paths the feeder writes to. The feeder
+ *    declares a path by appending it to the table, its index is the signal id
+ *    used in records. The server resolves every path once.
+ *  - The ring holds fixed-size records of signal id, type tag, value and
+ *    timestamp. The feeder is the single producer advancing head, the server
+ *    the single consumer advancing tail. If the ring is full the feeder drops
+ *    the value and counts it in dropped, it never waits for the server.
+ */
+
+#ifndef __SHMRING_HPP__
+#define __SHMRING_HPP__
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ShmRing {
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+                "shared memory rings need lock-free atomics");
+
+  constexpr uint32_t Magic = 0x4b534852; // "KSHR"
+  constexpr uint32_t Version = 1;
+  /// including the terminating 0
+  constexpr size_t MaxPathLength = 128;
+  constexpr size_t CacheLine = 64;
+
+  enum class ValueType : uint8_t {
+    Bool = 1,
+    Int64 = 2,
+    UInt64 = 3,
+    Float = 4,
+    Double = 5
+  };
+
+  union Value {
+    bool b;
+    int64_t i64;
+    uint64_t u64;
+    float f;
+    double d;
+  };
+
+  struct Record {
+    uint32_t signal;
+    /// a ValueType
+    uint8_t type;
+    uint8_t reserved[3];
+    /// nanoseconds since the epoch, taken by the feeder. Subscribers and
+    /// getters see it as the timestamp of the value. 0 lets the server stamp
+    /// the value when applying it
+    uint64_t timestampNs;
+    Value value;
+  };
+  static_assert(sizeof(Record) == 24, "record layout must not depend on the compiler");
+
+  struct SignalEntry {
+    char path[MaxPathLength];
+  };
+
+  struct Header {
+    /// written last by the server, when the segment is ready
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    /// number of records, a power of two
+    uint32_t capacity;
+    /// number of entries of the signal table
+    uint32_t signalCapacity;
+    /// number of declared signals, entries below are complete
+    std::atomic<uint32_t> signalCount;
+    /// process id of the attached feeder, 0 if there is none
+    std::atomic<int32_t> producer;
+
+    /// written by the feeder
+    alignas(CacheLine) std::atomic<uint64_t> head;
+    std::atomic<uint64_t> dropped;
+    /// written by the server
+    alignas(CacheLine) std::atomic<uint64_t> tail;
+  };
+
+  inline size_t segmentSize(uint32_t capacity, uint32_t signalCapacity) {
+    return sizeof(Header) + signalCapacity * sizeof(SignalEntry) + capacity * sizeof(Record);
+  }
+
+  inline SignalEntry* signals(Header *header) {
+    return reinterpret_cast<SignalEntry*>(reinterpret_cast<char*>(header) + sizeof(Header));
+  }
+
+  inline Record* records(Header *header) {
+    return reinterpret_cast<Record*>(reinterpret_cast<char*>(signals(header)) +
+                                     header->signalCapacity * sizeof(SignalEntry));
+  }
+
+  /** Name of the shared memory object of a feeder */
+  inline std::string segmentName(const std::string &feeder) {
+    if (feeder.empty() || feeder.size() > 200 || feeder.find('/') != std::string::npos) {
+      throw std::invalid_argument("Invalid feeder name '" + feeder + "'");
+    }
+    return "/kuksa-feeder-" + feeder;
+  }
+
+  /** Feeder side of a ring. Not thread safe, a ring has a single producer */
+  class Producer {
+    public:
+      /** Attaches to the ring the server created for feeder. Throws
+       *  std::system_error if there is none, std::runtime_error if it is
+       *  incompatible or another feeder is attached */
+      explicit Producer(const std::string &feeder) {
+        int fd = shm_open(segmentName(feeder).c_str(), O_RDWR, 0);
+        if (fd < 0) {
+          throw std::system_error(errno, std::generic_category(), "Cannot open ring of feeder " + feeder);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+          close(fd);
+          throw std::runtime_error("Ring of feeder " + feeder + " is not initialized");
+        }
+        size_ = st.st_size;
+        void *mapping = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int error = errno;
+        close(fd);
+        if (mapping == MAP_FAILED) {
+          throw std::system_error(error, std::generic_category(), "Cannot map ring of feeder " + feeder);
+        }
+        header_ = static_cast<Header*>(mapping);
+
+        if (header_->magic.load(std::memory_order_acquire) != Magic || header_->version != Version ||
+            segmentSize(header_->capacity, header_->signalCapacity) != size_) {
+          unmap();
+          throw std::runtime_error("Ring of feeder " + feeder + " has an incompatible layout");
+        }
+        int32_t self = getpid();
+        int32_t attached = 0;
+        while (!header_->producer.compare_exchange_weak(attached, self, std::memory_order_acq_rel)) {
+          // take over the ring of a feeder that has died without detaching
+          if (attached != 0 && (attached == self || kill(attached, 0) == 0 || errno != ESRCH)) {
+            unmap();
+            throw std::runtime_error("Another feeder is attached to the ring of " + feeder);
+          }
+        }
+        mask_ = header_->capacity - 1;
+        records_ = records(header_);
+        head_ = header_->head.load(std::memory_order_relaxed);
+        tail_ = header_->tail.load(std::memory_order_acquire);
+      }
+      Producer(const Producer &) = delete;
+      Producer& operator=(const Producer &) = delete;
+
+      ~Producer() {
+        int32_t self = getpid();
+        header_->producer.compare_exchange_strong(self, 0, std::memory_order_acq_rel);
+        unmap();
+      }
+
+      /** Returns the signal id of path, declaring it if needed. Throws
+       *  std::invalid_argument if path is too long, std::length_error if the
+       *  signal table is full */
+      uint32_t signal(const std::string &path) {
+        if (path.empty() || path.size() >= MaxPathLength) {
+          throw std::invalid_argument("Invalid path '" + path + "'");
+        }
+        SignalEntry *table = signals(header_);
+        uint32_t count = header_->signalCount.load(std::memory_order_relaxed);
+        for (uint32_t id = 0; id < count; id++) {
+          if (path == table[id].path) {
+            return id;
+          }
+        }
+        if (count >= header_->signalCapacity) {
+          throw std::length_error("Signal table of the ring is full");
+        }
+        std::memset(table[count].path, 0, MaxPathLength);
+        std::memcpy(table[count].path, path.data(), path.size());
+        header_->signalCount.store(count + 1, std::memory_order_release);
+        return count;
+      }
+
+      /** Appends a value. Returns false, and counts the value as dropped, if
+       *  the ring is full */
+      bool push(uint32_t signal, ValueType type, Value value, uint64_t timestampNs) {
+        if (head_ - tail_ > mask_) {
+          tail_ = header_->tail.load(std::memory_order_acquire);
+          if (head_ - tail_ > mask_) {
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+        }
+        Record &record = records_[head_ & mask_];
+        record.signal = signal;
+        record.type = static_cast<uint8_t>(type);
+        record.timestampNs = timestampNs;
+        record.value = value;
+        header_->head.store(++head_, std::memory_order_release);
+        return true;
+      }
+
+      uint64_t dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+      uint32_t capacity() const { return mask_ + 1; }
+
+    private:
+      void unmap() {
+        munmap(header_, size_);
+        header_ = nullptr;
+      }
+
+      Header *header_ = nullptr;
+      size_t size_ = 0;
+      Record *records_ = nullptr;
+      uint32_t mask_ = 0;
+      /// own copy of head and last tail seen, so that the shared tail is
+      /// only read when the ring looks full
+      uint64_t head_ = 0;
+      uint64_t tail_ = 0;
+  };
+}
+
+#endif
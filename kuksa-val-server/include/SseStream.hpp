@@ -0,0 +1,134 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Server-Sent Events streams of subscription notifications for HTTP
+ *  clients. A stream is a connection of its own, owning the subscriptions
+ *  made for it, so that it outlives the HTTP connection it is sent on.
+ *  Every event carries the id "<stream name>-<sequence number>". When a
+ *  client reconnects with that id as Last-Event-ID within the resume timeout,
+ *  it gets the events it missed from the replay buffer and the stream goes
+ *  on, without subscribing again.
+ */
+
+#ifndef __SSESTREAM_HPP__
+#define __SSESTREAM_HPP__
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ConnectionRegistry.hpp"
+#include "IServer.hpp"
+
+class ISubscriptionHandler;
+
+class SseStream : public IConnection {
+  public:
+    /** Delivers an event to the connection the stream is sent on */
+    using Sink = std::function<void(std::shared_ptr<const std::string> event)>;
+
+    SseStream(const std::string &name, size_t replayCapacity,
+              std::chrono::steady_clock::duration resumeTimeout);
+
+    const std::string& name() const { return name_; }
+    /// Id in the connection registry, 0 if not registered
+    ConnectionId connID() const { return connID_; }
+
+    /** Formats message as event, keeps it for replay and passes it to the
+     *  sink. Returns false if the stream has been detached for longer than
+     *  the resume timeout, its subscriptions should be removed then */
+    bool publish(const OutboundMessage &message);
+    bool send(const OutboundMessage &message) override { return publish(message); }
+    /** Sends events from now on to sink, after replaying the events newer
+     *  than sequence number lastSeen. A sink attached before is replaced.
+     *  Returns the number to pass to detach */
+    uint64_t attach(Sink sink, uint64_t lastSeen);
+    /** Stops sending to the sink of the given attach call, if it has not
+     *  been replaced yet */
+    void detach(uint64_t attachment);
+    bool expired(std::chrono::steady_clock::time_point now) const;
+
+    /// Token the subscriptions have been authorized with
+    std::string token;
+    /// Ids of the subscriptions made for the stream
+    std::vector<std::string> subscriptionIds;
+
+  private:
+    friend class SseStreamRegistry;
+
+    const std::string name_;
+    ConnectionId connID_ = 0;
+    const size_t replayCapacity_;
+    const std::chrono::steady_clock::duration resumeTimeout_;
+
+    mutable std::mutex mutex_;
+    uint64_t lastSeq_ = 0;
+    std::deque<std::pair<uint64_t, std::shared_ptr<const std::string>>> replay_;
+    Sink sink_;
+    uint64_t attachment_ = 0;
+    std::chrono::steady_clock::time_point detachedAt_;
+};
+
+/** All streams that are sent or may still be resumed. Streams are
+ *  registered as connections in connections */
+class SseStreamRegistry {
+  public:
+    explicit SseStreamRegistry(ConnectionRegistry &connections);
+
+    void configure(size_t replayCapacity, std::chrono::steady_clock::duration resumeTimeout);
+    /** Handler the subscriptions of expired or removed streams are removed
+     *  from */
+    void setSubscriptionHandler(std::weak_ptr<ISubscriptionHandler> subHandler);
+    std::chrono::steady_clock::duration resumeTimeout();
+
+    /** Creates a new stream */
+    std::shared_ptr<SseStream> create();
+    /** Returns the stream an event id (Last-Event-ID) belongs to, if it can
+     *  still be resumed, and the sequence number of that event */
+    std::shared_ptr<SseStream> resume(const std::string &lastEventId, uint64_t &lastSeen);
+    void remove(const std::shared_ptr<SseStream> &stream);
+    /** Drops the streams that can not be resumed anymore, together with
+     *  their subscriptions. Returns the number of dropped streams */
+    size_t removeExpired();
+
+    /** Splits an event id into stream name and sequence number */
+    static bool parseEventId(const std::string &eventId, std::string &name, uint64_t &seq);
+
+  private:
+    /// Removes the subscriptions of streams that have been dropped, must
+    /// not be called with mutex_ held
+    void unsubscribe(const std::vector<std::shared_ptr<SseStream>> &streams);
+
+    ConnectionRegistry &connections_;
+    std::weak_ptr<ISubscriptionHandler> subHandler_;
+    std::mutex mutex_;
+    size_t replayCapacity_;
+    std::chrono::steady_clock::duration resumeTimeout_;
+    std::unordered_map<std::string, std::shared_ptr<SseStream>> byName_;
+};
+
+#endif
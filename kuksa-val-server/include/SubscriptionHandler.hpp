@@ -22,16 +22,21 @@
 #ifndef __SUBSCRIPTIONHANDLER_H__
 #define __SUBSCRIPTIONHANDLER_H__
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
+#include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <thread>
 #include <memory>
+#include <vector>
 
 #include <boost/uuid/uuid.hpp> 
 #include <boost/functional/hash.hpp>
+#include <boost/program_options.hpp>
 
 #include <jsoncons/json.hpp>
 
@@ -42,6 +47,10 @@
 #include "IServer.hpp"
 #include "IPublisher.hpp"
 #include "VSSPath.hpp"
+#include "MpscRingBuffer.hpp"
+#include "SubscriptionTrie.hpp"
+#include "kuksa.pb.h"
+#include "kuksa/val/v1/val.pb.h"
 
 class AccessChecker;
 class Authenticator;
@@ -61,52 +70,128 @@ struct UUIDHasher
     return (uuid_hasher(k));
   }
 };
-using subscriptions_t = std::unordered_map<SubscriptionId, KuksaChannel, UUIDHasher>;
 using subscription_keys_t = struct subscription_keys {
   std::string path;
   std::string attribute;
+  // computed once, keys are hashed on every lookup
+  std::size_t hash;
 
   // constructor
   subscription_keys(std::string path, std::string attr) {
       this->path = path;
       this->attribute = attr;
+      this->hash = std::hash<std::string>()(this->path);
+      boost::hash_combine(this->hash, this->attribute);
   }
 
   // Equal operator
   bool operator==(const subscription_keys &p) const {
-      return this->path == p.path && this->attribute == p.attribute;
+      return this->hash == p.hash && this->path == p.path && this->attribute == p.attribute;
   }
 };
 
 struct SubscriptionKeyHasher {
   std::size_t operator() (const subscription_keys_t& key) const {
-    return (std::hash<VSSPath>()(VSSPath::fromVSS(key.path)) ^ std::hash<std::string>()(key.attribute));
+    return key.hash;
   }
 };
 
 class SubscriptionHandler : public ISubscriptionHandler {
+ public:
+  static constexpr size_t DefaultQueueSize = 4096;
+
  private:
-  std::unordered_map<subscription_keys_t, subscriptions_t, SubscriptionKeyHasher> subscriptions;
+  /** A value update, serialized once for all subscribers of the signal */
+  struct PreparedUpdate {
+    /// "data" member of VISS subscription notifications, per encoding used
+    /// by Web-Socket subscribers (indexed by KuksaChannel::Encoding)
+    std::array<std::shared_ptr<const std::string>, 3> bodies;
+    /// notification for gRPC subscribers, it does not differ per subscription
+    kuksa::SubscribeResponse grpcResponse;
+    /// update for kuksa.val.v1 subscribers
+    kuksa::val::v1::EntryUpdate valUpdate;
+  };
+
+  /** A value update to be sent to one subscriber */
+  struct Notification {
+    SubscriptionId subId;
+    KuksaChannel channel;
+    std::shared_ptr<const PreparedUpdate> update;
+  };
+
+  /** Dispatch worker. All notifications for one connection are queued to the
+   *  same worker, so they are sent in the order they have been published */
+  struct Worker {
+    explicit Worker(size_t queueSize) : queue(queueSize), sleeping(false) {}
+
+    MpscRingBuffer<Notification> queue;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    /// set while the worker waits for wakeup
+    std::atomic<bool> sleeping;
+  };
+
+  /// Where a subscription is stored in subscriptions
+  struct SubscriptionLocation {
+    std::string attribute;
+    std::vector<std::string> pattern;
+    uint64_t connID;
+  };
+
+  /// Subscriptions per attribute, organized by subscribed path pattern
+  std::unordered_map<std::string, SubscriptionTrie> subscriptions;
+  /// Reverse indexes, so that unsubscribing only touches the subscriptions
+  /// concerned
+  std::unordered_map<SubscriptionId, SubscriptionLocation, UUIDHasher> subscriptionLocations_;
+  std::unordered_map<uint64_t, std::unordered_set<SubscriptionId, UUIDHasher>> connectionSubscriptions_;
   std::shared_ptr<ILogger> logger;
   std::shared_ptr<IServer> server;
   std::vector<std::shared_ptr<IPublisher>> publishers_;
   std::shared_ptr<IAuthenticator> validator;
   std::shared_ptr<IAccessChecker> checkAccess;
-  mutable std::mutex subMutex;
-  mutable std::mutex accessMutex;
-  std::condition_variable c;
-  std::thread subThread;
-  bool threadRun;
-  //Tuple is UUID, channel object, vss datatye and jsoncons object for value
-  std::queue<std::tuple<SubscriptionId, KuksaChannel, std::string, jsoncons::json>> buffer;
+  /// Guards subscriptions. Publishing only needs shared access
+  mutable std::shared_timed_mutex accessMutex;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> threadRun;
+  /// Notifications dropped because the queue of a worker was full
+  std::atomic<uint64_t> dropped_;
+  /// Revision of the last update enqueued per signal path and attribute.
+  /// Sets of a signal are published concurrently, an update overtaken by a
+  /// newer one of the same attribute is dropped
+  std::mutex revisionMutex_;
+  std::unordered_map<subscription_keys_t, uint64_t, SubscriptionKeyHasher> publishedRevisions_;
+
+  /** Returns false if an update with a newer revision has been published for
+   *  attr of path already. revisionMutex_ is held */
+  bool claimRevision(const std::string& path, const std::string& attr, uint64_t revision);
+
+  Worker& workerFor(const KuksaChannel& channel);
+  /** Serializes the update for the subscribers of path once. accessMutex is
+   *  held */
+  void prepareNotifications(const VSSPath& path, const std::string& vssdatatype,
+                            const std::string& attr, const jsoncons::json& data,
+                            const std::string& description,
+                            std::vector<Notification>& notifications);
+  void enqueue(Notification &&notification);
+  void workerRunner(Worker& worker);
+  void sendNotification(const Notification& notification);
+  /// Removes a subscription from subscriptions, caller holds accessMutex
+  void removeSubscription(const SubscriptionId& subId, const SubscriptionLocation& location);
 
  public:
+  /** workers: number of dispatch threads, 0 for one per CPU core.
+   *  queueSize: number of notifications each worker can hold */
   SubscriptionHandler(std::shared_ptr<ILogger> loggerUtil,
                       std::shared_ptr<IServer> wserver,
                       std::shared_ptr<IAuthenticator> authenticate,
-                      std::shared_ptr<IAccessChecker> checkAccess);
+                      std::shared_ptr<IAccessChecker> checkAccess,
+                      unsigned workers = 1,
+                      size_t queueSize = DefaultQueueSize);
   ~SubscriptionHandler();
 
+  static boost::program_options::options_description& getOptions();
+
   void addPublisher(std::shared_ptr<IPublisher> publisher){
     publishers_.push_back(publisher);
   }
@@ -115,13 +200,13 @@ class SubscriptionHandler : public ISubscriptionHandler {
                            const std::string &path, const std::string& attr);
   int unsubscribe(SubscriptionId subscribeID);
   int unsubscribeAll(KuksaChannel channel);
-  int publishForVSSPath(const VSSPath path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json &value);
+  int publishForVSSPath(const VSSPath path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json &value, uint64_t revision = 0);
 
 
   std::shared_ptr<IServer> getServer();
   int startThread();
   int stopThread();
   bool isThreadRunning() const;
-  void* subThreadRunner();
+  uint64_t droppedNotifications() const { return dropped_.load(std::memory_order_relaxed); }
 };
 #endif
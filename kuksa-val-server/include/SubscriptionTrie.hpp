@@ -0,0 +1,97 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#ifndef __SUBSCRIPTIONTRIE_HPP__
+#define __SUBSCRIPTIONTRIE_HPP__
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ISubscriptionHandler.hpp"
+#include "KuksaChannel.hpp"
+
+/** Subscriptions organized by the path pattern they have been made for, using
+ *  the matching rules of doc/wildcard_matching.md:
+ *
+ *  - a pattern without asterisk matches the signal with that path and all
+ *    signals below the branch with that path, "" matches everything
+ *  - "*" matches exactly one path element
+ *  - "**" matches zero or more path elements, at the end of a pattern one or more
+ *
+ *  Patterns are given as list of path elements. Finding the subscriptions for
+ *  a signal takes one step per path element, plus one walk per "**" in
+ *  subscribed patterns.
+ */
+class SubscriptionTrie {
+  public:
+    struct Entry {
+      SubscriptionId id;
+      KuksaChannel channel;
+      /// true unless subscribed to a single signal. Access rights have to be
+      /// checked for every signal such a subscription is notified about
+      bool isPattern;
+    };
+
+    void insert(const std::vector<std::string> &pattern, Entry entry);
+    /** Removes the subscription id inserted for pattern, only visiting the
+     *  nodes along pattern. Returns false if there is no such entry */
+    bool remove(const std::vector<std::string> &pattern, const SubscriptionId &id);
+    /** Adds all entries matching the signal path to matches, each of them
+     *  once. Pointers stay valid until the trie is modified */
+    void match(const std::vector<std::string> &path, std::vector<const Entry*> &matches) const;
+    bool empty() const;
+
+    /** Splits a Gen2 VSS path into its elements, "" has no elements */
+    static std::vector<std::string> split(const std::string &vssPath);
+    static bool hasWildcard(const std::vector<std::string> &pattern);
+    /** Returns true if pattern matches signal path */
+    static bool matches(const std::vector<std::string> &pattern, const std::vector<std::string> &path);
+
+  private:
+    struct Node {
+      std::unordered_map<std::string, std::unique_ptr<Node>> children;
+      /// "*" at this position
+      std::unique_ptr<Node> anyChild;
+      /// "**" at this position, followed by further path elements
+      std::unique_ptr<Node> anyDepth;
+      /// subscriptions matching the signal at this node
+      std::vector<Entry> exact;
+      /// subscriptions matching the signal at this node and all below
+      std::vector<Entry> subtree;
+      /// subscriptions matching all signals below this node
+      std::vector<Entry> below;
+
+      bool empty() const;
+    };
+
+    static void matchNode(const Node &node, const std::vector<std::string> &path, size_t pos,
+                          std::vector<const Entry*> &matches);
+    static bool removeAt(Node &node, const std::vector<std::string> &pattern, size_t pos,
+                         const SubscriptionId &id);
+    static bool matchesFrom(const std::vector<std::string> &pattern, size_t patternPos,
+                            const std::vector<std::string> &path, size_t pathPos);
+
+    Node root_;
+};
+
+#endif
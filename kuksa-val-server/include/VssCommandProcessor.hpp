@@ -67,6 +67,10 @@ class VssCommandProcessor : public IVssCommandProcessor {
   ~VssCommandProcessor();
 
   jsoncons::json processQuery(const std::string &req_json, KuksaChannel& channel);
+  jsoncons::json processQuery(jsoncons::json &request, KuksaChannel& channel);
+  std::string getRevisionTag(KuksaChannel& channel, const std::string &path);
+  /** Access checker of requests, for protocols bypassing the JSON processing */
+  std::shared_ptr<IAccessChecker> getAccessChecker() const { return accessValidator_; }
 };
 
 #endif
@@ -24,13 +24,16 @@
 
 #include <string>
 #include <list>
+#include <atomic>
 #include <mutex>
 #include <memory>
+#include <unordered_map>
 
 #include <jsoncons/json.hpp>
 
 #include "IVssDatabase.hpp"
 #include "VSSPath.hpp"
+#include "VssValueStore.hpp"
 
 class IAccessChecker;
 class ISubscriptionHandler;
@@ -43,9 +46,37 @@ class VssDatabase : public IVssDatabase {
 
  private:
   std::shared_ptr<ILogger> logger_;
-  std::mutex rwMutex_;
   std::shared_ptr<ISubscriptionHandler> subHandler_;
 
+  struct PathIndexEntry {
+    const jsoncons::json* node;
+    VssValueStore::SignalId id;
+    /// Value type of the datatype of node, NONE for branches
+    VssValue::Type type;
+  };
+
+  /** Immutable version of the VSS tree together with its path index. Tree
+   *  updates build a new model next to the current one and publish it by
+   *  swapping model_, so readers never wait for an update.
+   */
+  struct VssModel {
+    jsoncons::json tree;
+    /// Maps the Gen2 VSS path of every node in tree to the node itself and
+    /// the id of its value slot
+    std::unordered_map<std::string, PathIndexEntry> index;
+  };
+
+  /// Current model. Only to be accessed through std::atomic_load/atomic_store
+  std::shared_ptr<const VssModel> model_;
+  /// Serializes tree updates, readers never take it
+  std::mutex updateMutex_;
+  /// Signal ids ever handed out. Ids stay the same when the tree is updated,
+  /// so values survive tree updates. Guarded by updateMutex_
+  std::unordered_map<std::string, VssValueStore::SignalId> signalIds_;
+  VssValueStore values_;
+  /// Incremented after every published model
+  std::atomic<uint64_t> treeRevision_;
+
  public:
   VssDatabase(std::shared_ptr<ILogger> loggerUtil,
               std::shared_ptr<ISubscriptionHandler> subHandle);
@@ -61,10 +92,22 @@ class VssDatabase : public IVssDatabase {
 
   std::list<VSSPath> getLeafPaths(const VSSPath& path) override;
 
-  void checkAndSanitizeType(jsoncons::json &meta, jsoncons::json &val) override;
+  VssRevision getRevision(const VSSPath &path) override;
+
+  void checkAndSanitizeType(const jsoncons::json &meta, jsoncons::json &val) override;
+  /** Native counterpart of checkAndSanitizeType: returns val converted to
+   *  type, the value type of the datatype of meta, or throws
+   *  outOfBoundException if it does not fit */
+  VssValue sanitizeValue(const jsoncons::json &meta, VssValue::Type type, const VssValue &val);
 
 
   void initJsonTree(const boost::filesystem::path &fileName) override;
+  /** Initializes the database from a tree returned by getCompiledTree(), i.e.
+   *  one that already has all overlays and default values applied */
+  void initCompiledTree(jsoncons::json tree);
+  /** Returns the current tree including the values applied at startup
+   *  (defaults), so it can be cached and passed to initCompiledTree() later */
+  jsoncons::json getCompiledTree();
   
   bool checkPathValid(const VSSPath& path);
   static bool isActor(const jsoncons::json &element);
@@ -76,9 +119,13 @@ class VssDatabase : public IVssDatabase {
   void updateJsonTree(KuksaChannel& channel, jsoncons::json& value) override;
   void updateMetaData(KuksaChannel& channel, const VSSPath& path, const jsoncons::json& newTree) override;
   jsoncons::json getMetaData(const VSSPath& path) override;
+  jsoncons::json getNodeMetaData(const VSSPath& path) override;
   
   jsoncons::json setSignal(const VSSPath &path, const std::string& attr, jsoncons::json &value) override; //gen2 version
   jsoncons::json getSignal(const VSSPath &path, const std::string& attr, bool as_string=false) override; //Gen2 version
+  void setSignalValue(const VSSPath &path, const std::string& attr, const VssValue &value,
+                      uint64_t timestampNs = 0) override;
+  VssValueSlot getSignalValue(const VSSPath &path, const std::string& attr) override;
 
   void applyDefaultValues(jsoncons::json &tree, VSSPath currentPath);
 
@@ -86,5 +133,14 @@ class VssDatabase : public IVssDatabase {
 
     void checkArrayType(std::string& subdatatype, jsoncons::json &val);
 
+    std::shared_ptr<const VssModel> currentModel() const;
+    void publishModel(std::shared_ptr<VssModel> model);
+    void indexNode(VssModel &model, jsoncons::json &node, const std::string &vssPath);
+    void embedStartupValues(jsoncons::json &node, const std::string &vssPath);
+    const PathIndexEntry* findNode(const VssModel &model, const VSSPath &path, size_t &matches) const;
+    void collectLeafPaths(const jsoncons::json &node, const std::string &jsonPath,
+                          bool gen1, std::list<VSSPath> &paths);
+    static bool isWildcardPath(const VSSPath &path);
+
 };
 #endif
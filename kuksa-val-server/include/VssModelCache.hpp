@@ -0,0 +1,65 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Binary cache of the compiled VSS model (main VSS file with all overlays
+ *  and defaults applied), so that startup does not need to parse and merge
+ *  JSON files again as long as none of them changed.
+ *
+ *  The cache file consists of a fixed header followed by the model tree
+ *  encoded as CBOR. The header carries a content hash of all model input
+ *  files, a cache with a different hash is considered stale.
+ */
+
+#ifndef __VSSMODELCACHE_HPP__
+#define __VSSMODELCACHE_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <jsoncons/json.hpp>
+
+class ILogger;
+
+class VssModelCache {
+  public:
+    VssModelCache(std::shared_ptr<ILogger> logger, const boost::filesystem::path &cacheDir);
+
+    /** FNV-1a hash over the content of all files, in the given order.
+     *  Throws std::runtime_error if a file can not be read */
+    static uint64_t hashFiles(const std::vector<boost::filesystem::path> &files);
+
+    /** Loads the cached model into tree. Returns false if there is no cache,
+     *  or it is corrupt or has been created from other input files */
+    bool load(uint64_t contentHash, jsoncons::json &tree);
+    /** Writes tree as cache for contentHash, replacing any existing cache.
+     *  Failures are logged but not fatal, the server works without cache */
+    void store(uint64_t contentHash, const jsoncons::json &tree);
+
+    const boost::filesystem::path& cacheFile() const { return cacheFile_; }
+
+  private:
+    std::shared_ptr<ILogger> logger_;
+    boost::filesystem::path cacheFile_;
+};
+
+#endif
@@ -0,0 +1,200 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Storage for signal values, kept separate from the VSS metadata tree.
+ *  Every signal gets a numeric id when the tree is indexed, its values are
+ *  kept as native (tagged) values in the slot with that id.
+ */
+
+#ifndef __VSSVALUESTORE_HPP__
+#define __VSSVALUESTORE_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+
+class VssValue {
+  public:
+    enum class Type : uint8_t {
+      NONE,
+      UINT8,
+      INT8,
+      UINT16,
+      INT16,
+      UINT32,
+      INT32,
+      UINT64,
+      INT64,
+      FLOAT,
+      DOUBLE,
+      BOOLEAN,
+      STRING,
+      ARRAY
+    };
+
+    VssValue();
+
+    /** Create value from json, deriving the type from how jsoncons stores it */
+    static VssValue fromJson(const jsoncons::json &val);
+    /** Create value from json, that already has been sanitized for type */
+    static VssValue fromJson(const jsoncons::json &val, Type type);
+    /** Create value from a native one, e.g. as received by gRPC. Integer
+     *  types may be narrower than the argument, callers check the range */
+    static VssValue fromUInt64(uint64_t val, Type type = Type::UINT64);
+    static VssValue fromInt64(int64_t val, Type type = Type::INT64);
+    static VssValue fromFloat(float val);
+    static VssValue fromDouble(double val);
+    static VssValue fromBool(bool val);
+    static VssValue fromString(std::string val);
+    static VssValue fromArray(std::vector<VssValue> val);
+    /** Map a VSS datatype ("uint8", "string[]", ...) to a value type */
+    static Type typeFromDatatype(const std::string &datatype);
+
+    jsoncons::json toJson() const;
+    /** String representation as used in VISS responses */
+    std::string toString() const;
+
+    Type type() const { return type_; }
+    bool isSet() const { return type_ != Type::NONE; }
+    bool isUnsigned() const;
+    bool isSigned() const;
+
+    bool operator==(const VssValue &other) const;
+    bool operator!=(const VssValue &other) const { return !(*this == other); }
+
+    uint64_t asUInt64() const { return num_.u; }
+    int64_t asInt64() const { return num_.i; }
+    float asFloat() const { return num_.f; }
+    double asDouble() const { return num_.d; }
+    bool asBool() const { return num_.b; }
+    const std::string& asString() const { return str_; }
+    const std::vector<VssValue>& asArray() const { return array_; }
+
+  private:
+    Type type_;
+    union {
+      uint64_t u;
+      int64_t i;
+      float f;
+      double d;
+      bool b;
+    } num_;
+    std::string str_;
+    std::vector<VssValue> array_;
+};
+
+/** Reader/writer spin lock guarding a single signal slot. Critical sections
+ *  only copy a value in or out, so spinning is cheaper than a mutex and
+ *  readers of the same signal never block each other.
+ *  Usable with std::shared_lock and std::unique_lock
+ */
+class VssSlotLock {
+  public:
+    VssSlotLock() : state_(0) {}
+    VssSlotLock(const VssSlotLock &) = delete;
+    VssSlotLock& operator=(const VssSlotLock &) = delete;
+
+    void lock_shared() {
+      for (;;) {
+        int32_t state = state_.load(std::memory_order_relaxed);
+        if (state >= 0 &&
+            state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+          return;
+        }
+        std::this_thread::yield();
+      }
+    }
+    void unlock_shared() { state_.fetch_sub(1, std::memory_order_release); }
+
+    void lock() {
+      for (;;) {
+        int32_t unlocked = 0;
+        if (state_.compare_exchange_weak(unlocked, -1, std::memory_order_acquire)) {
+          return;
+        }
+        std::this_thread::yield();
+      }
+    }
+    void unlock() { state_.store(0, std::memory_order_release); }
+
+  private:
+    /// number of readers, -1 if held by a writer
+    std::atomic<int32_t> state_;
+};
+
+/** A single attribute (value or targetValue) of a signal */
+struct VssValueSlot {
+  VssValue value;
+  uint64_t ts_s = 0;
+  uint32_t ts_ns = 0;
+};
+
+struct VssSignalSlot {
+  VssValueSlot value;
+  VssValueSlot targetValue;
+  /// Incremented whenever value or targetValue changes
+  uint64_t revision = 0;
+  mutable VssSlotLock lock;
+
+  /** Returns the slot holding attr, or nullptr if attr can not be stored */
+  VssValueSlot* attribute(const std::string &attr);
+};
+
+/** Value slots of all signals. Slots are allocated in chunks that never
+ *  move, so the store can grow while other threads access existing slots.
+ */
+class VssValueStore {
+  public:
+    typedef uint32_t SignalId;
+    static constexpr SignalId NoSignal = std::numeric_limits<SignalId>::max();
+
+    VssValueStore();
+    ~VssValueStore();
+    VssValueStore(const VssValueStore &) = delete;
+    VssValueStore& operator=(const VssValueStore &) = delete;
+
+    /** Grow store to hold count signals. Existing slots are kept in place.
+     *  Must not be called concurrently with itself */
+    void resize(size_t count);
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    /** Reset all slots to not set */
+    void clear();
+
+    VssSignalSlot& operator[](SignalId id) {
+      return chunks_[id >> ChunkBits].load(std::memory_order_acquire)[id & (ChunkSize - 1)];
+    }
+
+  private:
+    static constexpr size_t ChunkBits = 10;
+    static constexpr size_t ChunkSize = 1 << ChunkBits;
+    static constexpr size_t MaxChunks = 1024;
+
+    std::array<std::atomic<VssSignalSlot*>, MaxChunks> chunks_;
+    std::atomic<size_t> size_;
+};
+
+#endif
@@ -25,13 +25,54 @@
 #include "IServer.hpp"
 #include "KuksaChannel.hpp"
 
+#include <boost/asio/io_context.hpp>
 #include <boost/asio/ssl/context.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
 #include <vector>
 #include <string>
 #include <mutex>
 #include <memory>
 
 class ILogger;
+class ISubscriptionHandler;
+
+/**
+ * \enum SlowConsumerPolicy
+ * \brief What a Web-Socket session does with subscription updates once the
+ *        client has more of them pending than the configured queue depth
+ */
+enum class SlowConsumerPolicy {
+  CONFLATE,     //!< Replace a pending update of the same subscription, else drop the oldest
+  DROP_OLDEST,  //!< Drop the oldest pending update
+  DISCONNECT    //!< Close the connection
+};
+
+/**
+ * \struct OutboundQueueStats
+ * \brief Counters of subscription updates not sent due to slow clients
+ */
+struct OutboundQueueStats {
+  uint64_t dropped;       //!< updates dropped
+  uint64_t conflated;     //!< updates replaced by a newer value of the same subscription
+  uint64_t disconnected;  //!< connections closed
+};
+
+/**
+ * \struct CompressionStats
+ * \brief Counters of Web-Socket messages sent with permessage-deflate.
+ *        Compressed sizes are not known for every message, a sample of the
+ *        messages is compressed once more to measure them. The compression
+ *        ratio is sampledCompressedBytes / sampledBytes, the CPU time spent on
+ *        compression about sampledNanoseconds * bytes / sampledBytes
+ */
+struct CompressionStats {
+  uint64_t messages;                //!< messages compressed
+  uint64_t bytes;                   //!< uncompressed size of these messages
+  uint64_t sampledBytes;            //!< uncompressed size of sampled messages
+  uint64_t sampledCompressedBytes;  //!< compressed size of sampled messages
+  uint64_t sampledNanoseconds;      //!< time spent compressing sampled messages
+};
 
 /**
  * \class WebSockHttpFlexServer
@@ -47,8 +88,14 @@ class WebSockHttpFlexServer : public IServer {
 
     bool isInitialized = false;
 
-    const uint8_t NumOfThreads = 1;
-    boost::asio::io_context ioc_;
+    /// Number of threads running I/O, 0 for one per CPU core
+    unsigned ioThreads_ = 1;
+    /// Give each I/O thread its own io_context and listening socket
+    bool ioContextPerThread_ = false;
+    /// Bind each I/O thread to one CPU core
+    bool pinIoThreads_ = false;
+    /// One io_context shared by all I/O threads, or one per thread
+    std::vector<std::unique_ptr<boost::asio::io_context>> iocs_;
 
     /// Default name for server certificate file
     static const std::string serverCertFilename_;
@@ -69,10 +116,89 @@ class WebSockHttpFlexServer : public IServer {
      * @return Response JSON message for client
      */
     std::string HandleRequest(const std::string &req_json, KuksaChannel &channel);
+    /**
+     * @brief Handle revision requests for conditional REST requests
+     * @param path VSS path
+     * @param channel Connection identifier
+     * @return Revision tag, empty if not available
+     */
+    std::string HandleRevisionRequest(const std::string &path, KuksaChannel &channel);
   public:
     WebSockHttpFlexServer(std::shared_ptr<ILogger> loggerUtil);
+    WebSockHttpFlexServer(std::shared_ptr<ILogger> loggerUtil,
+                          const boost::program_options::variables_map &config);
     ~WebSockHttpFlexServer();
 
+    static boost::program_options::options_description& getOptions();
+
+    /**
+     * @brief Configure how many subscription updates may be pending per
+     *        Web-Socket connection, and what happens if a client exceeds that
+     */
+    void SetOutboundQueue(size_t depth, SlowConsumerPolicy policy);
+    OutboundQueueStats GetOutboundQueueStats() const;
+
+    /**
+     * @brief Configure the threads handling connections, must be called
+     *        before \ref Initialize
+     * @param threads Number of I/O threads, 0 for one per CPU core
+     * @param contextPerThread If true, every thread gets its own io_context and
+     *        listening socket (using SO_REUSEPORT), and the kernel distributes
+     *        new connections across them. Otherwise all threads share one
+     *        io_context
+     * @param pinThreads If true, I/O thread i is bound to CPU core i
+     */
+    void SetIoThreads(unsigned threads, bool contextPerThread, bool pinThreads);
+
+    /**
+     * @brief Configure processing of Web-Socket requests outside of the I/O
+     *        threads. Responses are sent in request order per connection
+     * @param workers Number of request processing threads, 0 to process
+     *        requests on the I/O threads
+     * @param queueLimit Requests that may be queued or processed at the same
+     *        time, further requests are answered with an error
+     */
+    void SetRequestWorkers(unsigned workers, size_t queueLimit);
+
+    /**
+     * @brief Configure permessage-deflate compression of Web-Socket
+     *        connections, takes effect for connections accepted afterwards
+     * @param enable If true, compression is offered to clients
+     * @param windowBits Size of the compression window as power of two, 9..15
+     * @param memLevel Memory used for the compression state, 1..9
+     * @param threshold Messages smaller than this are sent uncompressed. Boost.Beast
+     *        versions without msg_size_threshold compress all messages
+     * @param contextTakeover If false, every message is compressed on its own
+     */
+    void SetCompression(bool enable, int windowBits, int memLevel,
+                        size_t threshold, bool contextTakeover);
+    CompressionStats GetCompressionStats() const;
+
+    /**
+     * @brief Configure a Unix domain socket accepting plain Web-Socket and
+     *        HTTP connections, must be called before \ref Initialize
+     * @param path Path of the socket, empty to not listen on one
+     * @param permissionsFile JSON file with the permissions of local clients
+     *        by user, see \ref PeerCredentials. Empty if local clients
+     *        authorize with tokens only
+     */
+    void SetLocalSocket(const std::string &path, const std::string &permissionsFile);
+
+    /**
+     * @brief Configure resuming of Server-Sent Events streams
+     * @param replaySize Number of events kept per stream for clients resuming
+     *        with Last-Event-ID, 0 to resume without replay
+     * @param resumeTimeout How long the subscriptions of a stream are kept
+     *        after its connection closed
+     */
+    void SetEventStreamResume(size_t replaySize, std::chrono::seconds resumeTimeout);
+
+    /**
+     * @brief Set the handler the subscriptions of Server-Sent Events streams
+     *        are removed from, once a stream can not be resumed anymore
+     */
+    void SetSubscriptionHandler(std::weak_ptr<ISubscriptionHandler> subHandler);
+
     /**
      * @brief Initialize Boost.Beast server
      * @param host Hostname for server connection
@@ -95,6 +221,7 @@ class WebSockHttpFlexServer : public IServer {
     void AddListener(ObserverType type,   std::shared_ptr<IVssCommandProcessor> listener);
     void RemoveListener(ObserverType type, std::shared_ptr<IVssCommandProcessor> listener);
     bool SendToConnection(ConnectionId connID, const std::string &message);
+    bool SendToConnection(ConnectionId connID, const OutboundMessage &message);
 };
 
 
@@ -25,25 +25,68 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <fstream>
 #include <sstream>
 
 #include "jsoncons/json.hpp"
 
+#include <boost/program_options.hpp>
+
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/health_check_service_interface.h>
 
 #include "VssCommandProcessor.hpp"
+#include "VssValueStore.hpp"
 #include "kuksa.grpc.pb.h"
+#include "kuksa/val/v1/val.grpc.pb.h"
 #include "SubscriptionHandler.hpp"
 
 
+/// Subscriptions made on a gRPC subscribe call, by path and attribute
+using GrpcSubscriptionMap =
+    std::unordered_map<subscription_keys_t, std::string, SubscriptionKeyHasher>;
+
+/** Notifications collected for a subscribe call during the batching window.
+ *  Only the latest value of a signal is kept, so a batch holds at most one
+ *  value per subscribed signal, in the order the signals first changed */
+class GrpcUpdateBatch {
+  public:
+    void add(const kuksa::Value& value);
+    bool empty() const { return updates_.empty(); }
+    size_t size() const { return updates_.size(); }
+    /** Moves the collected values to the updates of resp, leaving the batch
+     *  empty */
+    void take(kuksa::SubscribeResponse* resp);
+
+  private:
+    std::vector<kuksa::Value> updates_;
+    /// position of a path in updates_
+    std::unordered_map<std::string, size_t> index_;
+};
+
 class grpcHandler{
     public:
-      static void grpc_send_object_to_stream(std::shared_ptr<ILogger> logger, const std::string& vssdatatype, const jsoncons::json& data, grpc::ServerReaderWriter<kuksa::SubscribeResponse, kuksa::SubscribeRequest>* stream );
-      static void grpc_fill_value(std::shared_ptr<ILogger> logger, const std::string& vssdatatype, const jsoncons::json& data, kuksa::Value* grpcvalue, const std::string& attr = "value");
+      /** Notification of attr of the signal at path, from data as published by the database */
+      static void grpc_fill_subscribe_response(const std::string& path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json& data, kuksa::SubscribeResponse* resp);
+      /** Sets the member of grpcvalue for type, value is converted if it
+       *  has been stored with another type */
+      static void grpc_fill_value(const VssValue& value, VssValue::Type type, kuksa::Value* grpcvalue);
+      /** kuksa.val.v1 conversions. The datapoint carries the type vssdatatype
+       *  maps to, whatever type value has been stored with */
+      static void grpc_fill_datapoint(const VssValueSlot& slot, const std::string& vssdatatype, kuksa::val::v1::Datapoint* datapoint);
+      /** Native value a datapoint carries, an empty one if none is set */
+      static VssValue grpc_datapoint_value(const kuksa::val::v1::Datapoint& datapoint);
+      /** Update of attr of the signal at path, from data as published by the database */
+      static void grpc_fill_entry_update(const std::string& path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json& data, kuksa::val::v1::EntryUpdate* update);
+      /** (Un)subscribes the path and the paths of request on the subscribe
+       *  call of kc, currentSubs are the subscriptions made on the call so far.
+       *  response receives the outcome */
+      static void grpc_subscribe(VssCommandProcessor& processor, ILogger& logger, KuksaChannel& kc, const kuksa::SubscribeRequest& request, GrpcSubscriptionMap& currentSubs, kuksa::SubscribeResponse* response);
+      /** Metadata of a VSS tree node, as returned by IVssDatabase::getNodeMetaData */
+      static void grpc_fill_metadata(const jsoncons::json& node, kuksa::val::v1::Metadata* metadata);
     private:
         std::shared_ptr<grpc::Server> grpcServer;
         std::shared_ptr<VssCommandProcessor> grpcProcessor;
@@ -52,7 +95,12 @@ class grpcHandler{
        public:
         grpcHandler();
         virtual ~grpcHandler();
-        static void RunServer(std::shared_ptr<VssCommandProcessor> Processor, std::shared_ptr<IVssDatabase> database, std::shared_ptr<ISubscriptionHandler> _subhandler, std::shared_ptr<ILogger> logger_, std::string certPath, bool allowInsecureConn);   
+        static boost::program_options::options_description& getOptions();
+        /** Serves gRPC calls asynchronously on threads completion queues.
+         *  queueDepth: number of notifications that may be pending per
+         *  subscribe call, batchWindow: milliseconds notifications are
+         *  batched for on calls that subscribed with paths */
+        static void RunServer(std::shared_ptr<VssCommandProcessor> Processor, std::shared_ptr<IVssDatabase> database, std::shared_ptr<ISubscriptionHandler> _subhandler, std::shared_ptr<ILogger> logger_, std::string certPath, bool allowInsecureConn, unsigned threads, size_t queueDepth, unsigned batchWindow);   
         static void read (const std::string& filename, std::string& data); 
         std::shared_ptr<ILogger> getLogger() {
           return this->logger_;
@@ -37,6 +37,48 @@ enum class ObserverType {
 
 using ConnectionId = uint64_t;
 
+/**
+ * \class OutboundMessage
+ * \brief Message to a single connection, made of a per-connection head and
+ *        tail around a body that is shared by all receivers of the same update
+ */
+struct OutboundMessage {
+  std::string head;
+  std::shared_ptr<const std::string> body;
+  std::string tail;
+  /// Set for subscription updates, messages with the same key carry newer
+  /// values of the same subscription and may replace each other. Empty for
+  /// responses, which are never dropped
+  std::string key;
+
+  size_t size() const {
+    return head.size() + (body ? body->size() : 0) + tail.size();
+  }
+  std::string flatten() const {
+    std::string message;
+    message.reserve(size());
+    message.append(head);
+    if (body) {
+      message.append(*body);
+    }
+    message.append(tail);
+    return message;
+  }
+};
+
+/**
+ * \class IConnection
+ * \brief Connection of a server that messages can be pushed to
+ */
+class IConnection {
+  public:
+    virtual ~IConnection() {}
+
+    /// Queues message for sending. Returns false if the connection does not
+    /// take messages anymore
+    virtual bool send(const OutboundMessage &message) = 0;
+};
+
 class IServer {
   public:
     virtual ~IServer() {}
@@ -44,5 +86,9 @@ class IServer {
     virtual void AddListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) = 0;
     virtual void RemoveListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) = 0;
     virtual bool SendToConnection(ConnectionId connID, const std::string &message) = 0;
+    /// Servers able to send the parts of message without joining them first override this
+    virtual bool SendToConnection(ConnectionId connID, const OutboundMessage &message) {
+      return SendToConnection(connID, message.flatten());
+    }
 };
 #endif
@@ -45,13 +45,16 @@ class ISubscriptionHandler {
                                      const std::string &path, const std::string& attr) = 0;
     virtual int unsubscribe(SubscriptionId subscribeID) = 0;
     virtual int unsubscribeAll(KuksaChannel channel) = 0;
-    virtual int publishForVSSPath(const VSSPath path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json &value) = 0;
+    /** Notifies the subscribers of path about value. revision is the
+     *  revision of the signal after the set, updates with a revision older
+     *  than one already published for the signal are dropped. 0 publishes
+     *  unconditionally */
+    virtual int publishForVSSPath(const VSSPath path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json &value, uint64_t revision = 0) = 0;
 
     virtual std::shared_ptr<IServer> getServer() = 0;
     virtual int startThread() = 0;
     virtual int stopThread() = 0;
     virtual bool isThreadRunning() const = 0;
-    virtual void* subThreadRunner() = 0;
     virtual void addPublisher(std::shared_ptr<IPublisher> publisher) = 0;
 };
 #endif
@@ -43,6 +43,28 @@ class IVssCommandProcessor {
      */
     virtual jsoncons::json processQuery(const std::string &req_json,
                                      KuksaChannel& channel) = 0;
+
+    /**
+     * @brief Process an already decoded request, e.g. received in a binary
+     *        encoding
+     * @param request Request as JSON object, may be modified while processing
+     * @param channel Active channel information on which \a request was received
+     * @return JSON response
+     */
+    virtual jsoncons::json processQuery(jsoncons::json &request,
+                                     KuksaChannel& channel) = 0;
+
+    /**
+     * @brief Identify the current state of the signals at or below a path,
+     *        e.g. to answer conditional HTTP requests without reading values
+     * @param channel Active channel information of the requester
+     * @param path VSS path
+     * @return Tag that changes whenever one of the values, or the VSS tree,
+     *         changes. Empty if \a path does not exist or \a channel may not
+     *         read all signals
+     */
+    virtual std::string getRevisionTag(KuksaChannel& channel,
+                                       const std::string &path) = 0;
 };
 
 #endif
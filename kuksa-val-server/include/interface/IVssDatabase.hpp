@@ -26,6 +26,17 @@
 
 #include "KuksaChannel.hpp"
 #include "VSSPath.hpp"
+#include "VssValueStore.hpp"
+
+/** Revision of the signals at or below a path. The signals a path covers
+ *  only change with the VSS tree, so within one tree revision the sum of
+ *  their value revisions only grows */
+struct VssRevision {
+  /// incremented whenever the VSS tree changes
+  uint64_t tree;
+  /// sum of the revisions of the signals at or below the path
+  uint64_t values;
+};
 
 class IVssDatabase {
   public:
@@ -35,10 +46,26 @@ class IVssDatabase {
     virtual void updateJsonTree(KuksaChannel& channel, jsoncons::json& value) = 0;
     virtual void updateMetaData(KuksaChannel& channel, const VSSPath& path, const jsoncons::json& value) = 0;
     virtual jsoncons::json getMetaData(const VSSPath &path) = 0;
+    /** Returns the metadata (datatype, type, unit, ...) of the single node
+     *  path references, without its children. Throws noPathFoundonTree */
+    virtual jsoncons::json getNodeMetaData(const VSSPath &path) = 0;
   
     virtual jsoncons::json setSignal(const VSSPath &path, const std::string& attr, jsoncons::json &value) = 0; //gen2 version
     virtual jsoncons::json getSignal(const VSSPath& path, const std::string& attr, bool as_string=false) = 0;
 
+    /** Typed counterpart of setSignal for protocols that do not speak JSON.
+     *  value is converted to the datatype of path and checked against its
+     *  limits. timestampNs (since the epoch) of 0 stamps the value with the
+     *  current time. Throws noPathFoundonTree, noPermissionException if path
+     *  is no sensor/actuator or can not carry attr, and outOfBoundException
+     *  if value does not fit the datatype */
+    virtual void setSignalValue(const VSSPath &path, const std::string& attr, const VssValue &value,
+                                uint64_t timestampNs = 0) = 0;
+    /** Typed counterpart of getSignal for a single leaf. Throws
+     *  noPathFoundonTree, notValidException if path is a branch or matches
+     *  several leaves, and notSetException */
+    virtual VssValueSlot getSignalValue(const VSSPath &path, const std::string& attr) = 0;
+
     virtual bool pathExists(const VSSPath &path) = 0;
     virtual bool pathIsWritable(const VSSPath &path) = 0;
     virtual bool pathIsReadable(const VSSPath &path) = 0;
@@ -48,11 +75,12 @@ class IVssDatabase {
 
     virtual std::list<VSSPath> getLeafPaths(const VSSPath& path) = 0;
 
-    virtual void checkAndSanitizeType(jsoncons::json &meta, jsoncons::json &val) = 0;
-                           
-    // TODO: temporary added while components are refactored
-    jsoncons::json data_tree__;
-    jsoncons::json meta_tree__;
+    /** Returns the revision of the signals at or below path, which changes
+     *  whenever one of their values, or the VSS tree, changes. Throws
+     *  noPathFoundonTree */
+    virtual VssRevision getRevision(const VSSPath &path) = 0;
+
+    virtual void checkAndSanitizeType(const jsoncons::json &meta, jsoncons::json &val) = 0;
 };
 
 #endif
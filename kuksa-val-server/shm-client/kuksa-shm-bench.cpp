@@ -0,0 +1,90 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Writes values to the ring of a feeder as fast as possible and reports
+ *  the rate. With --wait, values are retried until the server has taken
+ *  them, so the rate is the one the server ingests at. Otherwise values
+ *  written to a full ring are dropped and counted.
+ *
+ *  kuksa-shm-bench [--wait] <feeder> <count> <path>...
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "kuksa_shm.h"
+
+int main(int argc, char *argv[]) {
+  int arg = 1;
+  bool wait = false;
+  if (arg < argc && std::strcmp(argv[arg], "--wait") == 0) {
+    wait = true;
+    arg++;
+  }
+  if (argc - arg < 3) {
+    std::cerr << "Usage: " << argv[0] << " [--wait] <feeder> <count> <path>..." << std::endl;
+    return 1;
+  }
+  const char *feeder = argv[arg++];
+  uint64_t count = std::strtoull(argv[arg++], nullptr, 10);
+
+  kuksa_shm *shm = kuksa_shm_open(feeder);
+  if (shm == nullptr) {
+    std::cerr << "Cannot attach to ring of feeder " << feeder << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  std::vector<uint32_t> signals;
+  for (; arg < argc; arg++) {
+    int64_t signal = kuksa_shm_signal(shm, argv[arg]);
+    if (signal < 0) {
+      std::cerr << "Cannot declare " << argv[arg] << ": " << std::strerror(-signal) << std::endl;
+      kuksa_shm_close(shm);
+      return 1;
+    }
+    signals.push_back(static_cast<uint32_t>(signal));
+  }
+
+  uint64_t dropped = kuksa_shm_dropped(shm);
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++) {
+    uint32_t signal = signals[i % signals.size()];
+    while (kuksa_shm_set_double(shm, signal, static_cast<double>(i % 1000), 0) == -EAGAIN && wait) {
+      std::this_thread::yield();
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if (!wait) {
+    dropped = kuksa_shm_dropped(shm) - dropped;
+  } else {
+    // retried values have been counted as dropped as well
+    dropped = 0;
+  }
+
+  std::cout << count << " values in " << elapsed.count() << " s: "
+            << static_cast<uint64_t>(count / elapsed.count()) << " values/s, "
+            << dropped << " dropped" << std::endl;
+  kuksa_shm_close(shm);
+  return 0;
+}
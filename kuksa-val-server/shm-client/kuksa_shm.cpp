@@ -0,0 +1,122 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "kuksa_shm.h"
+
+#include <chrono>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include "ShmRing.hpp"
+
+struct kuksa_shm {
+  explicit kuksa_shm(const char *name) : producer(name) {}
+
+  ShmRing::Producer producer;
+};
+
+namespace {
+  uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  int push(kuksa_shm *shm, uint32_t signal, ShmRing::ValueType type,
+           const ShmRing::Value &value, uint64_t timestamp_ns) {
+    if (shm == nullptr) {
+      return -EINVAL;
+    }
+    return shm->producer.push(signal, type, value, timestamp_ns != 0 ? timestamp_ns : now()) ? 0 : -EAGAIN;
+  }
+}
+
+kuksa_shm* kuksa_shm_open(const char *name) {
+  if (name == nullptr) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  try {
+    return new kuksa_shm(name);
+  } catch (std::system_error &e) {
+    errno = e.code().value();
+  } catch (std::invalid_argument &) {
+    errno = EINVAL;
+  } catch (std::bad_alloc &) {
+    errno = ENOMEM;
+  } catch (std::exception &) {
+    // incompatible ring or another feeder attached
+    errno = EBUSY;
+  }
+  return nullptr;
+}
+
+void kuksa_shm_close(kuksa_shm *shm) {
+  delete shm;
+}
+
+int64_t kuksa_shm_signal(kuksa_shm *shm, const char *path) {
+  if (shm == nullptr || path == nullptr) {
+    return -EINVAL;
+  }
+  try {
+    return shm->producer.signal(path);
+  } catch (std::invalid_argument &) {
+    return -EINVAL;
+  } catch (std::length_error &) {
+    return -ENOSPC;
+  }
+}
+
+int kuksa_shm_set_bool(kuksa_shm *shm, uint32_t signal, bool value, uint64_t timestamp_ns) {
+  ShmRing::Value v;
+  v.b = value;
+  return push(shm, signal, ShmRing::ValueType::Bool, v, timestamp_ns);
+}
+
+int kuksa_shm_set_int64(kuksa_shm *shm, uint32_t signal, int64_t value, uint64_t timestamp_ns) {
+  ShmRing::Value v;
+  v.i64 = value;
+  return push(shm, signal, ShmRing::ValueType::Int64, v, timestamp_ns);
+}
+
+int kuksa_shm_set_uint64(kuksa_shm *shm, uint32_t signal, uint64_t value, uint64_t timestamp_ns) {
+  ShmRing::Value v;
+  v.u64 = value;
+  return push(shm, signal, ShmRing::ValueType::UInt64, v, timestamp_ns);
+}
+
+int kuksa_shm_set_float(kuksa_shm *shm, uint32_t signal, float value, uint64_t timestamp_ns) {
+  ShmRing::Value v;
+  v.f = value;
+  return push(shm, signal, ShmRing::ValueType::Float, v, timestamp_ns);
+}
+
+int kuksa_shm_set_double(kuksa_shm *shm, uint32_t signal, double value, uint64_t timestamp_ns) {
+  ShmRing::Value v;
+  v.d = value;
+  return push(shm, signal, ShmRing::ValueType::Double, v, timestamp_ns);
+}
+
+uint64_t kuksa_shm_dropped(const kuksa_shm *shm) {
+  return shm != nullptr ? shm->producer.dropped() : 0;
+}
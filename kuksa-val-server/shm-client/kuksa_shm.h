@@ -0,0 +1,68 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** C interface for local feeders writing signal values to the shared memory
+ *  ring kuksa-val-server creates for them (option shm.feeder). C++ feeders
+ *  may use ShmRing::Producer from ShmRing.hpp directly.
+ *
+ *  A handle must only be used by one thread at a time. Functions returning
+ *  int return 0 on success and a negative errno value otherwise, -EAGAIN if
+ *  the ring is full and the value has been dropped.
+ */
+
+#ifndef __KUKSA_SHM_H__
+#define __KUKSA_SHM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kuksa_shm kuksa_shm;
+
+/** Attaches to the ring of feeder name. Returns NULL and sets errno if
+ *  there is none or another feeder is attached */
+kuksa_shm* kuksa_shm_open(const char *name);
+void kuksa_shm_close(kuksa_shm *shm);
+
+/** Signal id of a VSS path like "Vehicle.Speed", declaring it to the server
+ *  if needed. Returns a negative errno value if the path is too long or the
+ *  signal table of the ring is full */
+int64_t kuksa_shm_signal(kuksa_shm *shm, const char *path);
+
+/** timestamp_ns is the time the value has been taken at, in nanoseconds
+ *  since the epoch, 0 for now */
+int kuksa_shm_set_bool(kuksa_shm *shm, uint32_t signal, bool value, uint64_t timestamp_ns);
+int kuksa_shm_set_int64(kuksa_shm *shm, uint32_t signal, int64_t value, uint64_t timestamp_ns);
+int kuksa_shm_set_uint64(kuksa_shm *shm, uint32_t signal, uint64_t value, uint64_t timestamp_ns);
+int kuksa_shm_set_float(kuksa_shm *shm, uint32_t signal, float value, uint64_t timestamp_ns);
+int kuksa_shm_set_double(kuksa_shm *shm, uint32_t signal, double value, uint64_t timestamp_ns);
+
+/** Number of values dropped so far because the ring was full */
+uint64_t kuksa_shm_dropped(const kuksa_shm *shm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
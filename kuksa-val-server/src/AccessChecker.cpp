@@ -24,7 +24,6 @@
 
 #include <jsoncons/json.hpp>
 #include <string>
-#include <regex>
 
 #include "IAuthenticator.hpp"
 #include "KuksaChannel.hpp"
@@ -36,39 +35,21 @@ AccessChecker::AccessChecker(std::shared_ptr<IAuthenticator> vdator) {
   tokenValidator = vdator;
 }
 
-bool AccessChecker::checkSignalAccess(const KuksaChannel& channel, const string& path, const string& requiredPermission){
-  json permissions;
-  if(!channel.getPermissions().empty()){
-    permissions = json::parse(channel.getPermissions().as_string());
-  }
-  else{
-    permissions = json::parse("{}");
-  }
-  string permissionValue = permissions.get_with_default(path, "");
-  if (permissionValue.empty()){
-    for (auto permission : permissions.object_range()) {
-      string pathString(permission.key());
-      auto path_regex = std::regex{
-        std::regex_replace(pathString, std::regex("\\*"), std::string(".*"))};
-      std::smatch base_match;
-      if (std::regex_match(path, base_match, path_regex)) {
-        permissionValue = permission.value().as<string>();
-      }
-    }
-  
-  } 
-  return permissionValue.find(requiredPermission) != std::string::npos;
+// permissions are compiled when granted, so that checks neither parse nor allocate
+bool AccessChecker::checkSignalAccess(const KuksaChannel& channel, const string& path, PermissionMatcher::Access requiredPermission){
+  const PermissionMatcher *matcher = channel.getPermissionMatcher();
+  return matcher != nullptr && matcher->allows(path, requiredPermission);
 }
 
 
 // check the permissions json in KuksaChannel if path has read access
 bool AccessChecker::checkReadAccess(KuksaChannel &channel, const VSSPath &path) {
-  return checkSignalAccess(channel, path.getVSSGen1Path(), "r");
+  return checkSignalAccess(channel, path.getVSSGen1Path(), PermissionMatcher::READ);
 }
 
 // check the permissions json in KuksaChannel if path has read access
 bool AccessChecker::checkWriteAccess(KuksaChannel &channel, const VSSPath &path) {
-  return checkSignalAccess(channel, path.getVSSGen1Path(), "w");
+  return checkSignalAccess(channel, path.getVSSGen1Path(), PermissionMatcher::WRITE);
 }
 
 
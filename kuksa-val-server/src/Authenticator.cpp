@@ -134,7 +134,7 @@ bool Authenticator::isStillValid(KuksaChannel& channel) {
 
 // **Do this only once for authenticate request**
 // resolves the permission in the JWT token and store the absolute path to the
-// signals in permissions JSON in WsChannel.
+// signals in permissions JSON in WsChannel, compiled for the access checks.
 void Authenticator::resolvePermissions(KuksaChannel& channel) {
   string authToken = channel.getAuthToken();
   auto decoded = jwt::decode(authToken);
@@ -167,5 +167,5 @@ void Authenticator::resolvePermissions(KuksaChannel& channel) {
   }
   std::string channelPermissions;
   permissions.dump_pretty(channelPermissions);
-  channel.setPermissions(channelPermissions);
+  channel.setPermissions(channelPermissions, std::make_shared<const PermissionMatcher>(permissions));
 }
@@ -0,0 +1,107 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "ConnectionRegistry.hpp"
+
+#include <stdexcept>
+
+namespace {
+  uint32_t indexOf(ConnectionId id) {
+    return static_cast<uint32_t>(id);
+  }
+
+  uint32_t generationOf(ConnectionId id) {
+    return static_cast<uint32_t>(id >> 32);
+  }
+}
+
+const size_t ConnectionRegistry::CHUNK_SIZE;
+const size_t ConnectionRegistry::MAX_CHUNKS;
+
+ConnectionRegistry::ConnectionRegistry() {
+  for (auto &chunk : chunks_) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+ConnectionId ConnectionRegistry::add(std::weak_ptr<IConnection> connection) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t index;
+  if (!free_.empty()) {
+    index = free_.front();
+    free_.pop_front();
+  } else {
+    if (allocated_ == CHUNK_SIZE * MAX_CHUNKS) {
+      throw std::runtime_error("Too many connections");
+    }
+    index = allocated_++;
+    if (index % CHUNK_SIZE == 0) {
+      ownedChunks_.emplace_back(new Slot[CHUNK_SIZE]);
+      chunks_[index / CHUNK_SIZE].store(ownedChunks_.back().get(), std::memory_order_release);
+    }
+  }
+
+  Slot &slot = chunks_[index / CHUNK_SIZE].load(std::memory_order_relaxed)[index % CHUNK_SIZE];
+  ConnectionId id = (static_cast<ConnectionId>(slot.generation) << 32) | index;
+  std::atomic_store(&slot.entry, std::shared_ptr<const Entry>(new Entry{id, std::move(connection)}));
+  size_++;
+  return id;
+}
+
+void ConnectionRegistry::remove(ConnectionId id) {
+  uint32_t index = indexOf(id);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index >= allocated_) {
+    return;
+  }
+  Slot &slot = chunks_[index / CHUNK_SIZE].load(std::memory_order_relaxed)[index % CHUNK_SIZE];
+  if (!slot.entry || slot.entry->id != id) {
+    return;
+  }
+  std::atomic_store(&slot.entry, std::shared_ptr<const Entry>());
+  // generation 0 is never handed out, so that no id is 0
+  if (++slot.generation == 0) {
+    slot.generation = 1;
+  }
+  free_.push_back(index);
+  size_--;
+}
+
+std::shared_ptr<IConnection> ConnectionRegistry::find(ConnectionId id) const {
+  uint32_t index = indexOf(id);
+  if (generationOf(id) == 0 || index >= CHUNK_SIZE * MAX_CHUNKS) {
+    return nullptr;
+  }
+  const Slot *chunk = chunks_[index / CHUNK_SIZE].load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    return nullptr;
+  }
+  std::shared_ptr<const Entry> entry = std::atomic_load(&chunk[index % CHUNK_SIZE].entry);
+  if (!entry || entry->id != id) {
+    return nullptr;
+  }
+  return entry->connection.lock();
+}
+
+size_t ConnectionRegistry::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
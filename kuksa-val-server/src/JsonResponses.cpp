@@ -78,6 +78,25 @@ jsoncons::json notSetResponse(std::string request_id, std::string message) {
   return answer;
 }
 
+/** The server is too busy to process a request */
+void serviceUnavailable(std::string request_id, const std::string action,
+                        std::string message, jsoncons::json& jsonResponse) {
+  jsonResponse["action"] = action;
+  jsonResponse["requestId"] = request_id;
+  jsoncons::json error;
+  error["number"] = "503";
+  error["reason"] = "Service Unavailable";
+  error["message"] = message;
+  jsonResponse["error"] = error;
+  jsonResponse["ts"] = getTimeStamp();
+}
+jsoncons::json serviceUnavailable(std::string request_id, const std::string action,
+                                  std::string message) {
+  jsoncons::json answer;
+  serviceUnavailable(request_id, action, message, answer);
+  return answer;
+}
+
 /** A API call requested a non-existant path */
 void pathNotFound(std::string request_id, const std::string action,
                   const std::string path, jsoncons::json& jsonResponse) {
@@ -0,0 +1,179 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "MessageEncoding.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include "jsoncons_ext/cbor/cbor.hpp"
+#include "jsoncons_ext/msgpack/msgpack.hpp"
+
+namespace {
+  const std::string CborSubprotocol = "kuksa.cbor";
+  const std::string MsgpackSubprotocol = "kuksa.msgpack";
+  const std::string JsonSubprotocol = "kuksa.json";
+
+  /** Read-only stream buffer on top of a received message, so it can be
+   *  decoded without copying it first */
+  class MessageBuffer : public std::streambuf {
+    public:
+      explicit MessageBuffer(const std::string &message) {
+        char *begin = const_cast<char*>(message.data());
+        setg(begin, begin, begin + message.size());
+      }
+  };
+
+  /// Appends a big endian length of size bytes
+  void appendLength(std::string &out, uint64_t length, int size) {
+    for (int shift = (size - 1) * 8; shift >= 0; shift -= 8) {
+      out.push_back(static_cast<char>((length >> shift) & 0xff));
+    }
+  }
+
+  void appendCborString(std::string &out, const std::string &str) {
+    if (str.size() < 24) {
+      out.push_back(static_cast<char>(0x60 | str.size()));
+    } else if (str.size() <= 0xff) {
+      out.push_back(static_cast<char>(0x78));
+      appendLength(out, str.size(), 1);
+    } else if (str.size() <= 0xffff) {
+      out.push_back(static_cast<char>(0x79));
+      appendLength(out, str.size(), 2);
+    } else {
+      out.push_back(static_cast<char>(0x7a));
+      appendLength(out, str.size(), 4);
+    }
+    out += str;
+  }
+
+  void appendMsgpackString(std::string &out, const std::string &str) {
+    if (str.size() < 32) {
+      out.push_back(static_cast<char>(0xa0 | str.size()));
+    } else if (str.size() <= 0xff) {
+      out.push_back(static_cast<char>(0xd9));
+      appendLength(out, str.size(), 1);
+    } else if (str.size() <= 0xffff) {
+      out.push_back(static_cast<char>(0xda));
+      appendLength(out, str.size(), 2);
+    } else {
+      out.push_back(static_cast<char>(0xdb));
+      appendLength(out, str.size(), 4);
+    }
+    out += str;
+  }
+}
+
+namespace MessageEncoding {
+
+bool fromSubprotocols(const std::string &offered, KuksaChannel::Encoding &encoding) {
+  std::vector<std::string> protocols;
+  boost::split(protocols, offered, boost::is_any_of(","));
+  for (auto &protocol : protocols) {
+    boost::trim(protocol);
+    if (protocol == CborSubprotocol) {
+      encoding = KuksaChannel::Encoding::CBOR;
+      return true;
+    } else if (protocol == MsgpackSubprotocol) {
+      encoding = KuksaChannel::Encoding::MSGPACK;
+      return true;
+    } else if (protocol == JsonSubprotocol) {
+      encoding = KuksaChannel::Encoding::JSON;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string subprotocol(KuksaChannel::Encoding encoding) {
+  switch (encoding) {
+    case KuksaChannel::Encoding::CBOR:
+      return CborSubprotocol;
+    case KuksaChannel::Encoding::MSGPACK:
+      return MsgpackSubprotocol;
+    case KuksaChannel::Encoding::JSON:
+    default:
+      return JsonSubprotocol;
+  }
+}
+
+jsoncons::json decode(const std::string &message, KuksaChannel::Encoding encoding) {
+  if (encoding == KuksaChannel::Encoding::JSON) {
+    return jsoncons::json::parse(message);
+  }
+  MessageBuffer buffer(message);
+  std::istream is(&buffer);
+  if (encoding == KuksaChannel::Encoding::CBOR) {
+    return jsoncons::cbor::decode_cbor<jsoncons::json>(is);
+  }
+  return jsoncons::msgpack::decode_msgpack<jsoncons::json>(is);
+}
+
+std::string encode(const jsoncons::json &message, KuksaChannel::Encoding encoding) {
+  if (encoding == KuksaChannel::Encoding::JSON) {
+    std::string out;
+    message.dump(out);
+    return out;
+  }
+  std::vector<uint8_t> out;
+  if (encoding == KuksaChannel::Encoding::CBOR) {
+    jsoncons::cbor::encode_cbor(message, out);
+  } else {
+    jsoncons::msgpack::encode_msgpack(message, out);
+  }
+  return std::string(out.begin(), out.end());
+}
+
+void subscriptionEnvelope(KuksaChannel::Encoding encoding, const std::string &subscriptionId,
+                          std::string &head, std::string &tail) {
+  // members in the order the complete object would be serialized in
+  head.clear();
+  tail.clear();
+  switch (encoding) {
+    case KuksaChannel::Encoding::CBOR:
+      head.push_back(static_cast<char>(0xa3));  // map with 3 entries
+      appendCborString(head, "action");
+      appendCborString(head, "subscription");
+      appendCborString(head, "data");
+      appendCborString(tail, "subscriptionId");
+      appendCborString(tail, subscriptionId);
+      break;
+    case KuksaChannel::Encoding::MSGPACK:
+      head.push_back(static_cast<char>(0x83));  // map with 3 entries
+      appendMsgpackString(head, "action");
+      appendMsgpackString(head, "subscription");
+      appendMsgpackString(head, "data");
+      appendMsgpackString(tail, "subscriptionId");
+      appendMsgpackString(tail, subscriptionId);
+      break;
+    case KuksaChannel::Encoding::JSON:
+    default:
+      head = "{\"action\":\"subscription\",\"data\":";
+      tail = ",\"subscriptionId\":\"" + subscriptionId + "\"}";
+      break;
+  }
+}
+
+}
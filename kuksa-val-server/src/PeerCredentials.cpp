@@ -0,0 +1,81 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "PeerCredentials.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "KuksaChannel.hpp"
+
+PeerCredentials::PeerCredentials(const jsoncons::json &users) {
+  if (!users.is_object()) {
+    throw std::invalid_argument("Peer credentials need to be an object with users as keys");
+  }
+  for (const auto &user : users.object_range()) {
+    const jsoncons::json &claims = user.value();
+    if (!claims.is_object()) {
+      throw std::invalid_argument("Permissions of user " + std::string(user.key()) + " need to be an object");
+    }
+
+    jsoncons::json permissions;
+    if (claims.contains("kuksa-vss")) {
+      for (const auto &permission : claims["kuksa-vss"].object_range()) {
+        std::string value = permission.value().as<std::string>();
+        if (value != "rw" && value != "wr" && value != "r" && value != "w") {
+          throw std::invalid_argument("Permission for " + std::string(permission.key()) + " = " + value +
+                                      " of user " + std::string(user.key()) + " is not valid, only r|w are supported");
+        }
+        permissions.insert_or_assign(permission.key(), value);
+      }
+    }
+
+    Grant grant;
+    permissions.dump_pretty(grant.permissions);
+    grant.matcher = std::make_shared<const PermissionMatcher>(permissions);
+    grant.modifyTree = claims.contains("modifyTree") && claims["modifyTree"].as<bool>();
+    grants_[std::string(user.key())] = grant;
+  }
+}
+
+PeerCredentials PeerCredentials::fromFile(const std::string &fileName) {
+  std::ifstream file(fileName);
+  if (!file) {
+    throw std::runtime_error("Can not read peer credentials from " + fileName);
+  }
+  return PeerCredentials(jsoncons::json::parse(file));
+}
+
+bool PeerCredentials::authorize(KuksaChannel &channel, uid_t uid, const std::string &user) const {
+  auto grant = user.empty() ? grants_.end() : grants_.find(user);
+  if (grant == grants_.end()) {
+    grant = grants_.find(std::to_string(uid));
+  }
+  if (grant == grants_.end()) {
+    return false;
+  }
+  channel.setAuthorized(true);
+  channel.setPermissions(grant->second.permissions, grant->second.matcher);
+  if (grant->second.modifyTree) {
+    channel.enableModifyTree();
+  }
+  return true;
+}
@@ -0,0 +1,158 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "PermissionMatcher.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+namespace {
+  const std::string AnyDepth = "*";
+
+  uint8_t parseAccess(const std::string &value) {
+    uint8_t access = PermissionMatcher::NONE;
+    if (value.find('r') != std::string::npos) {
+      access |= PermissionMatcher::READ;
+    }
+    if (value.find('w') != std::string::npos) {
+      access |= PermissionMatcher::WRITE;
+    }
+    return access;
+  }
+}
+
+PermissionMatcher::PermissionMatcher(const jsoncons::json &permissions) {
+  jsoncons::json parsed;
+  const jsoncons::json *object = &permissions;
+  if (permissions.is_string()) {
+    std::string text = permissions.as_string();
+    parsed = text.empty() ? jsoncons::json() : jsoncons::json::parse(text);
+    object = &parsed;
+  }
+  if (!object->is_object()) {
+    return;
+  }
+
+  // paths without asterisk rank above all patterns
+  int patterns = static_cast<int>(object->size());
+  int rank = 0;
+  for (const auto &permission : object->object_range()) {
+    std::string pattern(permission.key());
+    bool literal = pattern.find('*') == std::string::npos;
+    insert(pattern, literal ? patterns + rank : rank, parseAccess(permission.value().as<std::string>()));
+    rank++;
+  }
+}
+
+void PermissionMatcher::insert(const std::string &pattern, int rank, uint8_t access) {
+  std::vector<std::string> elements;
+  boost::split(elements, pattern, boost::is_any_of("."));
+  Node *node = &root_;
+  for (const auto &element : elements) {
+    std::unique_ptr<Node> *next;
+    if (element == AnyDepth) {
+      next = &node->anyDepth;
+    } else if (element.find('*') != std::string::npos) {
+      next = &node->globs[element];
+    } else {
+      next = &node->children[element];
+    }
+    if (!*next) {
+      next->reset(new Node());
+    }
+    node = next->get();
+  }
+  if (rank > node->rank) {
+    node->rank = rank;
+    node->access = access;
+  }
+}
+
+uint8_t PermissionMatcher::access(const std::string &path) const {
+  Match match;
+  matchNode(root_, path, 0, match);
+  return match.access;
+}
+
+void PermissionMatcher::matchNode(const Node &node, const std::string &path, size_t pos, Match &match) {
+  // pos is past the end once all elements have been consumed
+  if (pos > path.size()) {
+    if (node.rank > match.rank) {
+      match.rank = node.rank;
+      match.access = node.access;
+    }
+    return;
+  }
+  size_t end = path.find('.', pos);
+  if (end == std::string::npos) {
+    end = path.size();
+  }
+  Element element{path.data() + pos, end - pos};
+
+  auto child = node.children.find(element);
+  if (child != node.children.end()) {
+    matchNode(*child->second, path, end + 1, match);
+  }
+  for (const auto &glob : node.globs) {
+    if (globMatches(glob.first, element)) {
+      matchNode(*glob.second, path, end + 1, match);
+    }
+  }
+  if (node.anyDepth) {
+    // consume this and any number of further elements
+    for (size_t next = end; ; next = path.find('.', next + 1)) {
+      if (next == std::string::npos) {
+        next = path.size();
+      }
+      matchNode(*node.anyDepth, path, next + 1, match);
+      if (next == path.size()) {
+        break;
+      }
+    }
+  }
+}
+
+bool PermissionMatcher::globMatches(const std::string &glob, const Element &element) {
+  // greedy matching, backtracking to the last asterisk only
+  size_t g = 0, e = 0;
+  size_t star = std::string::npos, resume = 0;
+  while (e < element.size) {
+    if (g < glob.size() && glob[g] == '*') {
+      star = g++;
+      resume = e;
+    } else if (g < glob.size() && glob[g] == element.data[e]) {
+      g++;
+      e++;
+    } else if (star != std::string::npos) {
+      g = star + 1;
+      e = ++resume;
+    } else {
+      return false;
+    }
+  }
+  while (g < glob.size() && glob[g] == '*') {
+    g++;
+  }
+  return g == glob.size();
+}
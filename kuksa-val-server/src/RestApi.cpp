@@ -0,0 +1,365 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "RestApi.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+namespace {
+  const std::string Prefix = "/vss";
+
+  /// Distinguishes entity tags of different server runs, revisions start
+  /// from scratch on every start
+  const std::string instanceTag = [] {
+    std::stringstream ss;
+    ss << std::hex << std::chrono::system_clock::now().time_since_epoch().count();
+    return ss.str();
+  }();
+
+  std::string newRequestId() {
+    thread_local boost::uuids::random_generator generator;
+    return boost::uuids::to_string(generator());
+  }
+
+  std::string urlDecode(const std::string &encoded, bool plusIsSpace) {
+    std::string decoded;
+    decoded.reserve(encoded.size());
+    for (size_t i = 0; i < encoded.size(); i++) {
+      if (encoded[i] == '%' && i + 2 < encoded.size() &&
+          std::isxdigit(encoded[i + 1]) && std::isxdigit(encoded[i + 2])) {
+        decoded += static_cast<char>(std::stoi(encoded.substr(i + 1, 2), nullptr, 16));
+        i += 2;
+      } else if (encoded[i] == '+' && plusIsSpace) {
+        decoded += ' ';
+      } else {
+        decoded += encoded[i];
+      }
+    }
+    return decoded;
+  }
+
+  RestApi::Response errorResponse(unsigned status, const std::string &reason, const std::string &message) {
+    jsoncons::json error;
+    error["number"] = status;
+    error["reason"] = reason;
+    error["message"] = message;
+
+    RestApi::Response response;
+    response.status = status;
+    response.body = error.to_string();
+    return response;
+  }
+
+  /// Response for a VISS response carrying an error
+  RestApi::Response errorResponse(const jsoncons::json &vissResponse) {
+    RestApi::Response response;
+    response.status = RestApi::statusOf(vissResponse);
+    response.body = vissResponse["error"].to_string();
+    return response;
+  }
+
+  /// Authorizes the connection if the request carries a token it is not
+  /// authorized with yet. Returns false and sets error if that fails
+  bool authorize(const RestApi::Request &request, const RestApi::QueryHandler &query,
+                 std::string &token, RestApi::Response &error) {
+    if (request.authorization.empty()) {
+      return true;
+    }
+    std::string newToken = RestApi::bearerToken(request.authorization);
+    if (newToken == token) {
+      return true;
+    }
+    jsoncons::json authorize;
+    authorize["action"] = "authorize";
+    authorize["tokens"] = newToken;
+    authorize["requestId"] = newRequestId();
+    jsoncons::json result = query(authorize);
+    if (RestApi::statusOf(result) != 200) {
+      error = errorResponse(result);
+      return false;
+    }
+    token = newToken;
+    return true;
+  }
+
+  /// Path of the target, or the path parameters if there is none
+  std::vector<std::string> requestedPaths(const std::string &path,
+                                          const std::multimap<std::string, std::string> &params) {
+    std::vector<std::string> paths;
+    if (!path.empty()) {
+      paths.push_back(path);
+      return paths;
+    }
+    auto range = params.equal_range("path");
+    for (auto it = range.first; it != range.second; ++it) {
+      paths.push_back(it->second);
+    }
+    return paths;
+  }
+
+  std::string attributeOf(const std::multimap<std::string, std::string> &params) {
+    auto attribute = params.find("attribute");
+    return attribute != params.end() ? attribute->second : std::string();
+  }
+}
+
+namespace RestApi {
+
+bool isRestTarget(const std::string &target) {
+  if (target.compare(0, Prefix.size(), Prefix) != 0) {
+    return false;
+  }
+  return target.size() == Prefix.size() || target[Prefix.size()] == '/' || target[Prefix.size()] == '?';
+}
+
+std::string bearerToken(const std::string &authorization) {
+  std::string token = authorization;
+  if (boost::algorithm::istarts_with(token, "Bearer ")) {
+    token.erase(0, 7);
+    boost::algorithm::trim(token);
+  }
+  return token;
+}
+
+bool parseTarget(const std::string &target, std::string &path,
+                 std::multimap<std::string, std::string> &params) {
+  if (!isRestTarget(target)) {
+    return false;
+  }
+  size_t queryStart = target.find('?');
+  std::string resource = target.substr(Prefix.size(), queryStart - Prefix.size());
+  boost::algorithm::trim_if(resource, boost::algorithm::is_any_of("/"));
+  path = urlDecode(resource, false);
+
+  params.clear();
+  if (queryStart == std::string::npos) {
+    return true;
+  }
+  std::vector<std::string> pairs;
+  boost::split(pairs, target.substr(queryStart + 1), boost::is_any_of("&"));
+  for (const auto &pair : pairs) {
+    if (pair.empty()) {
+      continue;
+    }
+    size_t equals = pair.find('=');
+    if (equals == std::string::npos) {
+      params.emplace(urlDecode(pair, true), "");
+    } else {
+      params.emplace(urlDecode(pair.substr(0, equals), true), urlDecode(pair.substr(equals + 1), true));
+    }
+  }
+  return true;
+}
+
+bool etagMatches(const std::string &ifNoneMatch, const std::string &etag) {
+  if (ifNoneMatch.empty() || etag.empty()) {
+    return false;
+  }
+  std::vector<std::string> tags;
+  boost::split(tags, ifNoneMatch, boost::is_any_of(","));
+  for (auto &tag : tags) {
+    boost::algorithm::trim(tag);
+    // If-None-Match uses weak comparison
+    if (boost::algorithm::starts_with(tag, "W/")) {
+      tag.erase(0, 2);
+    }
+    if (tag == "*" || tag == etag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+unsigned statusOf(const jsoncons::json &response) {
+  if (!response.is_object() || !response.contains("error")) {
+    return 200;
+  }
+  const jsoncons::json &number = response["error"].get_value_or<jsoncons::json>("number", jsoncons::json());
+  unsigned status = 0;
+  try {
+    if (number.is_string()) {
+      status = std::stoul(number.as<std::string>());
+    } else if (number.is_number()) {
+      status = number.as<unsigned>();
+    }
+  } catch (std::exception &) {
+    status = 0;
+  }
+  if (status < 400 || status > 599) {
+    status = 500;
+  }
+  return status;
+}
+
+Response handle(const Request &request, const QueryHandler &query,
+                const RevisionHandler &revision, std::string &token) {
+  std::string path;
+  std::multimap<std::string, std::string> params;
+  if (!parseTarget(request.target, path, params)) {
+    return errorResponse(404, "Not Found", "Unknown resource " + request.target);
+  }
+
+  Response error;
+  if (!authorize(request, query, token, error)) {
+    return error;
+  }
+  std::string attribute = attributeOf(params);
+
+  if (request.method == "GET") {
+    bool batch = path.empty();
+    std::vector<std::string> paths = requestedPaths(path, params);
+    if (paths.empty()) {
+      return errorResponse(400, "Bad Request", "No path given");
+    }
+    bool metadata = params.count("metadata") > 0;
+
+    // Tags are taken before reading, if a value changes in between the
+    // client reads it again next time
+    std::string etag;
+    std::vector<std::string> tags;
+    for (const auto &p : paths) {
+      tags.push_back(revision(p));
+      if (tags.back().empty()) {
+        tags.clear();
+        break;
+      }
+    }
+    if (!tags.empty()) {
+      etag = "\"" + instanceTag + "-" + boost::algorithm::join(tags, ".") + "\"";
+      if (etagMatches(request.ifNoneMatch, etag)) {
+        Response response;
+        response.status = 304;
+        response.etag = etag;
+        return response;
+      }
+    }
+
+    jsoncons::json results = jsoncons::json::array();
+    for (const auto &p : paths) {
+      jsoncons::json get;
+      get["action"] = metadata ? "getMetaData" : "get";
+      get["path"] = p;
+      get["requestId"] = newRequestId();
+      if (!attribute.empty() && !metadata) {
+        get["attribute"] = attribute;
+      }
+      jsoncons::json result = query(get);
+      if (statusOf(result) != 200) {
+        return errorResponse(result);
+      }
+      results.push_back(result[metadata ? "metadata" : "data"]);
+    }
+
+    Response response;
+    response.body = batch ? results.to_string() : results[0].to_string();
+    response.etag = etag;
+    return response;
+  }
+
+  if (request.method == "PUT") {
+    if (path.empty()) {
+      return errorResponse(400, "Bad Request", "No path given");
+    }
+    if (attribute.empty()) {
+      attribute = "value";
+    }
+    jsoncons::json set;
+    try {
+      set[attribute] = jsoncons::json::parse(request.body);
+    } catch (jsoncons::ser_error &e) {
+      return errorResponse(400, "Bad Request", std::string("Body is no JSON value: ") + e.what());
+    }
+    set["action"] = "set";
+    set["path"] = path;
+    set["attribute"] = attribute;
+    set["requestId"] = newRequestId();
+    jsoncons::json result = query(set);
+    if (statusOf(result) != 200) {
+      return errorResponse(result);
+    }
+    Response response;
+    response.status = 204;
+    return response;
+  }
+
+  return errorResponse(405, "Method Not Allowed", "Method " + request.method + " not supported");
+}
+
+Response subscribe(const Request &request, const QueryHandler &query,
+                   std::string &token, std::vector<std::string> &subscriptionIds) {
+  std::string path;
+  std::multimap<std::string, std::string> params;
+  if (!parseTarget(request.target, path, params)) {
+    return errorResponse(404, "Not Found", "Unknown resource " + request.target);
+  }
+  if (request.method != "GET") {
+    return errorResponse(405, "Method Not Allowed", "Method " + request.method + " not supported");
+  }
+  Response error;
+  if (!authorize(request, query, token, error)) {
+    return error;
+  }
+  std::vector<std::string> paths = requestedPaths(path, params);
+  if (paths.empty()) {
+    return errorResponse(400, "Bad Request", "No path given");
+  }
+  std::string attribute = attributeOf(params);
+
+  Response response;
+  for (const auto &p : paths) {
+    jsoncons::json subscribe;
+    subscribe["action"] = "subscribe";
+    subscribe["path"] = p;
+    subscribe["requestId"] = newRequestId();
+    if (!attribute.empty()) {
+      subscribe["attribute"] = attribute;
+    }
+    jsoncons::json result = query(subscribe);
+    if (statusOf(result) != 200) {
+      response = errorResponse(result);
+      break;
+    }
+    subscriptionIds.push_back(result["subscriptionId"].as<std::string>());
+  }
+
+  // all or nothing
+  if (response.status != 200) {
+    for (const auto &id : subscriptionIds) {
+      jsoncons::json unsubscribe;
+      unsubscribe["action"] = "unsubscribe";
+      unsubscribe["subscriptionId"] = id;
+      unsubscribe["requestId"] = newRequestId();
+      query(unsubscribe);
+    }
+    subscriptionIds.clear();
+  }
+  return response;
+}
+
+}
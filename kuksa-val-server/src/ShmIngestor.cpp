@@ -0,0 +1,261 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "ShmIngestor.hpp"
+
+#include <algorithm>
+#include <new>
+
+#include "ILogger.hpp"
+#include "IVssDatabase.hpp"
+
+namespace {
+  uint32_t roundUp(uint32_t capacity) {
+    uint32_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  bool toVssValue(const ShmRing::Record &record, VssValue &value) {
+    switch (static_cast<ShmRing::ValueType>(record.type)) {
+      case ShmRing::ValueType::Bool:
+        value = VssValue::fromBool(record.value.b);
+        return true;
+      case ShmRing::ValueType::Int64:
+        value = VssValue::fromInt64(record.value.i64);
+        return true;
+      case ShmRing::ValueType::UInt64:
+        value = VssValue::fromUInt64(record.value.u64);
+        return true;
+      case ShmRing::ValueType::Float:
+        value = VssValue::fromFloat(record.value.f);
+        return true;
+      case ShmRing::ValueType::Double:
+        value = VssValue::fromDouble(record.value.d);
+        return true;
+    }
+    return false;
+  }
+}
+
+constexpr uint32_t ShmIngestor::DefaultCapacity;
+constexpr uint32_t ShmIngestor::DefaultSignalCapacity;
+
+ShmIngestor::ShmIngestor(std::shared_ptr<ILogger> loggerUtil,
+                         std::shared_ptr<IVssDatabase> database,
+                         size_t batchSize,
+                         std::chrono::microseconds pollInterval)
+  : logger_(loggerUtil), database_(database), batchSize_(std::max<size_t>(batchSize, 1)),
+    pollInterval_(pollInterval), running_(false) {
+  batch_.reserve(batchSize_);
+}
+
+ShmIngestor::~ShmIngestor() {
+  stop();
+  for (auto &feeder : feeders_) {
+    munmap(feeder->header, feeder->size);
+    shm_unlink(feeder->segment.c_str());
+  }
+}
+
+boost::program_options::options_description& ShmIngestor::getOptions() {
+  static boost::program_options::options_description shm_desc("Shared Memory Feeder Options");
+  shm_desc.add_options()(
+      "shm.feeder", boost::program_options::value<std::vector<std::string>>()->composing(),
+      "Name of a local feeder writing values to a shared memory ring "
+      "\"/kuksa-feeder-<name>\". The server creates the ring, the option can "
+      "be given multiple times")(
+      "shm.ring-size", boost::program_options::value<uint32_t>()->default_value(DefaultCapacity),
+      "Number of values each ring can buffer, rounded up to a power of two. "
+      "Values written to a full ring are dropped")(
+      "shm.signals", boost::program_options::value<uint32_t>()->default_value(DefaultSignalCapacity),
+      "Number of distinct signals each feeder can write")(
+      "shm.batch-size", boost::program_options::value<size_t>()->default_value(256),
+      "Number of values taken from a ring at a time")(
+      "shm.poll-interval", boost::program_options::value<unsigned>()->default_value(200),
+      "Microseconds to wait before looking at the rings again once they are all empty");
+  return shm_desc;
+}
+
+void ShmIngestor::addFeeder(const std::string &name, uint32_t capacity, uint32_t signalCapacity) {
+  if (capacity == 0 || capacity > (1u << 31) || signalCapacity == 0) {
+    throw std::invalid_argument("Invalid ring size for feeder " + name);
+  }
+  std::unique_ptr<Feeder> feeder(new Feeder);
+  feeder->name = name;
+  feeder->segment = ShmRing::segmentName(name);
+  capacity = roundUp(capacity);
+  feeder->size = ShmRing::segmentSize(capacity, signalCapacity);
+
+  // a ring left by an earlier run may have another layout, start afresh
+  shm_unlink(feeder->segment.c_str());
+  int fd = shm_open(feeder->segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot create ring " + feeder->segment);
+  }
+  if (ftruncate(fd, feeder->size) != 0) {
+    int error = errno;
+    close(fd);
+    shm_unlink(feeder->segment.c_str());
+    throw std::system_error(error, std::generic_category(), "Cannot size ring " + feeder->segment);
+  }
+  void *mapping = mmap(nullptr, feeder->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int error = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(feeder->segment.c_str());
+    throw std::system_error(error, std::generic_category(), "Cannot map ring " + feeder->segment);
+  }
+
+  // the segment is zero filled, which is a valid state of all atomics
+  auto header = new (mapping) ShmRing::Header;
+  header->version = ShmRing::Version;
+  header->capacity = capacity;
+  header->signalCapacity = signalCapacity;
+  header->magic.store(ShmRing::Magic, std::memory_order_release);
+  feeder->header = header;
+  feeder->capacity = capacity;
+  feeder->signalCapacity = signalCapacity;
+  feeder->signalTable = ShmRing::signals(header);
+  feeder->records = ShmRing::records(header);
+
+  logger_->Log(LogLevel::INFO, "ShmIngestor: Created ring " + feeder->segment + " for " +
+               std::to_string(capacity) + " values of " + std::to_string(signalCapacity) + " signals");
+  feeders_.push_back(std::move(feeder));
+}
+
+void ShmIngestor::start() {
+  if (running_.exchange(true)) {
+    return;
+  }
+  thread_ = std::thread(&ShmIngestor::run, this);
+}
+
+void ShmIngestor::stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+size_t ShmIngestor::drainOnce() {
+  size_t total = 0;
+  for (auto &feeder : feeders_) {
+    ShmRing::Header *header = feeder->header;
+    uint64_t tail = feeder->tail;
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    if (head - tail > feeder->capacity) {
+      // head is written by the feeder, skip whatever it claims to have written
+      if (!feeder->corrupted) {
+        logger_->Log(LogLevel::ERROR, "ShmIngestor: Feeder " + feeder->name +
+                     " corrupted the head of its ring, skipping its values");
+        feeder->corrupted = true;
+      }
+      feeder->tail = head;
+      header->tail.store(head, std::memory_order_release);
+      continue;
+    }
+    size_t count = std::min<uint64_t>(head - tail, batchSize_);
+
+    // copy the batch out and release the slots before applying it, so that
+    // the feeder does not wait for the database
+    uint64_t mask = feeder->capacity - 1;
+    batch_.clear();
+    for (size_t i = 0; i < count; i++) {
+      batch_.push_back(feeder->records[(tail + i) & mask]);
+    }
+    feeder->tail = tail + count;
+    header->tail.store(feeder->tail, std::memory_order_release);
+
+    for (const auto &record : batch_) {
+      apply(*feeder, record);
+    }
+    total += count;
+
+    uint64_t dropped = header->dropped.load(std::memory_order_relaxed);
+    auto now = std::chrono::steady_clock::now();
+    if (dropped != feeder->reportedDropped && now - feeder->reportedAt >= std::chrono::seconds(10)) {
+      logger_->Log(LogLevel::WARNING, "ShmIngestor: Feeder " + feeder->name + " dropped " +
+                   std::to_string(dropped - feeder->reportedDropped) + " values, its ring was full");
+      feeder->reportedDropped = dropped;
+      feeder->reportedAt = now;
+    }
+  }
+  return total;
+}
+
+ShmIngestor::Signal& ShmIngestor::resolve(Feeder &feeder, uint32_t id) {
+  if (id >= feeder.signals.size()) {
+    feeder.signals.resize(id + 1);
+  }
+  Signal &signal = feeder.signals[id];
+  if (signal.resolved) {
+    return signal;
+  }
+  signal.resolved = true;
+
+  const ShmRing::SignalEntry &entry = feeder.signalTable[id];
+  std::string path(entry.path, strnlen(entry.path, ShmRing::MaxPathLength));
+  VSSPath vssPath = VSSPath::fromVSS(path);
+  if (!database_->pathExists(vssPath)) {
+    logger_->Log(LogLevel::WARNING, "ShmIngestor: Feeder " + feeder.name + " writes to unknown path " + path);
+  } else if (!database_->pathIsWritable(vssPath)) {
+    logger_->Log(LogLevel::WARNING, "ShmIngestor: Feeder " + feeder.name + " writes to path " + path +
+                 ", which is no sensor or actuator");
+  } else {
+    signal.path = vssPath;
+  }
+  return signal;
+}
+
+void ShmIngestor::apply(Feeder &feeder, const ShmRing::Record &record) {
+  // signalCount is published before any record using the signal
+  if (record.signal >= feeder.signalCapacity ||
+      record.signal >= feeder.header->signalCount.load(std::memory_order_acquire)) {
+    return;
+  }
+  Signal &signal = resolve(feeder, record.signal);
+  VssValue value;
+  if (!signal.path || !toVssValue(record, value)) {
+    return;
+  }
+  try {
+    database_->setSignalValue(*signal.path, "value", value, record.timestampNs);
+    signal.failing = false;
+  } catch (std::exception &e) {
+    if (!signal.failing) {
+      logger_->Log(LogLevel::WARNING, "ShmIngestor: Cannot set " + signal.path->getVSSPath() +
+                   " from feeder " + feeder.name + ": " + e.what());
+      signal.failing = true;
+    }
+  }
+}
+
+void ShmIngestor::run() {
+  logger_->Log(LogLevel::VERBOSE, "ShmIngestor: Started ingestor thread");
+  while (running_.load()) {
+    if (drainOnce() == 0) {
+      std::this_thread::sleep_for(pollInterval_);
+    }
+  }
+}
@@ -0,0 +1,199 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "SseStream.hpp"
+
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#include "ISubscriptionHandler.hpp"
+#include "KuksaChannel.hpp"
+
+SseStream::SseStream(const std::string &name, size_t replayCapacity,
+                     std::chrono::steady_clock::duration resumeTimeout)
+  : name_(name), replayCapacity_(replayCapacity), resumeTimeout_(resumeTimeout),
+    detachedAt_(std::chrono::steady_clock::now()) {
+}
+
+bool SseStream::publish(const OutboundMessage &message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!sink_ && std::chrono::steady_clock::now() - detachedAt_ > resumeTimeout_) {
+    return false;
+  }
+
+  uint64_t seq = ++lastSeq_;
+  // messages are compact JSON, so they fit into a single data line
+  auto event = std::make_shared<std::string>();
+  event->reserve(message.size() + name_.size() + 32);
+  event->append("id: ").append(name_).append("-").append(std::to_string(seq)).append("\ndata: ");
+  event->append(message.head);
+  if (message.body) {
+    event->append(*message.body);
+  }
+  event->append(message.tail).append("\n\n");
+
+  if (replayCapacity_ > 0) {
+    if (replay_.size() >= replayCapacity_) {
+      replay_.pop_front();
+    }
+    replay_.emplace_back(seq, event);
+  }
+  if (sink_) {
+    sink_(std::move(event));
+  }
+  return true;
+}
+
+uint64_t SseStream::attach(Sink sink, uint64_t lastSeen) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &entry : replay_) {
+    if (entry.first > lastSeen) {
+      sink(entry.second);
+    }
+  }
+  sink_ = std::move(sink);
+  return ++attachment_;
+}
+
+void SseStream::detach(uint64_t attachment) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (attachment == attachment_ && sink_) {
+    sink_ = nullptr;
+    detachedAt_ = std::chrono::steady_clock::now();
+  }
+}
+
+bool SseStream::expired(std::chrono::steady_clock::time_point now) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !sink_ && now - detachedAt_ > resumeTimeout_;
+}
+
+SseStreamRegistry::SseStreamRegistry(ConnectionRegistry &connections)
+  : connections_(connections), replayCapacity_(256), resumeTimeout_(std::chrono::seconds(30)) {
+}
+
+void SseStreamRegistry::configure(size_t replayCapacity, std::chrono::steady_clock::duration resumeTimeout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  replayCapacity_ = replayCapacity;
+  resumeTimeout_ = resumeTimeout;
+}
+
+void SseStreamRegistry::setSubscriptionHandler(std::weak_ptr<ISubscriptionHandler> subHandler) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  subHandler_ = std::move(subHandler);
+}
+
+std::chrono::steady_clock::duration SseStreamRegistry::resumeTimeout() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return resumeTimeout_;
+}
+
+std::shared_ptr<SseStream> SseStreamRegistry::create() {
+  thread_local boost::uuids::random_generator generator;
+  std::string name = boost::uuids::to_string(generator());
+
+  removeExpired();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto stream = std::make_shared<SseStream>(name, replayCapacity_, resumeTimeout_);
+  stream->connID_ = connections_.add(stream);
+  byName_[stream->name()] = stream;
+  return stream;
+}
+
+std::shared_ptr<SseStream> SseStreamRegistry::resume(const std::string &lastEventId, uint64_t &lastSeen) {
+  std::string name;
+  if (!parseEventId(lastEventId, name, lastSeen)) {
+    return nullptr;
+  }
+  removeExpired();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto stream = byName_.find(name);
+  return stream != byName_.end() ? stream->second : nullptr;
+}
+
+void SseStreamRegistry::remove(const std::shared_ptr<SseStream> &stream) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (byName_.erase(stream->name()) == 0) {
+      return;
+    }
+    connections_.remove(stream->connID());
+  }
+  unsubscribe({stream});
+}
+
+bool SseStreamRegistry::parseEventId(const std::string &eventId, std::string &name, uint64_t &seq) {
+  size_t separator = eventId.rfind('-');
+  if (separator == std::string::npos || separator == 0 || separator == eventId.size() - 1) {
+    return false;
+  }
+  try {
+    size_t parsed;
+    seq = std::stoull(eventId.substr(separator + 1), &parsed);
+    if (parsed != eventId.size() - separator - 1) {
+      return false;
+    }
+  } catch (std::exception &) {
+    return false;
+  }
+  name = eventId.substr(0, separator);
+  return true;
+}
+
+size_t SseStreamRegistry::removeExpired() {
+  std::vector<std::shared_ptr<SseStream>> expired;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    for (auto stream = byName_.begin(); stream != byName_.end();) {
+      if (stream->second->expired(now)) {
+        connections_.remove(stream->second->connID());
+        expired.push_back(std::move(stream->second));
+        stream = byName_.erase(stream);
+      } else {
+        ++stream;
+      }
+    }
+  }
+  unsubscribe(expired);
+  return expired.size();
+}
+
+void SseStreamRegistry::unsubscribe(const std::vector<std::shared_ptr<SseStream>> &streams) {
+  if (streams.empty()) {
+    return;
+  }
+  std::shared_ptr<ISubscriptionHandler> subHandler;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subHandler = subHandler_.lock();
+  }
+  if (!subHandler) {
+    return;
+  }
+  // the subscriptions have been made on a channel with the id of the stream
+  for (const auto &stream : streams) {
+    KuksaChannel channel;
+    channel.setConnID(stream->connID());
+    subHandler->unsubscribeAll(channel);
+  }
+}
@@ -22,8 +22,10 @@
 #include "SubscriptionHandler.hpp"
 
 #include <unistd.h>  // usleep
+#include <algorithm>
 #include <string>
 
+#include <boost/algorithm/string/join.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
@@ -34,6 +36,7 @@
 #include "ILogger.hpp"
 #include "JsonResponses.hpp"
 #include "KuksaChannel.hpp"
+#include "MessageEncoding.hpp"
 #include "VssDatabase.hpp"
 #include "exception.hpp"
 #include "visconf.hpp"
@@ -44,20 +47,42 @@ using namespace std;
 using namespace jsoncons::jsonpath;
 using jsoncons::json;
 
+constexpr size_t SubscriptionHandler::DefaultQueueSize;
+
 SubscriptionHandler::SubscriptionHandler(
     std::shared_ptr<ILogger> loggerUtil, std::shared_ptr<IServer> wserver,
     std::shared_ptr<IAuthenticator> authenticate,
-    std::shared_ptr<IAccessChecker> checkAcc)
-    : publishers_() {
+    std::shared_ptr<IAccessChecker> checkAcc,
+    unsigned workers, size_t queueSize)
+    : publishers_(), threadRun(false), dropped_(0) {
   logger = loggerUtil;
   server = wserver;
   validator = authenticate;
   checkAccess = checkAcc;
+
+  if (workers == 0) {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned i = 0; i < workers; i++) {
+    workers_.emplace_back(new Worker(queueSize));
+  }
   startThread();
 }
 
 SubscriptionHandler::~SubscriptionHandler() { stopThread(); }
 
+boost::program_options::options_description& SubscriptionHandler::getOptions() {
+  static boost::program_options::options_description subscription_desc("Subscription Options");
+  subscription_desc.add_options()(
+      "subscription.workers", boost::program_options::value<unsigned>()->default_value(0),
+      "Number of threads sending notifications to subscribers. Subscribers are "
+      "distributed across threads by connection. 0 uses one thread per CPU core")(
+      "subscription.queue-size", boost::program_options::value<size_t>()->default_value(DefaultQueueSize),
+      "Number of notifications each of these threads can buffer. Notifications "
+      "exceeding this are dropped");
+  return subscription_desc;
+}
+
 SubscriptionId SubscriptionHandler::subscribe(KuksaChannel& channel,
                                               std::shared_ptr<IVssDatabase> db,
                                               const string& path,
@@ -66,52 +91,99 @@ SubscriptionId SubscriptionHandler::subscribe(KuksaChannel& channel,
   SubscriptionId subId = boost::uuids::random_generator()();
 
   VSSPath vssPath = VSSPath::fromVSS(path);
+  std::vector<std::string> pattern = SubscriptionTrie::split(vssPath.getVSSPath());
+
+  bool isPattern = pattern.empty() || SubscriptionTrie::hasWildcard(pattern);
+  if (!isPattern) {
+    if (!db->pathExists(vssPath)) {
+      throw noPathFoundonTree(path);
+    }
+    // a branch is subscribed as pattern covering all signals below
+    isPattern = !db->pathIsReadable(vssPath);
+  }
+
+  if (!isPattern) {
+    if (!checkAccess->checkReadAccess(channel, vssPath)) {
+      stringstream msg;
+      msg << "no permission to subscribe to path " << path;
+      throw noPermissionException(msg.str());
+    }
+  } else {
+    // Only signals existing in the model can ever be published, so the
+    // pattern has to match at least one of them. Signals the client may not
+    // read are skipped when notifying
+    std::vector<std::string> prefix;
+    for (const auto& element : pattern) {
+      if (SubscriptionTrie::hasWildcard({element})) {
+        break;
+      }
+      prefix.push_back(element);
+    }
+    VSSPath searchPath = prefix.empty() ? VSSPath::fromVSSGen2("*")
+                                        : VSSPath::fromVSSGen2(boost::algorithm::join(prefix, "/"));
+    bool matchesSignal = false, readable = false;
+    for (const auto& leaf : db->getLeafPaths(searchPath)) {
+      if (SubscriptionTrie::matches(pattern, SubscriptionTrie::split(leaf.getVSSPath()))) {
+        matchesSignal = true;
+        if (checkAccess->checkReadAccess(channel, leaf)) {
+          readable = true;
+          break;
+        }
+      }
+    }
+    if (!matchesSignal) {
+      throw noPathFoundonTree(path);
+    }
+    if (!readable) {
+      stringstream msg;
+      msg << "no permission to subscribe to any signal matching " << path;
+      throw noPermissionException(msg.str());
+    }
+  }
 
-  if (!db->pathExists(vssPath)) {
-    throw noPathFoundonTree(path);
-  } else if (!db->pathIsReadable(vssPath)) {
-    stringstream msg;
-    msg << path
-        << " is not a sensor, actor or attribute leaf. Subscribe not supported";
-    logger->Log(LogLevel::INFO,
-                "SubscriptionHandler::subscribe : " + msg.str());
-    throw noPathFoundonTree(msg.str());
-  } else if (!checkAccess->checkReadAccess(channel, vssPath)) {
-    stringstream msg;
-    msg << "no permission to subscribe to path " << path;
-    throw noPermissionException(msg.str());
-  }
-
-  subscription_keys_t subsKey = subscription_keys_t(vssPath.getVSSPath(), attr);
   logger->Log(LogLevel::VERBOSE,
               string("SubscriptionHandler::subscribe: Subscribing to ") +
                   vssPath.getVSSPath());
 
-  std::unique_lock<std::mutex> lock(accessMutex);
-  subscriptions[subsKey][subId] = channel;
+  std::unique_lock<std::shared_timed_mutex> lock(accessMutex);
+  subscriptions[attr].insert(pattern, SubscriptionTrie::Entry{subId, channel, isPattern});
+  subscriptionLocations_.emplace(subId, SubscriptionLocation{attr, std::move(pattern), channel.getConnID()});
+  connectionSubscriptions_[channel.getConnID()].insert(subId);
   return subId;
 }
 
+void SubscriptionHandler::removeSubscription(const SubscriptionId& subId,
+                                             const SubscriptionLocation& location) {
+  auto trie = subscriptions.find(location.attribute);
+  if (trie == subscriptions.end()) {
+    return;
+  }
+  trie->second.remove(location.pattern, subId);
+  if (trie->second.empty()) {
+    subscriptions.erase(trie);
+  }
+}
+
 int SubscriptionHandler::unsubscribe(SubscriptionId subscribeID) {
-  bool found_subscription = false;
   logger->Log(LogLevel::VERBOSE,
               string("SubscriptionHandler::unsubscribe: Unsubscribe on ") +
                   boost::uuids::to_string(subscribeID));
-  std::unique_lock<std::mutex> lock(accessMutex);
-  for (auto& sub : subscriptions) {
-    auto subsforpath = &(sub.second);
-    auto subid = subsforpath->find(subscribeID);
-    if (subid != subsforpath->end()) {
-      logger->Log(
-          LogLevel::VERBOSE,
-          string("SubscriptionHandler::unsubscribe: Unsubscribing path ") +
-              sub.first.path);
-      subsforpath->erase(subid);
-      found_subscription = true;
-    }
-  }
-  if (found_subscription) return 0;
-  return -1;
+  std::unique_lock<std::shared_timed_mutex> lock(accessMutex);
+  auto location = subscriptionLocations_.find(subscribeID);
+  if (location == subscriptionLocations_.end()) {
+    return -1;
+  }
+  removeSubscription(subscribeID, location->second);
+
+  auto connection = connectionSubscriptions_.find(location->second.connID);
+  if (connection != connectionSubscriptions_.end()) {
+    connection->second.erase(subscribeID);
+    if (connection->second.empty()) {
+      connectionSubscriptions_.erase(connection);
+    }
+  }
+  subscriptionLocations_.erase(location);
+  return 0;
 }
 
 int SubscriptionHandler::unsubscribeAll(KuksaChannel channel) {
@@ -120,131 +192,246 @@ int SubscriptionHandler::unsubscribeAll(KuksaChannel channel) {
                      "for channel ") +
                   std::to_string(channel.getConnID()));
 
-  std::unique_lock<std::mutex> lock(accessMutex);
-  for (auto& subs : subscriptions) {
-    auto condition =
-        [channel](const std::pair<SubscriptionId, KuksaChannel>& pair) {
-          return (pair.second == channel);
-        };
-
-    auto found =
-        std::find_if(std::begin(subs.second), std::end(subs.second), condition);
-
-    if (found != std::end(subs.second)) {
-      subs.second.erase(found);
-      logger->Log(LogLevel::VERBOSE,
-                  "SubscriptionHandler::unsubscribeAll: Unsubscribing " +
-                      subs.first.path + " for " +
-                      std::to_string(channel.getConnID()));
+  std::unique_lock<std::shared_timed_mutex> lock(accessMutex);
+  auto connection = connectionSubscriptions_.find(channel.getConnID());
+  if (connection == connectionSubscriptions_.end()) {
+    return 0;
+  }
+  for (const auto& subId : connection->second) {
+    auto location = subscriptionLocations_.find(subId);
+    if (location != subscriptionLocations_.end()) {
+      removeSubscription(subId, location->second);
+      subscriptionLocations_.erase(location);
     }
   }
+  logger->Log(LogLevel::VERBOSE,
+              "SubscriptionHandler::unsubscribeAll: Removed " + std::to_string(connection->second.size()) +
+                  " subscriptions for " + std::to_string(channel.getConnID()));
+  connectionSubscriptions_.erase(connection);
   return 0;
 }
 
 std::shared_ptr<IServer> SubscriptionHandler::getServer() { return server; }
 
+bool SubscriptionHandler::claimRevision(const std::string& path, const std::string& attr,
+                                        uint64_t revision) {
+  if (revision == 0) {
+    return true;
+  }
+  uint64_t& published = publishedRevisions_[subscription_keys_t(path, attr)];
+  if (revision <= published) {
+    return false;
+  }
+  published = revision;
+  return true;
+}
+
 int SubscriptionHandler::publishForVSSPath(const VSSPath path,
                                            const std::string& vssdatatype,
                                            const std::string& attr,
-                                           const jsoncons::json& data) {
+                                           const jsoncons::json& data,
+                                           uint64_t revision) {
+  std::stringstream ss;
+  ss << "SubscriptionHandler::publishForVSSPath: set " << attr << " "
+     << data["dp"][attr] << " for path " << path.to_string();
+
+  std::vector<Notification> notifications;
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(accessMutex);
+    prepareNotifications(path, vssdatatype, attr, data, ss.str(), notifications);
+
+    // the expensive part is done, only ordering and enqueueing are
+    // serialized. Sets of signals without subscribers skip this entirely
+    if (!notifications.empty()) {
+      std::lock_guard<std::mutex> ordering(revisionMutex_);
+      if (!claimRevision(path.getVSSPath(), attr, revision)) {
+        logger->Log(LogLevel::VERBOSE, "SubscriptionHandler::publishForVSSPath: dropped update of " +
+                    attr + " of " + path.getVSSPath() + ", a newer one has been published already");
+        return 0;
+      }
+      for (auto& notification : notifications) {
+        enqueue(std::move(notification));
+      }
+    }
+  }
+
   // Publish MQTT
   for (auto& publisher : publishers_) {
     publisher->sendPathValue(path.getVSSPath(), data["dp"][attr]);
   }
-  std::stringstream ss;
-  ss << "SubscriptionHandler::publishForVSSPath: set " << attr << " "
-     << data["dp"][attr] << " for path " << path.to_string();
   logger->Log(LogLevel::VERBOSE, ss.str());
+  return 0;
+}
 
-  std::unique_lock<std::mutex> lock(accessMutex);
-  subscription_keys_t subsKey = subscription_keys_t(path.getVSSPath(), attr);
-  auto handle = subscriptions.find(subsKey);
+void SubscriptionHandler::prepareNotifications(const VSSPath& path,
+                                               const std::string& vssdatatype,
+                                               const std::string& attr,
+                                               const jsoncons::json& data,
+                                               const std::string& description,
+                                               std::vector<Notification>& notifications) {
+  auto handle = subscriptions.find(attr);
   if (handle == subscriptions.end()) {
+    // no subscriptions for attribute
+    return;
+  }
+  std::vector<const SubscriptionTrie::Entry*> subscribers;
+  handle->second.match(SubscriptionTrie::split(path.getVSSPath()), subscribers);
+  if (subscribers.empty()) {
     // no subscriptions for path
-    return 0;
+    return;
   }
 
-  for (auto subID : handle->second) {
-    std::lock_guard<std::mutex> lock(subMutex);
-    tuple<SubscriptionId, KuksaChannel, std::string, json> newSub;
+  // serialize update once, it is shared by all subscribers
+  auto update = std::make_shared<PreparedUpdate>();
+  jsoncons::json updateData = data;
+  JsonResponses::convertJSONTimeStampToISO8601(updateData["dp"]);
+  bool hasGrpc = false;
+  bool hasValV1 = false;
+  for (auto subscriber : subscribers) {
+    if (subscriber->channel.getType() == KuksaChannel::Type::GRPC) {
+      hasGrpc = true;
+    } else if (subscriber->channel.getType() == KuksaChannel::Type::GRPC_VAL_V1) {
+      hasValV1 = true;
+    } else {
+      auto& body = update->bodies[static_cast<size_t>(subscriber->channel.getEncoding())];
+      if (!body) {
+        body = std::make_shared<const std::string>(
+            MessageEncoding::encode(updateData, subscriber->channel.getEncoding()));
+      }
+    }
+  }
+  if (hasGrpc) {
+    try {
+      grpcHandler::grpc_fill_subscribe_response(path.getVSSPath(), vssdatatype, attr, data, &update->grpcResponse);
+    } catch (std::exception &e) {
+      logger->Log(LogLevel::WARNING, "SubscriptionHandler::publishForVSSPath: can not convert update for GRPC: "
+                  + string(e.what()));
+    }
+  }
+  if (hasValV1) {
+    try {
+      grpcHandler::grpc_fill_entry_update(path.getVSSPath(), vssdatatype, attr, data, &update->valUpdate);
+    } catch (std::exception &e) {
+      logger->Log(LogLevel::WARNING, "SubscriptionHandler::publishForVSSPath: can not convert update for "
+                  "kuksa.val.v1: " + string(e.what()));
+    }
+  }
+
+  for (auto subscriber : subscribers) {
+    // the pattern may cover signals the subscriber is not allowed to read
+    if (subscriber->isPattern) {
+      KuksaChannel channel = subscriber->channel;
+      if (!checkAccess->checkReadAccess(channel, path)) {
+        continue;
+      }
+    }
     logger->Log(LogLevel::VERBOSE,
                 "SubscriptionHandler::publishForVSSPath: new " + attr +
-                    " set at path " + boost::uuids::to_string(subID.first) +
-                    ": " + ss.str());
-    newSub = std::make_tuple(subID.first, subID.second, vssdatatype, data);
-    buffer.push(newSub);
-    c.notify_one();
+                    " set at path " + boost::uuids::to_string(subscriber->id) +
+                    ": " + description);
+    notifications.push_back(Notification{subscriber->id, subscriber->channel, update});
   }
-  return 0;
 }
 
-void* SubscriptionHandler::subThreadRunner() {
+/** Selects the worker for a connection. Connection ids carry a generation in
+ *  their upper half, so mix the bits before distributing them
+ */
+SubscriptionHandler::Worker& SubscriptionHandler::workerFor(const KuksaChannel& channel) {
+  uint64_t hash = (channel.getConnID() * 0x9E3779B97F4A7C15ULL) >> 32;
+  return *workers_[hash % workers_.size()];
+}
+
+void SubscriptionHandler::enqueue(Notification &&notification) {
+  Worker& worker = workerFor(notification.channel);
+  if (!worker.queue.tryPush(std::move(notification))) {
+    uint64_t dropped = ++dropped_;
+    if (dropped == 1 || dropped % 1000 == 0) {
+      logger->Log(LogLevel::WARNING,
+                  "SubscriptionHandler::publishForVSSPath: notification queue full, dropped " +
+                      std::to_string(dropped) + " notifications so far");
+    }
+    return;
+  }
+  // pairs with the fence in workerRunner: either the worker sees the new
+  // notification before going to sleep, or we see it sleeping
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (worker.sleeping.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.wakeup.notify_one();
+  }
+}
+
+void SubscriptionHandler::sendNotification(const Notification& notification) {
+  const KuksaChannel& channel = notification.channel;
+  if (channel.getType() == KuksaChannel::Type::GRPC) {
+    auto sink = channel.grpcSink.lock();
+    if (!sink || !sink->send(notification.update->grpcResponse)) {
+      this->unsubscribeAll(channel);
+    }
+  } else if (channel.getType() == KuksaChannel::Type::GRPC_VAL_V1) {
+    auto sink = channel.valSink.lock();
+    if (!sink || !sink->send(notification.update->valUpdate)) {
+      this->unsubscribeAll(channel);
+    }
+  } else {  // WEBSOCKET
+    OutboundMessage message;
+    message.key = boost::uuids::to_string(notification.subId);
+    MessageEncoding::subscriptionEnvelope(channel.getEncoding(), message.key, message.head, message.tail);
+    message.body = notification.update->bodies[static_cast<size_t>(channel.getEncoding())];
+    bool connectionexist =
+        getServer()->SendToConnection(channel.getConnID(), message);
+    if (!connectionexist) {
+      this->unsubscribeAll(channel);
+    }
+  }
+}
+
+void SubscriptionHandler::workerRunner(Worker& worker) {
   logger->Log(LogLevel::VERBOSE,
               "SubscribeThread: Started Subscription Thread!");
 
-  while (isThreadRunning()) {
-    if (buffer.size() > 0) {
-      std::unique_lock<std::mutex> lock(subMutex);
-      auto newSub = buffer.front();
-      buffer.pop();
-
-      KuksaChannel channel = std::get<1>(newSub);
-      std::string vssdatatype = std::get<2>(newSub);
-      jsoncons::json data = std::get<3>(newSub);
-
-      jsoncons::json answer;
-      answer["action"] = "subscription";
-      answer["subscriptionId"] = boost::uuids::to_string(std::get<0>(newSub));
-
-      JsonResponses::convertJSONTimeStampToISO8601(data["dp"]);
-      answer.insert_or_assign("data", data);
-
-      stringstream ss;
-      ss << pretty_print(answer);
-      string message = ss.str();
-      if (channel.getType() == KuksaChannel::Type::GRPC) {
-        // check for subscriptionID in channel
-        auto handle = channel.grpcSubsMap->find(std::get<0>(newSub));
-        if (handle == channel.grpcSubsMap->end()) {
-          logger->Log(LogLevel::WARNING, "Subscription thread: No subscription for requested path in GRPC");
-          continue;
-        }
-        grpcHandler::grpc_send_object_to_stream(logger, vssdatatype, answer,
-                                                handle->second);
-      } else {  // WEBSOCKET
-        bool connectionexist =
-            getServer()->SendToConnection(channel.getConnID(), message);
-        if (!connectionexist) {
-          this->unsubscribeAll(channel);
-        }
-      }
-
-    } else {
-      std::unique_lock<std::mutex> lock(subMutex);
-      c.wait(lock);
+  Notification notification;
+  while (threadRun.load()) {
+    if (worker.queue.tryPop(notification)) {
+      sendNotification(notification);
+      notification = Notification();
+      continue;
     }
+
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    worker.sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    worker.wakeup.wait(lock, [this, &worker]() {
+      return !threadRun.load() || !worker.queue.empty();
+    });
+    worker.sleeping.store(false, std::memory_order_relaxed);
   }
 
   logger->Log(LogLevel::VERBOSE,
               "SubscribeThread: Subscription handler thread stopped running");
-
-  return NULL;
 }
 
 int SubscriptionHandler::startThread() {
-  subThread = thread(&SubscriptionHandler::subThreadRunner, this);
+  if (isThreadRunning()) {
+    return 0;
+  }
   threadRun = true;
+  for (auto& worker : workers_) {
+    worker->thread = thread(&SubscriptionHandler::workerRunner, this, std::ref(*worker));
+  }
   return 0;
 }
 
 int SubscriptionHandler::stopThread() {
   if (isThreadRunning()) {
-    {
-      std::lock_guard<std::mutex> lock(subMutex);
-      threadRun = false;
-      c.notify_one();
+    threadRun = false;
+    for (auto& worker : workers_) {
+      {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->wakeup.notify_all();
+      }
+      worker->thread.join();
     }
-    subThread.join();
   }
   return 0;
 }
@@ -0,0 +1,206 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "SubscriptionTrie.hpp"
+
+#include <algorithm>
+
+#include <boost/algorithm/string.hpp>
+
+namespace {
+  const std::string AnyElement = "*";
+  const std::string AnyDepth = "**";
+
+  void appendEntries(const std::vector<SubscriptionTrie::Entry> &entries,
+                     std::vector<const SubscriptionTrie::Entry*> &matches) {
+    for (const auto &entry : entries) {
+      matches.push_back(&entry);
+    }
+  }
+
+  bool removeEntry(std::vector<SubscriptionTrie::Entry> &entries, const SubscriptionId &id) {
+    auto entry = std::find_if(entries.begin(), entries.end(),
+                              [&id](const SubscriptionTrie::Entry &e) { return e.id == id; });
+    if (entry == entries.end()) {
+      return false;
+    }
+    entries.erase(entry);
+    return true;
+  }
+}
+
+bool SubscriptionTrie::Node::empty() const {
+  return children.empty() && !anyChild && !anyDepth &&
+         exact.empty() && subtree.empty() && below.empty();
+}
+
+void SubscriptionTrie::insert(const std::vector<std::string> &pattern, Entry entry) {
+  Node *node = &root_;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    std::unique_ptr<Node> *next;
+    if (pattern[i] == AnyDepth) {
+      if (i == pattern.size() - 1) {
+        node->below.push_back(std::move(entry));
+        return;
+      }
+      next = &node->anyDepth;
+    } else if (pattern[i] == AnyElement) {
+      next = &node->anyChild;
+    } else {
+      next = &node->children[pattern[i]];
+    }
+    if (!*next) {
+      next->reset(new Node());
+    }
+    node = next->get();
+  }
+
+  if (hasWildcard(pattern)) {
+    node->exact.push_back(std::move(entry));
+  } else {
+    node->subtree.push_back(std::move(entry));
+  }
+}
+
+bool SubscriptionTrie::remove(const std::vector<std::string> &pattern, const SubscriptionId &id) {
+  return removeAt(root_, pattern, 0, id);
+}
+
+bool SubscriptionTrie::removeAt(Node &node, const std::vector<std::string> &pattern, size_t pos,
+                                const SubscriptionId &id) {
+  if (pos == pattern.size()) {
+    return removeEntry(hasWildcard(pattern) ? node.exact : node.subtree, id);
+  }
+
+  const std::string &element = pattern[pos];
+  if (element == AnyDepth && pos == pattern.size() - 1) {
+    return removeEntry(node.below, id);
+  }
+  std::unique_ptr<Node> *next;
+  std::unordered_map<std::string, std::unique_ptr<Node>>::iterator child;
+  if (element == AnyDepth) {
+    next = &node.anyDepth;
+  } else if (element == AnyElement) {
+    next = &node.anyChild;
+  } else {
+    child = node.children.find(element);
+    if (child == node.children.end()) {
+      return false;
+    }
+    next = &child->second;
+  }
+  if (!*next || !removeAt(**next, pattern, pos + 1, id)) {
+    return false;
+  }
+  if ((*next)->empty()) {
+    if (element == AnyDepth || element == AnyElement) {
+      next->reset();
+    } else {
+      node.children.erase(child);
+    }
+  }
+  return true;
+}
+
+void SubscriptionTrie::match(const std::vector<std::string> &path, std::vector<const Entry*> &matches) const {
+  size_t first = matches.size();
+  matchNode(root_, path, 0, matches);
+
+  // "**" may match the same path in different ways
+  if (matches.size() - first > 1) {
+    std::sort(matches.begin() + first, matches.end());
+    matches.erase(std::unique(matches.begin() + first, matches.end()), matches.end());
+  }
+}
+
+void SubscriptionTrie::matchNode(const Node &node, const std::vector<std::string> &path, size_t pos,
+                                 std::vector<const Entry*> &matches) {
+  appendEntries(node.subtree, matches);
+  if (pos == path.size()) {
+    appendEntries(node.exact, matches);
+  } else {
+    appendEntries(node.below, matches);
+
+    auto child = node.children.find(path[pos]);
+    if (child != node.children.end()) {
+      matchNode(*child->second, path, pos + 1, matches);
+    }
+    if (node.anyChild) {
+      matchNode(*node.anyChild, path, pos + 1, matches);
+    }
+  }
+  if (node.anyDepth) {
+    for (size_t skip = pos; skip <= path.size(); skip++) {
+      matchNode(*node.anyDepth, path, skip, matches);
+    }
+  }
+}
+
+bool SubscriptionTrie::empty() const {
+  return root_.empty();
+}
+
+std::vector<std::string> SubscriptionTrie::split(const std::string &vssPath) {
+  std::vector<std::string> elements;
+  if (!vssPath.empty()) {
+    boost::split(elements, vssPath, boost::is_any_of("/"));
+  }
+  return elements;
+}
+
+bool SubscriptionTrie::hasWildcard(const std::vector<std::string> &pattern) {
+  return std::any_of(pattern.begin(), pattern.end(), [](const std::string &element) {
+    return element == AnyElement || element == AnyDepth;
+  });
+}
+
+bool SubscriptionTrie::matches(const std::vector<std::string> &pattern, const std::vector<std::string> &path) {
+  if (!hasWildcard(pattern)) {
+    return pattern.size() <= path.size() && std::equal(pattern.begin(), pattern.end(), path.begin());
+  }
+  return matchesFrom(pattern, 0, path, 0);
+}
+
+bool SubscriptionTrie::matchesFrom(const std::vector<std::string> &pattern, size_t patternPos,
+                                   const std::vector<std::string> &path, size_t pathPos) {
+  if (patternPos == pattern.size()) {
+    return pathPos == path.size();
+  }
+  const std::string &element = pattern[patternPos];
+  if (element == AnyDepth) {
+    if (patternPos == pattern.size() - 1) {
+      return pathPos < path.size();
+    }
+    for (size_t skip = pathPos; skip <= path.size(); skip++) {
+      if (matchesFrom(pattern, patternPos + 1, path, skip)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (pathPos == path.size()) {
+    return false;
+  }
+  if (element == AnyElement || element == path[pathPos]) {
+    return matchesFrom(pattern, patternPos + 1, path, pathPos + 1);
+  }
+  return false;
+}
@@ -24,7 +24,10 @@
 #include "VssDatabase.hpp"
 #include "ILogger.hpp"
 #include "exception.hpp"
+#include <cmath>
+#include <limits>
 #include <string>
+#include <type_traits>
 #include <boost/algorithm/string.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 
@@ -39,7 +42,7 @@
  *  are not the intention of a client
  */
 template<typename T>
-void checkNumTypes(jsoncons::json &meta, jsoncons::json &val )
+void checkNumTypes(const jsoncons::json &meta, jsoncons::json &val )
 {
     T cval;
     try {
@@ -93,7 +96,7 @@ void checkBoolType(jsoncons::json &val ) {
     }
 }
 
-void checkEnumType(jsoncons::json &enumDefinition, jsoncons::json &val ) {
+void checkEnumType(const jsoncons::json &enumDefinition, jsoncons::json &val ) {
     
     for (const auto& item: enumDefinition.array_range()){
       if(item.as_string() == val){
@@ -129,7 +132,7 @@ void VssDatabase::checkArrayType(std::string& subdatatype, jsoncons::json &val)
 
 /** This will check whether &val val is a valid value for the sensor described
  *  by meta  and whether  it is within the limits defined by VSS if any */
-void VssDatabase::checkAndSanitizeType(jsoncons::json &meta, jsoncons::json &val) {
+void VssDatabase::checkAndSanitizeType(const jsoncons::json &meta, jsoncons::json &val) {
     std::string dt=meta["datatype"].as<std::string>();
     if (dt == "uint8") {
         checkNumTypes<uint8_t>(meta,val);
@@ -183,3 +186,165 @@ void VssDatabase::checkAndSanitizeType(jsoncons::json &meta, jsoncons::json &val
     }
 
 }
+
+
+namespace {
+  /** Whether an integer fits into T. Floating point types take any integer,
+   *  loosing precision like a JSON number does */
+  template<typename T>
+  bool fitsInto(uint64_t val, std::true_type /*integral*/) {
+    return val <= static_cast<uint64_t>(std::numeric_limits<T>::max());
+  }
+  template<typename T>
+  bool fitsInto(uint64_t, std::false_type) {
+    return true;
+  }
+  template<typename T>
+  bool fitsInto(int64_t val, std::true_type /*integral*/) {
+    if (val < 0) {
+      return std::is_signed<T>::value && val >= static_cast<int64_t>(std::numeric_limits<T>::min());
+    }
+    return fitsInto<T>(static_cast<uint64_t>(val), std::true_type());
+  }
+  template<typename T>
+  bool fitsInto(int64_t, std::false_type) {
+    return true;
+  }
+  template<typename T>
+  bool fitsInto(double val, std::true_type /*integral*/) {
+    // digits excludes the sign bit, so 2^digits is the first value beyond max
+    return val >= static_cast<double>(std::numeric_limits<T>::min()) &&
+           val < std::ldexp(1.0, std::numeric_limits<T>::digits);
+  }
+  template<typename T>
+  bool fitsInto(double val, std::false_type) {
+    return !(std::fabs(val) > std::numeric_limits<T>::max()) || std::isinf(val);
+  }
+
+  [[noreturn]] void notConvertible(const VssValue &val, const jsoncons::json &meta) {
+    std::stringstream msg;
+    msg << "Value " << val.toString() << " can not be converted to defined type " << meta["datatype"].as_string();
+    throw outOfBoundException(msg.str());
+  }
+}
+
+/** Native counterpart of checkNumTypes. Numbers are converted if T can
+ *  represent them, strings are parsed the way the JSON path does */
+template<typename T>
+T convertNumValue(const jsoncons::json &meta, const VssValue &val)
+{
+    typedef typename std::is_integral<T>::type integral;
+    T cval;
+    if (val.isUnsigned()) {
+        if (!fitsInto<T>(val.asUInt64(), integral())) {
+            notConvertible(val, meta);
+        }
+        cval = static_cast<T>(val.asUInt64());
+    } else if (val.isSigned()) {
+        if (!fitsInto<T>(val.asInt64(), integral())) {
+            notConvertible(val, meta);
+        }
+        cval = static_cast<T>(val.asInt64());
+    } else if (val.type() == VssValue::Type::FLOAT || val.type() == VssValue::Type::DOUBLE) {
+        double d = val.type() == VssValue::Type::FLOAT ? val.asFloat() : val.asDouble();
+        if (!fitsInto<T>(d, integral())) {
+            notConvertible(val, meta);
+        }
+        cval = static_cast<T>(d);
+    } else if (val.type() == VssValue::Type::STRING) {
+        jsoncons::json jval(val.asString());
+        checkNumTypes<T>(meta, jval);
+        return jval.as<T>();
+    } else {
+        notConvertible(val, meta);
+    }
+
+    if (std::numeric_limits<T>::has_infinity && (cval == std::numeric_limits<T>::infinity() || cval == -std::numeric_limits<T>::infinity()) ) {
+        throw outOfBoundException("Value out of bounds. Reason: Infinity");
+    }
+
+    if ( meta.contains("min") && cval < meta["min"].as<T>() ) {
+        std::stringstream msg;
+        msg << "Value " << +cval << " is out of bounds. Allowed minimum is " <<  meta["min"].as<double>();
+        throw outOfBoundException(msg.str());
+    }
+
+    if ( meta.contains("max") && cval > meta["max"].as<T>() ) {
+        std::stringstream msg;
+        msg << "Value " << +cval << " is out of bounds. Allowed maximum is " <<  meta["max"].as<double>();
+        throw outOfBoundException(msg.str());
+    }
+    return cval;
+}
+
+VssValue VssDatabase::sanitizeValue(const jsoncons::json &meta, VssValue::Type type, const VssValue &val) {
+    switch (type) {
+      case VssValue::Type::UINT8:
+        return VssValue::fromUInt64(convertNumValue<uint8_t>(meta, val), type);
+      case VssValue::Type::INT8:
+        return VssValue::fromInt64(convertNumValue<int8_t>(meta, val), type);
+      case VssValue::Type::UINT16:
+        return VssValue::fromUInt64(convertNumValue<uint16_t>(meta, val), type);
+      case VssValue::Type::INT16:
+        return VssValue::fromInt64(convertNumValue<int16_t>(meta, val), type);
+      case VssValue::Type::UINT32:
+        return VssValue::fromUInt64(convertNumValue<uint32_t>(meta, val), type);
+      case VssValue::Type::INT32:
+        return VssValue::fromInt64(convertNumValue<int32_t>(meta, val), type);
+      case VssValue::Type::UINT64:
+        return VssValue::fromUInt64(convertNumValue<uint64_t>(meta, val), type);
+      case VssValue::Type::INT64:
+        return VssValue::fromInt64(convertNumValue<int64_t>(meta, val), type);
+      case VssValue::Type::FLOAT:
+        return VssValue::fromFloat(convertNumValue<float>(meta, val));
+      case VssValue::Type::DOUBLE:
+        return VssValue::fromDouble(convertNumValue<double>(meta, val));
+      case VssValue::Type::BOOLEAN:
+        if (val.type() == VssValue::Type::BOOLEAN) {
+          return val;
+        }
+        if (val.type() == VssValue::Type::STRING && (val.asString() == "true" || val.asString() == "false")) {
+          return VssValue::fromBool(val.asString() == "true");
+        }
+        throw outOfBoundException(val.toString() + " is not a bool. Valid values are true and false ");
+      case VssValue::Type::STRING: {
+        if (val.type() == VssValue::Type::ARRAY || !val.isSet()) {
+          notConvertible(val, meta);
+        }
+        VssValue res = val.type() == VssValue::Type::STRING ? val : VssValue::fromString(val.toString());
+        // In VSS 3.0 the keyword "allowed" replaced "enum"
+        for (const char *keyword : {"allowed", "enum"}) {
+          if (meta.contains(keyword)) {
+            jsoncons::json jval(res.asString());
+            checkEnumType(meta[keyword], jval);
+          }
+        }
+        return res;
+      }
+      case VssValue::Type::ARRAY: {
+        if (val.type() != VssValue::Type::ARRAY) {
+          notConvertible(val, meta);
+        }
+        std::string dt = meta["datatype"].as<std::string>();
+        jsoncons::json metadata;
+        metadata["datatype"] = dt.substr(0, dt.size()-2);
+        VssValue::Type subtype = VssValue::typeFromDatatype(metadata["datatype"].as<std::string>());
+        std::vector<VssValue> items;
+        items.reserve(val.asArray().size());
+        try {
+          for (const auto &item : val.asArray()) {
+            items.push_back(sanitizeValue(metadata, subtype, item));
+          }
+        } catch (std::exception const& e) {
+          std::stringstream msg;
+          msg << "Value " << val.toString() << " can not be converted to defined type " << dt << ". Reason: " << e.what();
+          throw outOfBoundException(msg.str());
+        }
+        return VssValue::fromArray(std::move(items));
+      }
+      default: {
+        std::string msg = "The datatype " + meta["datatype"].as<std::string>() + " is not supported ";
+        throw genException(msg);
+      }
+    }
+}
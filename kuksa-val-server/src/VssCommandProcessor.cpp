@@ -225,12 +225,45 @@ jsoncons::json VssCommandProcessor::processAuthorize(KuksaChannel &channel,
   }
 }
 
+std::string VssCommandProcessor::getRevisionTag(KuksaChannel &channel,
+                                               const string &path) {
+  VSSPath vssPath = VSSPath::fromVSS(path);
+  try {
+    list<VSSPath> vssPaths = database->getLeafPaths(vssPath);
+    if (vssPaths.empty()) {
+      return "";
+    }
+    for (const auto &leaf : vssPaths) {
+      if (!accessValidator_->checkReadAccess(channel, leaf)) {
+        return "";
+      }
+    }
+    // the tree revision stays a component of its own, as the signals the
+    // sum is taken over may change with the tree
+    VssRevision revision = database->getRevision(vssPath);
+    return std::to_string(revision.tree) + "." + std::to_string(revision.values);
+  } catch (std::exception &e) {
+    logger->Log(LogLevel::WARNING, "Can not determine revision of " + path + ": " + e.what());
+    return "";
+  }
+}
+
 jsoncons::json VssCommandProcessor::processQuery(const string &req_json,
                                          KuksaChannel &channel) {
   jsoncons::json root;
-  jsoncons::json jresponse;
   try {
     root = jsoncons::json::parse(req_json);
+  } catch (jsoncons::ser_error &e) {
+    logger->Log(LogLevel::WARNING, "JSON parse error");
+    return JsonResponses::malFormedRequest(e.what());
+  }
+  return processQuery(root, channel);
+}
+
+jsoncons::json VssCommandProcessor::processQuery(jsoncons::json &root,
+                                         KuksaChannel &channel) {
+  jsoncons::json jresponse;
+  try {
     string action = root["action"].as<string>();
     logger->Log(LogLevel::VERBOSE, "Receive action: " + action);
 
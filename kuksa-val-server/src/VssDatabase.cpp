@@ -25,6 +25,7 @@
 #include <stdexcept>
 #include <fstream>
 #include <ctime>
+#include <shared_mutex>
 #include <boost/algorithm/string.hpp>
 #include "jsonpath/json_query.hpp"
 #include "jsoncons_ext/jsonpatch/jsonpatch.hpp"
@@ -44,9 +45,11 @@ using jsoncons::json;
 
 // Constructor
 VssDatabase::VssDatabase(std::shared_ptr<ILogger> loggerUtil,
-                         std::shared_ptr<ISubscriptionHandler> subHandle) {
+                         std::shared_ptr<ISubscriptionHandler> subHandle)
+  : treeRevision_(0) {
   logger_ = loggerUtil;
   subHandler_ = subHandle;
+  model_ = std::make_shared<VssModel>();
 }
 
 VssDatabase::~VssDatabase() {}
@@ -99,10 +102,10 @@ void VssDatabase::applyDefaultValues(json &tree, VSSPath path) {
 
 // Initializer
 void VssDatabase::initJsonTree(const boost::filesystem::path &fileName) {
+  auto model = std::make_shared<VssModel>();
   try {
     std::ifstream is(fileName.string());
-    is >> data_tree__;
-    meta_tree__ = data_tree__;
+    is >> model->tree;
 
     logger_->Log(LogLevel::VERBOSE, "VssDatabase::VssDatabase : VSS tree initialized using JSON file = "
                 + fileName.string());
@@ -114,28 +117,176 @@ void VssDatabase::initJsonTree(const boost::filesystem::path &fileName) {
     throw e;
   }
 
-  applyDefaultValues(data_tree__["Vehicle"], VSSPath::fromVSS("Vehicle"));
+  applyDefaultValues(model->tree["Vehicle"], VSSPath::fromVSS("Vehicle"));
+
+  std::lock_guard<std::mutex> lock(updateMutex_);
+  values_.clear();
+  publishModel(model);
+}
+
+void VssDatabase::initCompiledTree(jsoncons::json tree) {
+  auto model = std::make_shared<VssModel>();
+  model->tree = std::move(tree);
+
+  std::lock_guard<std::mutex> lock(updateMutex_);
+  values_.clear();
+  publishModel(model);
+}
+
+jsoncons::json VssDatabase::getCompiledTree() {
+  std::lock_guard<std::mutex> lock(updateMutex_);
+  jsoncons::json tree = currentModel()->tree;
+  if (tree.is_object()) {
+    for (auto& root : tree.object_range()) {
+      embedStartupValues(root.value(), root.key());
+    }
+  }
+  return tree;
+}
+
+/** Puts values that have not been set at runtime (i.e. have no timestamp) back
+ *  into the tree, where indexNode will pick them up again. Needs to be called
+ *  with updateMutex_ held
+ */
+void VssDatabase::embedStartupValues(jsoncons::json &node, const std::string &vssPath) {
+  auto id = signalIds_.find(vssPath);
+  if (id != signalIds_.end()) {
+    VssSignalSlot& signal = values_[id->second];
+    std::shared_lock<VssSlotLock> slotLock(signal.lock);
+    for (const std::string attr : {"value", "targetValue"}) {
+      const VssValueSlot* slot = signal.attribute(attr);
+      if (slot->value.isSet() && slot->ts_s == 0 && slot->ts_ns == 0) {
+        node.insert_or_assign(attr, slot->value.toJson());
+      }
+    }
+  }
+
+  if (node.is_object() && node.contains("children")) {
+    for (auto& child : node.at("children").object_range()) {
+      embedStartupValues(child.value(), vssPath + "/" + child.key());
+    }
+  }
+}
+
+/** Returns true if the path contains wildcards and thus can not be resolved
+ *  through the path index
+ */
+bool VssDatabase::isWildcardPath(const VSSPath &path) {
+  return path.getVSSPath().find('*') != std::string::npos;
+}
+
+/** Returns the current model. Callers keep using the returned version even
+ *  if a tree update publishes a new one in the meantime
+ */
+std::shared_ptr<const VssDatabase::VssModel> VssDatabase::currentModel() const {
+  return std::atomic_load(&model_);
+}
+
+/** Builds the path index of a new model and makes it the current one.
+ *  Needs to be called with updateMutex_ held, model must not be modified
+ *  afterwards
+ */
+void VssDatabase::publishModel(std::shared_ptr<VssModel> model) {
+  if (model->tree.is_object()) {
+    for (auto& root : model->tree.object_range()) {
+      indexNode(*model, root.value(), root.key());
+    }
+  }
+  logger_->Log(LogLevel::VERBOSE, "VssDatabase::publishModel: indexed "
+               + std::to_string(model->index.size()) + " nodes");
+
+  std::atomic_store(&model_, std::shared_ptr<const VssModel>(std::move(model)));
+  // only afterwards, so that a revision is never paired with an older tree
+  treeRevision_++;
+}
+
+/** Adds node and its children to the path index of model. Every node carrying a
+ *  datatype gets a value slot. Values found in the tree (i.e. defaults
+ *  applied by applyDefaultValues) are moved to the value store, so that
+ *  the tree only holds metadata
+ */
+void VssDatabase::indexNode(VssModel &model, jsoncons::json &node, const std::string &vssPath) {
+  PathIndexEntry entry{&node, VssValueStore::NoSignal, VssValue::Type::NONE};
+  if (node.is_object() && node.contains("datatype")) {
+    entry.type = VssValue::typeFromDatatype(node["datatype"].as<std::string>());
+    auto id = signalIds_.find(vssPath);
+    if (id == signalIds_.end()) {
+      id = signalIds_.emplace(vssPath, static_cast<VssValueStore::SignalId>(signalIds_.size())).first;
+      values_.resize(signalIds_.size());
+    }
+    entry.id = id->second;
+
+    for (const std::string attr : {"value", "targetValue"}) {
+      if (node.contains(attr)) {
+        std::unique_lock<VssSlotLock> slotLock(values_[entry.id].lock);
+        VssValueSlot* slot = values_[entry.id].attribute(attr);
+        // typed like set values, so typed readers need not look at the datatype
+        try {
+          slot->value = VssValue::fromJson(node[attr], entry.type);
+        } catch (std::exception &) {
+          slot->value = VssValue::fromJson(node[attr]);
+        }
+        slot->ts_s = 0;
+        slot->ts_ns = 0;
+        values_[entry.id].revision++;
+        node.erase(attr);
+      }
+    }
+  }
+  model.index[vssPath] = entry;
+
+  if (node.is_object() && node.contains("children")) {
+    for (auto& child : node.at("children").object_range()) {
+      indexNode(model, child.value(), vssPath + "/" + child.key());
+    }
+  }
+}
+
+/** Resolves a path to the node(s) in the model tree it references. Paths without
+ *  wildcards are looked up in the path index, all others are evaluated as JSON
+ *  path. Returns the first matching node (or nullptr) and sets matches to the
+ *  number of matching nodes
+ */
+const VssDatabase::PathIndexEntry* VssDatabase::findNode(const VssModel &model, const VSSPath &path,
+                                                         size_t &matches) const {
+  if (!isWildcardPath(path)) {
+    auto it = model.index.find(path.getVSSPath());
+    if (it == model.index.end()) {
+      matches = 0;
+      return nullptr;
+    }
+    matches = 1;
+    return &(it->second);
+  }
+
+  jsoncons::json res = jsonpath::json_query(model.tree, path.getJSONPath(), jsonpath::result_type::path);
+  matches = res.size();
+  if (matches == 0) {
+    return nullptr;
+  }
+  auto it = model.index.find(VSSPath::fromJSON(res[0].as<string>(), false).getVSSPath());
+  return it == model.index.end() ? nullptr : &(it->second);
 }
 
 //Check if a path exists, doesn't care about the type
 bool VssDatabase::pathExists(const VSSPath &path) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath());
-  if (res.size() == 0) {
-    return false;
-  }
-  return true;
-  
+  size_t matches;
+  auto model = currentModel();
+  findNode(*model, path, matches);
+  return matches > 0;
 }
 
 // Check if a path is writable _in principle_, i.e. whether it is an actor or sensor.
 // This does _not_ check whether a user is authorized, and it will return false in case
 // the VSSPath references multiple destinations
 bool VssDatabase::pathIsWritable(const VSSPath &path) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath(),jsonpath::result_type::value);
-  if (res.size() != 1) { //either no match, or multiple matches
+  size_t matches;
+  auto model = currentModel();
+  const PathIndexEntry* entry = findNode(*model, path, matches);
+  if (matches != 1 || entry == nullptr) { //either no match, or multiple matches
     return false;
   }
-  if (res[0].contains("type") && ( res[0]["type"].as<string>() == "sensor" || res[0]["type"].as<string>() == "actuator" )) {
+  if (isSensor(*entry->node) || isActor(*entry->node)) {
     return true; //sensors and actors can be written to
   }
   //else it is either another type (branch), or a broken part (no type at all) of the tree, and thus not writable
@@ -146,15 +297,17 @@ bool VssDatabase::pathIsWritable(const VSSPath &path) {
 // This does _not_ check whether a user is authorized, and it will return false in case
 // the VSSPath references multiple destinations
 bool VssDatabase::pathIsAttributable(const VSSPath &path, const std::string& attr) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath(),jsonpath::result_type::value);
-  if (res.size() < 1) { // either no match,
+  size_t matches;
+  auto model = currentModel();
+  const PathIndexEntry* entry = findNode(*model, path, matches);
+  if (matches < 1 || entry == nullptr) { // either no match,
     return false;
-  } else if (res.size() > 1) { // multiple matches - Allow them to enable get using wildcards
+  } else if (matches > 1) { // multiple matches - Allow them to enable get using wildcards
     return true;
   }
 
   if (attr == "targetValue") {
-    if (res[0].contains("type") && (res[0]["type"].as<string>() == "actuator" )) {
+    if (isActor(*entry->node)) {
       return true; //only actors can have target values/setpoints
     }
   } if (attr == "value") {
@@ -168,11 +321,13 @@ bool VssDatabase::pathIsAttributable(const VSSPath &path, const std::string& att
 // This does _not_ check whether a user is authorized, and it will return false in case
 // the VSSPath references multiple destinations
 bool VssDatabase::pathIsReadable(const VSSPath &path) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath(),jsonpath::result_type::value);
-  if (res.size() != 1) { //either no match, or multiple matches
+  size_t matches;
+  auto model = currentModel();
+  const PathIndexEntry* entry = findNode(*model, path, matches);
+  if (matches != 1 || entry == nullptr) { //either no match, or multiple matches
     return false;
   }
-  if ( isSensor(res[0]) || isActor(res[0])|| isAttribute(res[0]) ) {
+  if ( isSensor(*entry->node) || isActor(*entry->node)|| isAttribute(*entry->node) ) {
     return true; //sensors, actors and attributes can be read
   }
   //else it is either another type (branch), or a broken part (no type at all) of the tree, and thus not writable
@@ -196,21 +351,17 @@ string VssDatabase::getDatatypeForPath(const VSSPath &path) {
     ss << path.to_string() + " does not contain a datatype because it is not a sensor/actuator/attribute.";
     throw genException(ss.str());
   }
-  jsoncons::json resArray;
   {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    resArray = jsonpath::json_query(data_tree__, path.getJSONPath());
-  }
-  jsoncons::json datapoint;
-  jsoncons::json result = resArray[0];
-  if (result.contains("datatype")) {
-    return result["datatype"].as<string>();
-  }
-  else {
-    stringstream ss;
-    ss << path.to_string() + " does not contain a datatype.";
-    throw genException(ss.str());
+    size_t matches;
+    auto model = currentModel();
+    const PathIndexEntry* entry = findNode(*model, path, matches);
+    if (entry != nullptr && entry->node->contains("datatype")) {
+      return (*entry->node)["datatype"].as<string>();
+    }
   }
+  stringstream ss;
+  ss << path.to_string() + " does not contain a datatype.";
+  throw genException(ss.str());
 }
 
 // Tokenizes path with '.' as separator.
@@ -232,11 +383,19 @@ list<VSSPath> VssDatabase::getLeafPaths(const VSSPath &path) {
   list<VSSPath> paths;
   bool path_is_gen1 = path.isGen1Origin();
 
-  //If this is a branch, recures
+  auto model = currentModel();
+  if (!isWildcardPath(path)) {
+    size_t matches;
+    const PathIndexEntry* entry = findNode(*model, path, matches);
+    if (entry != nullptr) {
+      collectLeafPaths(*entry->node, path.getJSONPath(), path_is_gen1, paths);
+    }
+    return paths;
+  }
+
   jsoncons::json pathRes;
   try {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    pathRes = jsonpath::json_query(data_tree__, path.getJSONPath(), jsonpath::result_type::path);
+    pathRes = jsonpath::json_query(model->tree, path.getJSONPath(), jsonpath::result_type::path);
   }
   catch (jsonpath::jsonpath_error &e) { //no valid path, return empty list
     logger_->Log(LogLevel::VERBOSE, path.getJSONPath() + " is not a a valid path "+e.what());
@@ -244,27 +403,56 @@ list<VSSPath> VssDatabase::getLeafPaths(const VSSPath &path) {
   }
 
   for (auto jpath : pathRes.array_range()) {
-    jsoncons::json resArray;
-    {
-      std::lock_guard<std::mutex> lock_guard(rwMutex_);
-      resArray = jsonpath::json_query(data_tree__, jpath.as<string>());
-    }
-    if (resArray.size() == 0) {
+    auto it = model->index.find(VSSPath::fromJSON(jpath.as<string>(), path_is_gen1).getVSSPath());
+    if (it == model->index.end()) {
       continue;
     }
+    collectLeafPaths(*(it->second.node), jpath.as<string>(), path_is_gen1, paths);
+  }
 
-    //recurse if branch
-    if (resArray[0].contains("type") && resArray[0]["type"].as<string>() == "branch") {
-      VSSPath recursepath = VSSPath::fromJSON(jpath.as<string>()+"['children'][*]", path_is_gen1);
-      paths.merge(getLeafPaths(recursepath));
-      continue;
-    }
-    else {
-      paths.push_back(VSSPath::fromJSON(jpath.as<string>(), path_is_gen1));
+  return paths;
+}
+
+// The tree revision, and the sum of the revisions of all signals at or below
+// path. The signals summed up are fixed within a tree revision and their
+// revisions only grow, so the sum changes with every update of one of them
+VssRevision VssDatabase::getRevision(const VSSPath &path) {
+  VssRevision revision{0, 0};
+  // read before the model, see publishModel
+  revision.tree = treeRevision_.load();
+  auto model = currentModel();
+  list<VSSPath> leaves = getLeafPaths(path);
+  if (leaves.empty()) {
+    throw noPathFoundonTree(path.getVSSPath());
+  }
+  for (const auto &leaf : leaves) {
+    size_t matches;
+    const PathIndexEntry* entry = findNode(*model, leaf, matches);
+    if (entry != nullptr && entry->id != VssValueStore::NoSignal) {
+      VssSignalSlot& signal = values_[entry->id];
+      std::shared_lock<VssSlotLock> slotLock(signal.lock);
+      revision.values += signal.revision;
     }
   }
+  return revision;
+}
 
-  return paths;
+// Adds node to paths if it is a leaf, otherwise recurses into all children of the branch.
+// Leafs of a branch are merged into paths, keeping the ordering getLeafPaths always had
+void VssDatabase::collectLeafPaths(const jsoncons::json &node, const std::string &jsonPath,
+                                   bool gen1, std::list<VSSPath> &paths) {
+  if (node.contains("type") && node["type"].as<string>() == "branch") {
+    list<VSSPath> childPaths;
+    if (node.contains("children")) {
+      for (const auto& child : node.at("children").object_range()) {
+        collectLeafPaths(child.value(), jsonPath + "['children']['" + child.key() + "']", gen1, childPaths);
+      }
+    }
+    paths.merge(childPaths);
+  }
+  else {
+    paths.push_back(VSSPath::fromJSON(jsonPath, gen1));
+  }
 }
 
 
@@ -296,11 +484,7 @@ vector<string> getVSSTokens(string path) {
 void VssDatabase::updateJsonTree(jsoncons::json& sourceTree, const jsoncons::json& jsonTree){
   std::error_code ec;
 
-  jsoncons::json patches;
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    patches = jsoncons::jsonpatch::from_diff(sourceTree, jsonTree);
-  }
+  jsoncons::json patches = jsoncons::jsonpatch::from_diff(sourceTree, jsonTree);
   jsoncons::json patchArray = jsoncons::json::array();
   //std::cout << pretty_print(patches) << std::endl;
   for(auto& patch: patches.array_range()){
@@ -309,10 +493,7 @@ void VssDatabase::updateJsonTree(jsoncons::json& sourceTree, const jsoncons::jso
        
     }
   }
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    jsonpatch::apply_patch(sourceTree, patchArray, ec);
-  }
+  jsonpatch::apply_patch(sourceTree, patchArray, ec);
 
   if(ec){
     std::cout << "error " << ec.message() << std::endl;
@@ -330,8 +511,13 @@ void VssDatabase::updateJsonTree(KuksaChannel& channel,  jsoncons::json& jsonTre
   if (jsonTree.contains("Vehicle")) {
     applyDefaultValues(jsonTree["Vehicle"], VSSPath::fromVSS(""));
   }
-  updateJsonTree(meta_tree__, jsonTree);
-  updateJsonTree(data_tree__, jsonTree);
+  // Patch a private copy of the tree and swap it in afterwards. Readers keep
+  // working on the current version in the meantime
+  std::lock_guard<std::mutex> lock(updateMutex_);
+  auto model = std::make_shared<VssModel>();
+  model->tree = currentModel()->tree;
+  updateJsonTree(model->tree, jsonTree);
+  publishModel(model);
 }
 
 // update a metadata in tree, which will only do one-level-deep shallow merge/update.
@@ -346,25 +532,15 @@ void VssDatabase::updateMetaData(KuksaChannel& channel, const VSSPath& path, con
   
   logger_->Log(LogLevel::VERBOSE, "VssDatabase::updateMetaData: VSS specific path =" + jPath);
     
-  jsoncons::json resMetaTree, resDataTree, resMetaTreeArray, resDataTreeArray;
-    
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    resMetaTreeArray= jsonpath::json_query(meta_tree__, jPath);
-    resDataTreeArray = jsonpath::json_query(data_tree__, jPath);
-  }
+  jsoncons::json resDataTree, resDataTreeArray;
 
-  if (resMetaTreeArray.is_array() && resMetaTreeArray.size() == 1) {
-    resMetaTree = resMetaTreeArray[0];
-  }else if(resMetaTreeArray.is_object()){
-    resMetaTree = resMetaTreeArray;
-  }else{
-    std::stringstream msg;
-    msg << jPath + " is not a valid path";
-    logger_->Log(LogLevel::ERROR, "VssDatabase::updateMetaData " + msg.str());
+  // query, merge and replace need to happen on the same version, otherwise
+  // concurrent updates of the same node get lost
+  std::lock_guard<std::mutex> lock(updateMutex_);
+  auto model = std::make_shared<VssModel>();
+  model->tree = currentModel()->tree;
+  resDataTreeArray = jsonpath::json_query(model->tree, jPath);
 
-    throw notValidException(msg.str());
-  }
   if (resDataTreeArray.is_array() && resDataTreeArray.size() == 1) {
     resDataTree = resDataTreeArray[0];
   }else if(resDataTreeArray.is_object()){
@@ -377,19 +553,16 @@ void VssDatabase::updateMetaData(KuksaChannel& channel, const VSSPath& path, con
     throw notValidException(msg.str());
   }
   // Note: merge metadata may cause overwritting existing data values
-  resMetaTree.merge_or_update(metadata);
   resDataTree.merge_or_update(metadata);
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    jsonpath::json_replace(meta_tree__, jPath, resMetaTree);
-    jsonpath::json_replace(data_tree__, jPath, resDataTree);
-  }
+  jsonpath::json_replace(model->tree, jPath, resDataTree);
+  publishModel(model);
 }
 
 // Returns the response JSON for metadata request.
 jsoncons::json VssDatabase::getMetaData(const VSSPath& path) {
   string jPath = path.getJSONPath();
-  jsoncons::json pathRes = jsonpath::json_query(meta_tree__, jPath, jsonpath::result_type::path);
+  auto model = currentModel();
+  jsoncons::json pathRes = jsonpath::json_query(model->tree, jPath, jsonpath::result_type::path);
   if (pathRes.size() > 0) {
     jPath = pathRes[0].as<string>();
   } else {
@@ -411,11 +584,7 @@ jsoncons::json VssDatabase::getMetaData(const VSSPath& path) {
     if ((i < tokLength - 1) && (tokens[i] == "children")) {
       continue;
     }
-    jsoncons::json resArray;
-    {
-      std::lock_guard<std::mutex> lock_guard(rwMutex_);
-      resArray = jsonpath::json_query(meta_tree__, format_path);
-    }
+    jsoncons::json resArray = jsonpath::json_query(model->tree, format_path);
 
     if (resArray.is_array() && resArray.size() == 1) {
       resJson = resArray[0];
@@ -460,6 +629,23 @@ jsoncons::json VssDatabase::getMetaData(const VSSPath& path) {
   return result;
 }
 
+// Returns a copy of the node path references, looked up in the path index
+jsoncons::json VssDatabase::getNodeMetaData(const VSSPath& path) {
+  size_t matches;
+  auto model = currentModel();
+  const PathIndexEntry* entry = findNode(*model, path, matches);
+  if (entry == nullptr || matches != 1) {
+    throw noPathFoundonTree(path.getVSSPath());
+  }
+  jsoncons::json meta;
+  for (const auto& member : entry->node->object_range()) {
+    if (member.key() != "children") {
+      meta.insert_or_assign(member.key(), member.value());
+    }
+  }
+  return meta;
+}
+
 // Set signal value of given path
 jsoncons::json VssDatabase::setSignal(const VSSPath &path, const std::string& attr, jsoncons::json &value) {
   jsoncons::json data;
@@ -467,27 +653,41 @@ jsoncons::json VssDatabase::setSignal(const VSSPath &path, const std::string& at
   
   data["path"] = path.to_string();
 
-  jsoncons::json res; 
   {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    res = jsonpath::json_query(data_tree__, path.getJSONPath());
-    if (res.is_array() && res.size() == 1) {
-      jsoncons::json resJson = res[0];
-      if (resJson.contains("datatype")) {
-        checkAndSanitizeType(resJson, value);
-        resJson.insert_or_assign(attr, value);
-        JsonResponses::addTimeStampToJSON(resJson, "-"+attr);
-        jsonpath::json_replace(data_tree__, path.getJSONPath(), resJson);
-
-        datapoint.insert_or_assign(attr, value);
-        datapoint.insert_or_assign("ts_s",  resJson["ts_s-"+attr]);
-        datapoint.insert_or_assign("ts_ns", resJson["ts_ns-"+attr]);
-        data.insert_or_assign("dp", datapoint);
-        subHandler_->publishForVSSPath(path, resJson["datatype"].as<std::string>(), attr, data);
+    size_t matches;
+    auto model = currentModel();
+    const PathIndexEntry* entry = findNode(*model, path, matches);
+    if (entry != nullptr && matches == 1) {
+      const jsoncons::json& meta = *entry->node;
+      VssValueSlot* slot = nullptr;
+      if (entry->id != VssValueStore::NoSignal) {
+        slot = values_[entry->id].attribute(attr);
       }
-      else {
+      if (slot == nullptr) {
         throw genException(path.getVSSPath()+ "is invalid for set"); //Todo better error message. (Does not propagate);
       }
+      checkAndSanitizeType(meta, value);
+      const std::string& datatype = meta["datatype"].as_string();
+      VssValue newValue = VssValue::fromJson(value, VssValue::typeFromDatatype(datatype));
+
+      timespec ts;
+      timespec_get(&ts, TIME_UTC);
+      uint64_t revision;
+      {
+        std::unique_lock<VssSlotLock> slotLock(values_[entry->id].lock);
+        slot->value = std::move(newValue);
+        slot->ts_s = ts.tv_sec;
+        slot->ts_ns = ts.tv_nsec;
+        revision = ++values_[entry->id].revision;
+      }
+
+      // published without the slot lock, the revision lets the subscription
+      // handler drop updates overtaken by a concurrent set
+      datapoint.insert_or_assign(attr, value);
+      datapoint.insert_or_assign("ts_s", static_cast<uint64_t>(ts.tv_sec));
+      datapoint.insert_or_assign("ts_ns", static_cast<uint32_t>(ts.tv_nsec));
+      data.insert_or_assign("dp", datapoint);
+      subHandler_->publishForVSSPath(path, datatype, attr, data, revision);
     }
   }
   return data;
@@ -495,31 +695,35 @@ jsoncons::json VssDatabase::setSignal(const VSSPath &path, const std::string& at
 
 // Returns signal in JSON format
 jsoncons::json VssDatabase::getSignal(const VSSPath& path, const std::string& attr, bool as_string) {
-    jsoncons::json resArray;
-    {
-      std::lock_guard<std::mutex> lock_guard(rwMutex_);
-      resArray = jsonpath::json_query(data_tree__, path.getJSONPath());
-    }
     jsoncons::json answer;
     jsoncons::json datapoint;
     answer.insert_or_assign("path", path.to_string());
-    jsoncons::json result = resArray[0];
-    if (result.contains(attr)) {
+    {
+      size_t matches;
+      auto model = currentModel();
+      const PathIndexEntry* entry = findNode(*model, path, matches);
+      if (entry == nullptr) {
+        throw noPathFoundonTree(path.getVSSPath());
+      }
+      VssValueSlot* slot = nullptr;
+      if (entry->id != VssValueStore::NoSignal) {
+        slot = values_[entry->id].attribute(attr);
+      }
+      if (slot == nullptr) {
+        throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
+      }
+      std::shared_lock<VssSlotLock> slotLock(values_[entry->id].lock);
+      if (!slot->value.isSet()) {
+        throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
+      }
       if (as_string) {
-        datapoint.insert_or_assign(attr, result[attr].as<string>());
+        datapoint.insert_or_assign(attr, slot->value.toString());
       }
       else {
-        datapoint.insert_or_assign(attr, result[attr]);
+        datapoint.insert_or_assign(attr, slot->value.toJson());
       }
-    } else {
-      throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
-    }
-    if (result.contains("ts_s-"+attr) && result.contains("ts_ns-"+attr)) {
-      datapoint["ts_s"] = result["ts_s-"+attr].as<uint64_t>();
-      datapoint["ts_ns"] = result["ts_ns-"+attr].as<uint32_t>();
-    } else {
-      datapoint["ts_s"] = 0;
-      datapoint["ts_ns"] = 0;
+      datapoint["ts_s"] = slot->ts_s;
+      datapoint["ts_ns"] = slot->ts_ns;
     }
 
     if (as_string) {
@@ -529,4 +733,78 @@ jsoncons::json VssDatabase::getSignal(const VSSPath& path, const std::string& at
     answer.insert_or_assign("dp", datapoint);
     return answer;
 
-}
\ No newline at end of file
+}
+
+// Set signal value of given path, without converting it to JSON first
+void VssDatabase::setSignalValue(const VSSPath &path, const std::string& attr, const VssValue &value,
+                                 uint64_t timestampNs) {
+  size_t matches;
+  auto model = currentModel();
+  const PathIndexEntry* entry = findNode(*model, path, matches);
+  if (entry == nullptr) {
+    throw noPathFoundonTree(path.getVSSPath());
+  }
+  const jsoncons::json& meta = *entry->node;
+  if (matches != 1 || entry->id == VssValueStore::NoSignal || !(isSensor(meta) || isActor(meta))) {
+    throw noPermissionException("Can not set " + path.to_string() + ". Only sensor or actor leaves can be set.");
+  }
+  VssValueSlot* slot = values_[entry->id].attribute(attr);
+  if (slot == nullptr || (attr == "targetValue" && !isActor(meta))) {
+    throw noPermissionException("Can not set path:" + path.to_string() + " with attribute:" + attr + ".");
+  }
+  VssValue newValue = sanitizeValue(meta, entry->type, value);
+
+  jsoncons::json data;
+  jsoncons::json datapoint;
+  data["path"] = path.to_string();
+
+  uint64_t ts_s, ts_ns;
+  if (timestampNs == 0) {
+    timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    ts_s = ts.tv_sec;
+    ts_ns = ts.tv_nsec;
+  } else {
+    ts_s = timestampNs / 1000000000;
+    ts_ns = timestampNs % 1000000000;
+  }
+  // converted before taking the slot lock, which is not kept while
+  // publishing, see setSignal
+  datapoint.insert_or_assign(attr, newValue.toJson());
+  uint64_t revision;
+  {
+    std::unique_lock<VssSlotLock> slotLock(values_[entry->id].lock);
+    slot->ts_s = ts_s;
+    slot->ts_ns = ts_ns;
+    slot->value = std::move(newValue);
+    revision = ++values_[entry->id].revision;
+  }
+
+  datapoint.insert_or_assign("ts_s", ts_s);
+  datapoint.insert_or_assign("ts_ns", static_cast<uint32_t>(ts_ns));
+  data.insert_or_assign("dp", datapoint);
+  subHandler_->publishForVSSPath(path, meta["datatype"].as_string(), attr, data, revision);
+}
+
+// Returns a copy of the signal value of given path
+VssValueSlot VssDatabase::getSignalValue(const VSSPath& path, const std::string& attr) {
+  size_t matches;
+  auto model = currentModel();
+  const PathIndexEntry* entry = findNode(*model, path, matches);
+  if (entry == nullptr) {
+    throw noPathFoundonTree(path.getVSSPath());
+  }
+  // a single value is returned, so path has to denote a single leaf
+  if (matches != 1 || entry->id == VssValueStore::NoSignal) {
+    throw notValidException("Can not get " + path.to_string() + ". Only values of single leaves can be read.");
+  }
+  VssValueSlot* slot = values_[entry->id].attribute(attr);
+  if (slot == nullptr) {
+    throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
+  }
+  std::shared_lock<VssSlotLock> slotLock(values_[entry->id].lock);
+  if (!slot->value.isSet()) {
+    throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
+  }
+  return *slot;
+}
@@ -0,0 +1,200 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "VssModelCache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <streambuf>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "jsoncons_ext/cbor/cbor.hpp"
+
+#include "ILogger.hpp"
+
+namespace {
+  const char CacheMagic[8] = {'K', 'U', 'K', 'S', 'A', 'V', 'S', 'S'};
+  /// Increase whenever the layout of the cache or the compiled model changes
+  const uint32_t CacheVersion = 1;
+
+  struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t contentHash;
+    uint64_t payloadSize;
+  };
+
+  const uint64_t FnvOffsetBasis = 14695981039346656037ULL;
+  const uint64_t FnvPrime = 1099511628211ULL;
+
+  void fnv1a(uint64_t &hash, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      hash ^= static_cast<uint8_t>(data[i]);
+      hash *= FnvPrime;
+    }
+  }
+
+  /** Read-only stream buffer on top of the mapped cache file, so the payload
+   *  can be decoded without copying it first */
+  class MappedBuffer : public std::streambuf {
+    public:
+      MappedBuffer(const char *data, size_t size) {
+        char *begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+      }
+  };
+
+  /** Maps a file read-only for the lifetime of the object */
+  class MappedFile {
+    public:
+      explicit MappedFile(const std::string &fileName) : data_(nullptr), size_(0) {
+        int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+          return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+          void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (addr != MAP_FAILED) {
+            data_ = static_cast<const char*>(addr);
+            size_ = st.st_size;
+          }
+        }
+        ::close(fd);
+      }
+      ~MappedFile() {
+        if (data_ != nullptr) {
+          ::munmap(const_cast<char*>(data_), size_);
+        }
+      }
+      MappedFile(const MappedFile &) = delete;
+      MappedFile& operator=(const MappedFile &) = delete;
+
+      const char* data() const { return data_; }
+      size_t size() const { return size_; }
+
+    private:
+      const char *data_;
+      size_t size_;
+  };
+}
+
+VssModelCache::VssModelCache(std::shared_ptr<ILogger> logger, const boost::filesystem::path &cacheDir)
+  : logger_(logger), cacheFile_(cacheDir / "vss-model.cache") {
+}
+
+uint64_t VssModelCache::hashFiles(const std::vector<boost::filesystem::path> &files) {
+  uint64_t hash = FnvOffsetBasis;
+  char buffer[64 * 1024];
+  for (const auto &file : files) {
+    std::ifstream is(file.string(), std::ios::binary);
+    if (!is) {
+      throw std::runtime_error("Can not read \"" + file.generic_string() + "\" for hashing");
+    }
+    uint64_t size = 0;
+    while (is) {
+      is.read(buffer, sizeof(buffer));
+      fnv1a(hash, buffer, is.gcount());
+      size += is.gcount();
+    }
+    // mix in length, so moving bytes between two files changes the hash
+    fnv1a(hash, reinterpret_cast<const char*>(&size), sizeof(size));
+  }
+  return hash;
+}
+
+bool VssModelCache::load(uint64_t contentHash, jsoncons::json &tree) {
+  MappedFile file(cacheFile_.string());
+  if (file.data() == nullptr) {
+    logger_->Log(LogLevel::VERBOSE, "VssModelCache::load: no model cache at " + cacheFile_.string());
+    return false;
+  }
+
+  CacheHeader header;
+  if (file.size() < sizeof(header)) {
+    logger_->Log(LogLevel::WARNING, "VssModelCache::load: ignoring truncated model cache " + cacheFile_.string());
+    return false;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+      header.version != CacheVersion ||
+      header.payloadSize != file.size() - sizeof(header)) {
+    logger_->Log(LogLevel::WARNING, "VssModelCache::load: ignoring invalid model cache " + cacheFile_.string());
+    return false;
+  }
+  if (header.contentHash != contentHash) {
+    logger_->Log(LogLevel::INFO, "VssModelCache::load: VSS model changed, model cache needs to be rebuilt");
+    return false;
+  }
+
+  try {
+    MappedBuffer buffer(file.data() + sizeof(header), header.payloadSize);
+    std::istream is(&buffer);
+    tree = jsoncons::cbor::decode_cbor<jsoncons::json>(is);
+  } catch (std::exception &e) {
+    logger_->Log(LogLevel::WARNING, "VssModelCache::load: can not decode model cache: " + std::string(e.what()));
+    return false;
+  }
+  logger_->Log(LogLevel::INFO, "VssModelCache::load: VSS model loaded from cache " + cacheFile_.string());
+  return true;
+}
+
+void VssModelCache::store(uint64_t contentHash, const jsoncons::json &tree) {
+  // write to a temporary file first, so that a concurrently starting server
+  // never maps a partially written cache
+  auto tmpFile = cacheFile_;
+  tmpFile += ".tmp";
+  try {
+    std::vector<uint8_t> payload;
+    jsoncons::cbor::encode_cbor(tree, payload);
+
+    CacheHeader header;
+    std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+    header.version = CacheVersion;
+    header.reserved = 0;
+    header.contentHash = contentHash;
+    header.payloadSize = payload.size();
+
+    boost::filesystem::create_directories(cacheFile_.parent_path());
+    {
+      std::ofstream os(tmpFile.string(), std::ios::binary | std::ios::trunc);
+      os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      os.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+      if (!os) {
+        throw std::runtime_error("write to " + tmpFile.string() + " failed");
+      }
+    }
+    boost::filesystem::rename(tmpFile, cacheFile_);
+  } catch (std::exception &e) {
+    logger_->Log(LogLevel::WARNING, "VssModelCache::store: can not write model cache: " + std::string(e.what()));
+    boost::system::error_code ec;
+    boost::filesystem::remove(tmpFile, ec);
+    return;
+  }
+  logger_->Log(LogLevel::INFO, "VssModelCache::store: VSS model cached in " + cacheFile_.string());
+}
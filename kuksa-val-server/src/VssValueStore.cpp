@@ -0,0 +1,292 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "VssValueStore.hpp"
+
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+constexpr VssValueStore::SignalId VssValueStore::NoSignal;
+constexpr size_t VssValueStore::ChunkBits;
+constexpr size_t VssValueStore::ChunkSize;
+constexpr size_t VssValueStore::MaxChunks;
+
+VssValue::VssValue() : type_(Type::NONE) { num_.u = 0; }
+
+VssValue VssValue::fromJson(const jsoncons::json &val) {
+  VssValue res;
+  if (val.is_bool()) {
+    res.type_ = Type::BOOLEAN;
+    res.num_.b = val.as<bool>();
+  } else if (val.is_string()) {
+    res.type_ = Type::STRING;
+    res.str_ = val.as<std::string>();
+  } else if (val.is_array()) {
+    res.type_ = Type::ARRAY;
+    res.array_.reserve(val.size());
+    for (const auto& item : val.array_range()) {
+      res.array_.push_back(fromJson(item));
+    }
+  } else if (val.is_double()) {
+    res.type_ = Type::DOUBLE;
+    res.num_.d = val.as<double>();
+  } else if (val.is_uint64()) {
+    res.type_ = Type::UINT64;
+    res.num_.u = val.as<uint64_t>();
+  } else if (val.is_int64()) {
+    res.type_ = Type::INT64;
+    res.num_.i = val.as<int64_t>();
+  } else {
+    // not a valid VSS value, but string datatypes are not sanitized. Keep
+    // what we got in its serialized form
+    res.type_ = Type::STRING;
+    res.str_ = val.as<std::string>();
+  }
+  return res;
+}
+
+VssValue VssValue::fromJson(const jsoncons::json &val, Type type) {
+  VssValue res;
+  switch (type) {
+    case Type::UINT8:
+    case Type::UINT16:
+    case Type::UINT32:
+    case Type::UINT64:
+      res.num_.u = val.as<uint64_t>();
+      break;
+    case Type::INT8:
+    case Type::INT16:
+    case Type::INT32:
+    case Type::INT64:
+      res.num_.i = val.as<int64_t>();
+      break;
+    case Type::FLOAT:
+      res.num_.f = val.as<float>();
+      break;
+    case Type::DOUBLE:
+      res.num_.d = val.as<double>();
+      break;
+    case Type::BOOLEAN:
+      res.num_.b = val.as<bool>();
+      break;
+    default:
+      // strings and arrays are not converted by the sanitizer
+      return fromJson(val);
+  }
+  res.type_ = type;
+  return res;
+}
+
+VssValue VssValue::fromUInt64(uint64_t val, Type type) {
+  VssValue res;
+  res.type_ = type;
+  res.num_.u = val;
+  return res;
+}
+
+VssValue VssValue::fromInt64(int64_t val, Type type) {
+  VssValue res;
+  res.type_ = type;
+  res.num_.i = val;
+  return res;
+}
+
+VssValue VssValue::fromFloat(float val) {
+  VssValue res;
+  res.type_ = Type::FLOAT;
+  res.num_.f = val;
+  return res;
+}
+
+VssValue VssValue::fromDouble(double val) {
+  VssValue res;
+  res.type_ = Type::DOUBLE;
+  res.num_.d = val;
+  return res;
+}
+
+VssValue VssValue::fromBool(bool val) {
+  VssValue res;
+  res.type_ = Type::BOOLEAN;
+  res.num_.b = val;
+  return res;
+}
+
+VssValue VssValue::fromString(std::string val) {
+  VssValue res;
+  res.type_ = Type::STRING;
+  res.str_ = std::move(val);
+  return res;
+}
+
+VssValue VssValue::fromArray(std::vector<VssValue> val) {
+  VssValue res;
+  res.type_ = Type::ARRAY;
+  res.array_ = std::move(val);
+  return res;
+}
+
+VssValue::Type VssValue::typeFromDatatype(const std::string &datatype) {
+  // looked up for every published value, so hash instead of comparing in turn
+  static const std::unordered_map<std::string, Type> types = {
+    {"uint8", Type::UINT8},
+    {"int8", Type::INT8},
+    {"uint16", Type::UINT16},
+    {"int16", Type::INT16},
+    {"uint32", Type::UINT32},
+    {"int32", Type::INT32},
+    {"uint64", Type::UINT64},
+    {"int64", Type::INT64},
+    {"float", Type::FLOAT},
+    {"double", Type::DOUBLE},
+    {"boolean", Type::BOOLEAN},
+    {"string", Type::STRING}
+  };
+  auto type = types.find(datatype);
+  if (type != types.end()) {
+    return type->second;
+  }
+  if (datatype.size() > 2 && datatype.rfind("[]") == datatype.size() - 2) {
+    return Type::ARRAY;
+  }
+  return Type::NONE;
+}
+
+jsoncons::json VssValue::toJson() const {
+  switch (type_) {
+    case Type::UINT8:
+    case Type::UINT16:
+    case Type::UINT32:
+    case Type::UINT64:
+      return jsoncons::json(num_.u);
+    case Type::INT8:
+    case Type::INT16:
+    case Type::INT32:
+    case Type::INT64:
+      return jsoncons::json(num_.i);
+    case Type::FLOAT:
+      return jsoncons::json(num_.f);
+    case Type::DOUBLE:
+      return jsoncons::json(num_.d);
+    case Type::BOOLEAN:
+      return jsoncons::json(num_.b);
+    case Type::STRING:
+      return jsoncons::json(str_);
+    case Type::ARRAY: {
+      jsoncons::json res = jsoncons::json::array();
+      res.reserve(array_.size());
+      for (const auto& item : array_) {
+        res.push_back(item.toJson());
+      }
+      return res;
+    }
+    case Type::NONE:
+    default:
+      return jsoncons::json::null();
+  }
+}
+
+bool VssValue::isUnsigned() const {
+  return type_ == Type::UINT8 || type_ == Type::UINT16 || type_ == Type::UINT32 ||
+         type_ == Type::UINT64;
+}
+
+bool VssValue::isSigned() const {
+  return type_ == Type::INT8 || type_ == Type::INT16 || type_ == Type::INT32 ||
+         type_ == Type::INT64;
+}
+
+bool VssValue::operator==(const VssValue &other) const {
+  if (type_ != other.type_) {
+    return false;
+  }
+  switch (type_) {
+    case Type::FLOAT:
+      return num_.f == other.num_.f;
+    case Type::DOUBLE:
+      return num_.d == other.num_.d;
+    case Type::BOOLEAN:
+      return num_.b == other.num_.b;
+    case Type::STRING:
+      return str_ == other.str_;
+    case Type::ARRAY:
+      return array_ == other.array_;
+    case Type::NONE:
+      return true;
+    default:
+      return num_.u == other.num_.u;
+  }
+}
+
+std::string VssValue::toString() const {
+  if (type_ == Type::STRING) {
+    return str_;
+  }
+  return toJson().as<std::string>();
+}
+
+VssValueSlot* VssSignalSlot::attribute(const std::string &attr) {
+  if (attr == "value") {
+    return &value;
+  }
+  if (attr == "targetValue") {
+    return &targetValue;
+  }
+  return nullptr;
+}
+
+VssValueStore::VssValueStore() : size_(0) {
+  for (auto& chunk : chunks_) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+VssValueStore::~VssValueStore() {
+  for (auto& chunk : chunks_) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+void VssValueStore::resize(size_t count) {
+  if (count <= size()) {
+    return;
+  }
+  if (count > ChunkSize * MaxChunks) {
+    throw std::length_error("VSS tree holds more signals than the value store supports");
+  }
+  for (size_t chunk = 0; chunk < (count + ChunkSize - 1) / ChunkSize; chunk++) {
+    if (chunks_[chunk].load(std::memory_order_relaxed) == nullptr) {
+      chunks_[chunk].store(new VssSignalSlot[ChunkSize], std::memory_order_release);
+    }
+  }
+  size_.store(count, std::memory_order_release);
+}
+
+void VssValueStore::clear() {
+  for (SignalId id = 0; id < size(); id++) {
+    VssSignalSlot& slot = (*this)[id];
+    std::unique_lock<VssSlotLock> lock(slot.lock);
+    slot.value = VssValueSlot();
+    slot.targetValue = VssValueSlot();
+    slot.revision++;
+  }
+}
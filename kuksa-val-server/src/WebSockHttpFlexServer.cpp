@@ -21,18 +21,26 @@
 
 
 #include <boost/asio/bind_executor.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/core/buffers_to_string.hpp>
+#include <boost/beast/zlib/deflate_stream.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/make_unique.hpp>
 #include <boost/logic/tribool.hpp>
 #include <boost/beast/core/detect_ssl.hpp>
+#include <boost/filesystem/path.hpp>
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <memory>
@@ -45,6 +53,16 @@
 #include <regex>
 #include <stdexcept>
 #include <list>
+#include <deque>
+#include <array>
+#include <atomic>
+#include <iterator>
+
+#include <pthread.h>
+#include <pwd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "ssl_stream.hpp"
 
@@ -53,161 +71,164 @@
 #include "IVssCommandProcessor.hpp"
 #include "KuksaChannel.hpp"
 #include "ILogger.hpp"
+#include "JsonResponses.hpp"
+#include "MessageEncoding.hpp"
+#include "RestApi.hpp"
+#include "SseStream.hpp"
+#include "ConnectionRegistry.hpp"
+#include "PeerCredentials.hpp"
 
 using RequestHandler = std::function<std::string(const std::string &, KuksaChannel &)>;
+using RevisionHandler = std::function<std::string(const std::string &, KuksaChannel &)>;
 using Listeners = std::vector<std::pair<ObserverType,std::shared_ptr<IVssCommandProcessor>>>;
 using tcp = boost::asio::ip::tcp;               // from <boost/asio/ip/tcp.hpp>
+using local_stream = boost::asio::local::stream_protocol;  // from <boost/asio/local/stream_protocol.hpp>
 namespace ssl = boost::asio::ssl;               // from <boost/asio/ssl.hpp>
 namespace http = boost::beast::http;            // from <boost/beast/http.hpp>
 namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.hpp>
 
   // forward declaration for classes that are defined below
-  class PlainWebsocketSession;
+  template<class Socket> class BasicPlainWebsocketSession;
   class SslWebsocketSession;
-  class PlainHttpSession;
+  template<class Socket> class BasicPlainHttpSession;
   class SslHttpSession;
   class BeastListener;
-
-/**
- * @class ConnectionHandler
- * @brief Helper class to handle connection between \ref KuksaChannel and actual sessions
- */
-  class ConnectionHandler {
-    // Allow access to connection information from this file implementation details
-    friend class ::WebSockHttpFlexServer;
-
-    private:
-      std::mutex mPlainWebSock_;
-      std::mutex mSslWebSock_;
-      std::mutex mPlainHttp_;
-      std::mutex mSslHttp_;
-
-      std::unordered_map<const PlainWebsocketSession *,
-                         std::shared_ptr<KuksaChannel>> connPlainWebSock_;
-      std::unordered_map<const SslWebsocketSession *,
-                         std::shared_ptr<KuksaChannel>> connSslWebSock_;
-      std::unordered_map<const PlainHttpSession *,
-                         std::shared_ptr<KuksaChannel>> connPlainHttp_;
-      std::unordered_map<const SslHttpSession *,
-                         std::shared_ptr<KuksaChannel>> connSslHttp_;
-
-    public:
-      ConnectionHandler() = default;
-      ~ConnectionHandler() = default;
-
-      /**
-       * @brief Add new client for plain Web-Socket session
-       * @param session New session to add
-       * @return \ref KuksaChannel with new connection information
-       */
-      KuksaChannel& AddClient(const PlainWebsocketSession * session) {
-        auto newChannel = std::make_shared<KuksaChannel>();
-        std::lock_guard<std::mutex> lock(mPlainWebSock_);
-
-        newChannel->setConnID(reinterpret_cast<uint64_t>(session));
-        newChannel->setType(KuksaChannel::Type::WEBSOCKET_PLAIN);
-        connPlainWebSock_[session] = newChannel;
-        return *newChannel;
-      }
-
-      /**
-       * @brief Add new client for SSL Web-Socket session
-       * @param session New session to add
-       * @return \ref KuksaChannel with new connection information
-       */
-      KuksaChannel& AddClient(const SslWebsocketSession * session) {
-        auto newChannel = std::make_shared<KuksaChannel>();
-        std::lock_guard<std::mutex> lock(mSslWebSock_);
-
-        newChannel->setConnID(reinterpret_cast<uint64_t>(session));
-        newChannel->setType(KuksaChannel::Type::WEBSOCKET_SSL);
-        connSslWebSock_[session] = newChannel;
-
-        return *newChannel;
-      }
-
-      /**
-       * @brief Add new client for plain HTTP session
-       * @param session New session to add
-       * @return \ref KuksaChannel with new connection information
-       */
-      KuksaChannel& AddClient(const PlainHttpSession * session) {
-        auto newChannel = std::make_shared<KuksaChannel>();
-        std::lock_guard<std::mutex> lock(mPlainHttp_);
-
-        newChannel->setConnID(reinterpret_cast<uint64_t>(session));
-        newChannel->setType(KuksaChannel::Type::HTTP_PLAIN);
-        connPlainHttp_[session] = newChannel;
-
-        return *newChannel;
-      }
-
-      /**
-       * @brief Add new client for SSL HTTP session
-       * @param session New session to add
-       * @return \ref KuksaChannel with new connection information
-       */
-      KuksaChannel& AddClient(const SslHttpSession * session) {
-        auto newChannel = std::make_shared<KuksaChannel>();
-        std::lock_guard<std::mutex> lock(mSslHttp_);
-
-        newChannel->setConnID(reinterpret_cast<uint64_t>(session));
-        newChannel->setType(KuksaChannel::Type::HTTP_SSL);
-        connSslHttp_[session] = newChannel;
-
-        return *newChannel;
-      }
-
-      /**
-       * @brief Remove client for plain Web-Socket session
-       * @param session Existing session to remove
-       */
-      void RemoveClient(const PlainWebsocketSession * session) {
-        std::lock_guard<std::mutex> lock(mPlainWebSock_);
-        connPlainWebSock_.erase(session);
-      }
-
-      /**
-       * @brief Remove client for SSL Web-Socket session
-       * @param session Existing session to remove
-       */
-      void RemoveClient(const SslWebsocketSession * session) {
-        std::lock_guard<std::mutex> lock(mSslWebSock_);
-        connSslWebSock_.erase(session);
-      }
-
-      /**
-       * @brief Remove client for plain HTTP session
-       * @param session Existing session to remove
-       */
-      void RemoveClient(const PlainHttpSession * session) {
-        std::lock_guard<std::mutex> lock(mPlainHttp_);
-        connPlainHttp_.erase(session);
-      }
-
-      /**
-       * @brief Remove client for SSL HTTP session
-       * @param session Existing session to remove
-       */
-      void RemoveClient(const SslHttpSession * session) {
-        std::lock_guard<std::mutex> lock(mSslHttp_);
-        connSslHttp_.erase(session);
-      }
-  };
+  class LocalListener;
 
   /**** Local variables ****/
 
   // Boost.Beast helper state variables
-  ConnectionHandler                        connHandler;
-  std::shared_ptr<BeastListener>           connListener;
+  ConnectionRegistry                       connections;
+  std::vector<std::shared_ptr<BeastListener>> connListeners;
+  std::shared_ptr<LocalListener>           localListener;
   ssl::context                             ctx{ssl::context::sslv23};
   std::vector<std::thread>                 iocRunners;
 
+  /// Revision tags for conditional REST requests
+  RevisionHandler revisionHandler;
+  /// Subscriptions streamed to HTTP clients as Server-Sent Events
+  SseStreamRegistry sseStreams{connections};
+  /// Drops expired streams also while no client creates or resumes one
+  std::unique_ptr<boost::asio::steady_timer> sseSweepTimer;
+
   /// Are allowed plain Web-socket/HTTP connections
   bool allowInsecureConns = false;
 
+  /// Unix domain socket for local clients, none if empty
+  std::string localSocketPath;
+  /// Permissions of local clients by user, see PeerCredentials
+  std::shared_ptr<const PeerCredentials> peerCredentials;
+
   std::shared_ptr<ILogger> logger;
 
+  /// Subscription updates that may be pending per Web-Socket connection
+  size_t outboundQueueDepth = 256;
+  SlowConsumerPolicy slowConsumerPolicy = SlowConsumerPolicy::CONFLATE;
+  std::atomic<uint64_t> droppedUpdates{0};
+  std::atomic<uint64_t> conflatedUpdates{0};
+  std::atomic<uint64_t> slowConsumerDisconnects{0};
+
+  /// Processes Web-Socket requests off the I/O threads, if configured
+  std::unique_ptr<boost::asio::thread_pool> requestPool;
+  /// Requests that may be queued or in progress in requestPool
+  size_t requestQueueLimit = 1024;
+  std::atomic<size_t> queuedRequests{0};
+  std::atomic<uint64_t> rejectedRequests{0};
+
+  /// permessage-deflate settings offered to Web-Socket clients
+  websocket::permessage_deflate deflateOptions;
+  /// Messages smaller than this are sent uncompressed, if supported by Boost.Beast
+  size_t deflateThreshold = 0;
+  bool deflateThresholdSupported = false;
+  /// Every COMPRESSION_SAMPLE_INTERVAL-th compressed message is compressed
+  /// once more to estimate compression ratio and CPU time
+  const uint64_t COMPRESSION_SAMPLE_INTERVAL = 64;
+  std::atomic<uint64_t> compressedMessages{0};
+  std::atomic<uint64_t> compressedBytes{0};
+  std::atomic<uint64_t> sampledBytes{0};
+  std::atomic<uint64_t> sampledCompressedBytes{0};
+  std::atomic<uint64_t> sampledNanoseconds{0};
+
+  /// Boost.Beast versions knowing msg_size_threshold skip compression of small messages
+  template <typename Options>
+  auto setDeflateThreshold(Options &options, size_t threshold, int)
+      -> decltype(options.msg_size_threshold = threshold, bool()) {
+    options.msg_size_threshold = threshold;
+    return true;
+  }
+
+  template <typename Options>
+  bool setDeflateThreshold(Options &, size_t, long) {
+    return false;
+  }
+
+  /// Drops expired Server-Sent Events streams once per resume timeout, so
+  /// a stream is kept at most twice as long as the timeout
+  void scheduleSseSweep() {
+    sseSweepTimer->expires_after(
+        std::max<std::chrono::steady_clock::duration>(sseStreams.resumeTimeout(), std::chrono::seconds(1)));
+    sseSweepTimer->async_wait([](boost::system::error_code ec) {
+      if (ec == boost::asio::error::operation_aborted) {
+        return;
+      }
+      sseStreams.removeExpired();
+      scheduleSseSweep();
+    });
+  }
+
+  /// Updates compression metrics for a message written on a connection
+  /// that negotiated permessage-deflate
+  void accountCompression(const OutboundMessage &message) {
+    std::array<boost::asio::const_buffer, 3> parts{{
+      boost::asio::buffer(message.head),
+      message.body ? boost::asio::buffer(*message.body) : boost::asio::const_buffer(),
+      boost::asio::buffer(message.tail)
+    }};
+    size_t size = boost::asio::buffer_size(parts);
+    if (deflateThresholdSupported && size < deflateThreshold) {
+      return;
+    }
+    compressedBytes += size;
+    if (compressedMessages++ % COMPRESSION_SAMPLE_INTERVAL != 0) {
+      return;
+    }
+
+    // Boost.Beast does not report compressed sizes, so compress the message
+    // once more with the same deflate implementation and settings
+    thread_local boost::beast::zlib::deflate_stream deflater;
+    thread_local std::vector<uint8_t> output;
+    auto start = std::chrono::steady_clock::now();
+    deflater.reset(deflateOptions.compLevel, deflateOptions.server_max_window_bits,
+                   deflateOptions.memLevel, boost::beast::zlib::Strategy::normal);
+    output.resize(deflater.upper_bound(size) + 16);
+
+    boost::beast::zlib::z_params zs;
+    zs.next_out = output.data();
+    zs.avail_out = output.size();
+    boost::system::error_code ec;
+    for (const auto &part : parts) {
+      if (part.size() == 0) {
+        continue;
+      }
+      zs.next_in = part.data();
+      zs.avail_in = part.size();
+      deflater.write(zs, boost::beast::zlib::Flush::none, ec);
+      if (ec) {
+        return;
+      }
+    }
+    zs.avail_in = 0;
+    deflater.write(zs, boost::beast::zlib::Flush::sync, ec);
+    if (ec) {
+      return;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    sampledBytes += size;
+    sampledCompressedBytes += zs.total_out;
+    sampledNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  }
+
   const unsigned DEFAULT_TIMEOUT_VALUE   = std::numeric_limits<unsigned int>::max();   // in seconds
   const unsigned WEBSOCKET_TIMEOUT_VALUE = DEFAULT_TIMEOUT_VALUE;
   const unsigned HTTP_TIMEOUT_VALUE      = DEFAULT_TIMEOUT_VALUE;
@@ -230,18 +251,68 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
   }
 
   /// Report a failure and remove client from active connections that are tracked
-  template <typename T>
-  void fail(const T* fromType, boost::system::error_code ec, char const* what) {
+  void fail(const KuksaChannel &channel, boost::system::error_code ec, char const* what) {
     fail(ec, what);
     logger->Log(LogLevel::ERROR, "Connection error detected, remove client from active connections");
-    connHandler.RemoveClient(fromType);
+    connections.remove(channel.getConnID());
+  }
+
+  /// Registers a session with the connections that notifications are sent
+  /// to and returns the channel of the new connection
+  KuksaChannel addClient(std::weak_ptr<IConnection> session, KuksaChannel::Type type) {
+    KuksaChannel channel;
+    channel.setConnID(connections.add(std::move(session)));
+    channel.setType(type);
+    return channel;
   }
 
+  /// Channel types and client authorization of the plain transports
+  template<class Socket>
+  struct Transport;
+
+  template<>
+  struct Transport<tcp::socket> {
+    static KuksaChannel::Type httpType() { return KuksaChannel::Type::HTTP_PLAIN; }
+    static KuksaChannel::Type websocketType() { return KuksaChannel::Type::WEBSOCKET_PLAIN; }
+    /// Clients authorize with a token
+    static void authorizePeer(tcp::socket &, KuksaChannel &) {}
+  };
+
+  template<>
+  struct Transport<local_stream::socket> {
+    static KuksaChannel::Type httpType() { return KuksaChannel::Type::HTTP_LOCAL; }
+    static KuksaChannel::Type websocketType() { return KuksaChannel::Type::WEBSOCKET_LOCAL; }
+    /// Grants the permissions configured for the user running the client.
+    /// Clients may still authorize with a token instead
+    static void authorizePeer(local_stream::socket &socket, KuksaChannel &channel) {
+      if (!peerCredentials) {
+        return;
+      }
+      struct ucred credentials;
+      socklen_t length = sizeof(credentials);
+      if (getsockopt(socket.native_handle(), SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) {
+        logger->Log(LogLevel::WARNING, std::string("Can not get credentials of local client: ") + std::strerror(errno));
+        return;
+      }
+      std::string user;
+      struct passwd entry;
+      struct passwd *found = nullptr;
+      std::array<char, 1024> buffer;
+      if (getpwuid_r(credentials.uid, &entry, buffer.data(), buffer.size(), &found) == 0 && found != nullptr) {
+        user = found->pw_name;
+      }
+      if (peerCredentials->authorize(channel, credentials.uid, user)) {
+        logger->Log(LogLevel::VERBOSE, "Local client of user " + (user.empty() ? std::to_string(credentials.uid) : user)
+                    + " authorized by peer credentials");
+      }
+    }
+  };
+
   //------------------------------------------------------------------------------
   // This uses the Curiously Recurring Template Pattern so that
   // the same code works with both SSL streams and regular sockets.
   template<class Derived>
-  class WebSocketSession {
+  class WebSocketSession : public IConnection {
       // Access the derived class, this is part of
       // the Curiously Recurring Template Pattern idiom.
       Derived& derived() {
@@ -249,7 +320,6 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       }
 
       boost::beast::multi_buffer bufferRead_;
-      boost::beast::multi_buffer bufferWrite_;
       char ping_state_ = 0;
 
       mutable std::mutex queueMutex;
@@ -260,7 +330,21 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       boost::asio::steady_timer timer_;
       RequestHandler requestHandler_;
       KuksaChannel channel;
-      std::list<std::string> writeQueue_;
+      /// Messages waiting to be sent. Guarded by queueMutex
+      std::list<OutboundMessage> writeQueue_;
+      /// Number of subscription updates in writeQueue_
+      size_t pendingUpdates_ = 0;
+      /// Latest pending update per subscription, used for conflation
+      std::unordered_map<std::string, std::list<OutboundMessage>::iterator> latestUpdate_;
+      bool slowConsumerClosing_ = false;
+      /// Set while a flush is scheduled or messages are being written, any
+      /// further message is picked up by that flush. Guarded by queueMutex
+      bool flushing_ = false;
+      /// Messages taken from writeQueue_ by the last flush, the front one is
+      /// being written. Only used on the strand
+      std::list<OutboundMessage> sending_;
+      /// Set if the client accepted permessage-deflate, for compression metrics
+      bool compressing_ = false;
     public:
       // Construct the session
       explicit WebSocketSession(boost::asio::io_context& ioc,
@@ -271,6 +355,15 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         , requestHandler_(requestHandler) {
       }
 
+      ~WebSocketSession() {
+        connections.remove(channel.getConnID());
+      }
+
+      bool send(const OutboundMessage &message) override {
+        write(message);
+        return true;
+      }
+
       // Start the asynchronous operation
       template<class Body, class Allocator>
       void doAccept(http::request<Body, http::basic_fields<Allocator>> req) {
@@ -283,6 +376,27 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
                   std::placeholders::_1,
                   std::placeholders::_2));
 
+          // Use a binary encoding if the client asks for one
+          auto offered = req[http::field::sec_websocket_protocol];
+          KuksaChannel::Encoding encoding;
+          if (!offered.empty() &&
+              MessageEncoding::fromSubprotocols(std::string(offered.data(), offered.size()), encoding)) {
+            channel.setEncoding(encoding);
+            std::string protocol = MessageEncoding::subprotocol(encoding);
+            derived().ws().set_option(websocket::stream_base::decorator(
+                [protocol](websocket::response_type &res) {
+                  res.set(http::field::sec_websocket_protocol, protocol);
+                }));
+            derived().ws().binary(encoding != KuksaChannel::Encoding::JSON);
+          }
+
+          // Offer compression, it is used if the client asks for it as well
+          if (deflateOptions.server_enable) {
+            derived().ws().set_option(deflateOptions);
+            auto extensions = req[http::field::sec_websocket_extensions];
+            compressing_ = extensions.find("permessage-deflate") != boost::beast::string_view::npos;
+          }
+
           // Set the timer
           timer_.expires_after(std::chrono::seconds(WEBSOCKET_TIMEOUT_VALUE));
 
@@ -303,7 +417,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           return;
 
         if(ec) {
-          fail<>(&derived(), ec, "accept");
+          fail(channel, ec, "accept");
           return;
         }
 
@@ -314,7 +428,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       // Called when the timer expires.
       void onTimer(boost::system::error_code ec) {
         if(ec && ec != boost::asio::error::operation_aborted) {
-          fail<>(&derived(), ec, "timer");
+          fail(channel, ec, "timer");
           return;
         }
 
@@ -374,7 +488,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           return;
 
         if(ec) {
-          fail<>(&derived(), ec, "ping");
+          fail(channel, ec, "ping");
           return;
         }
 
@@ -421,45 +535,195 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
 
         // This indicates that the websocket_session was closed
         if(ec == websocket::error::closed) {
-          connHandler.RemoveClient(&derived());
+          connections.remove(channel.getConnID());
           return;
         }
 
         if(ec)
-          fail<>(&derived(),ec, "read");
+          fail(channel, ec, "read");
 
         // Note that there is activity
         activity();
 
-        derived().ws().text(derived().ws().got_text());
+        // text clients get answers in the frame type they used
+        if (channel.getEncoding() == KuksaChannel::Encoding::JSON) {
+          derived().ws().text(derived().ws().got_text());
+        }
 
-        std::string response = requestHandler_(boost::beast::buffers_to_string(bufferRead_.data()), channel);
+        std::string request = boost::beast::buffers_to_string(bufferRead_.data());
         bufferRead_.consume(bytesTransferred); // clear existing buffer data
 
+        processRequest(std::move(request));
+      }
+
+      /// Answers a request, either right away or from the request pool.
+      /// The next request is only read once the response is queued, so
+      /// responses keep the order of requests
+      void processRequest(std::string request) {
+        if (!requestPool) {
+          onResponse(requestHandler_(request, channel));
+          return;
+        }
+
+        if (queuedRequests.fetch_add(1) >= requestQueueLimit) {
+          queuedRequests--;
+          uint64_t rejected = ++rejectedRequests;
+          if (rejected == 1 || rejected % 1000 == 0) {
+            logger->Log(LogLevel::WARNING, "Request queue full, rejected " + std::to_string(rejected)
+                        + " requests so far");
+          }
+          onResponse(busyResponse(request, channel.getEncoding()));
+          return;
+        }
+
+        auto self = derived().shared_from_this();
+        boost::asio::post(*requestPool, [this, self, request]() {
+          std::string response = requestHandler_(request, channel);
+          queuedRequests--;
+          boost::asio::post(strand_, [this, self, response]() mutable {
+            onResponse(std::move(response));
+          });
+        });
+      }
+
+      void onResponse(std::string response) {
         // send response
-        write(response);
+        write(OutboundMessage{std::move(response), nullptr, std::string(), std::string()});
 
         // do another read
         doRead();
       }
 
-      void write(const std::string &message) {
-        std::unique_lock<std::mutex> lock(queueMutex);
+      /// Error response for a request that can not be queued
+      static std::string busyResponse(const std::string &request, KuksaChannel::Encoding encoding) {
+        std::string requestId = "UNKNOWN", action = "UNKNOWN";
+        try {
+          jsoncons::json req = MessageEncoding::decode(request, encoding);
+          requestId = req.get_value_or<std::string>("requestId", requestId);
+          action = req.get_value_or<std::string>("action", action);
+        } catch (std::exception &) {
+          // malformed request, answer with defaults
+        }
+        return MessageEncoding::encode(JsonResponses::serviceUnavailable(requestId, action,
+                                                                         "Server busy, try again later"),
+                                       encoding);
+      }
 
-        writeQueue_.push_back(message);
+      /// May be called from any thread. Messages queued while the session is
+      /// busy writing are flushed together
+      void write(OutboundMessage message) {
+        {
+          std::unique_lock<std::mutex> lock(queueMutex);
 
-        // there can be only one async_write request at any single time,
-        // so queue additional transfers
-        if (writeQueue_.size() > 1) {
-          return;
+          if (message.key.empty()) {
+            writeQueue_.push_back(std::move(message));
+          } else if (!queueUpdate(std::move(message))) {
+            return;
+          }
+
+          if (flushing_) {
+            return;
+          }
+          flushing_ = true;
+        }
+
+        std::shared_ptr<Derived> self;
+        try {
+          self = derived().shared_from_this();
+        } catch (std::bad_weak_ptr &) {
+          return;  // session is being destroyed
+        }
+        boost::asio::dispatch(strand_, [this, self]() { flush(); });
+      }
+
+      /// Queues a subscription update, applying the slow consumer policy if
+      /// the client already has the maximum number of updates pending.
+      /// Returns false if no new entry has been queued. queueMutex needs to be held
+      bool queueUpdate(OutboundMessage &&message) {
+        if (slowConsumerClosing_) {
+          return false;
+        }
+        if (slowConsumerPolicy == SlowConsumerPolicy::CONFLATE) {
+          auto latest = latestUpdate_.find(message.key);
+          if (latest != latestUpdate_.end()) {
+            *latest->second = std::move(message);
+            conflatedUpdates++;
+            return false;
+          }
+        }
+
+        if (pendingUpdates_ >= outboundQueueDepth) {
+          if (slowConsumerPolicy == SlowConsumerPolicy::DISCONNECT) {
+            slowConsumerClosing_ = true;
+            slowConsumerDisconnects++;
+            logger->Log(LogLevel::WARNING, "Closing Web-Socket connection " + std::to_string(channel.getConnID())
+                        + ", client does not keep up with subscription updates");
+            boost::asio::post(strand_, std::bind(&Derived::doTimeout, derived().shared_from_this()));
+            return false;
+          }
+          dropOldestUpdate();
         }
 
-        boost::asio::buffer_copy(bufferWrite_.prepare(message.size()), boost::asio::buffer(message));
-        bufferWrite_.commit(message.size()); // commit copied data for write
+        writeQueue_.push_back(std::move(message));
+        pendingUpdates_++;
+        if (slowConsumerPolicy == SlowConsumerPolicy::CONFLATE) {
+          latestUpdate_[writeQueue_.back().key] = std::prev(writeQueue_.end());
+        }
+        return true;
+      }
+
+      /// queueMutex needs to be held
+      void dropOldestUpdate() {
+        for (auto it = writeQueue_.begin(); it != writeQueue_.end(); ++it) {
+          if (!it->key.empty()) {
+            forgetUpdate(it);
+            writeQueue_.erase(it);
+            uint64_t dropped = ++droppedUpdates;
+            if (dropped == 1 || dropped % 1000 == 0) {
+              logger->Log(LogLevel::WARNING, "Web-Socket client does not keep up with subscription updates, dropped "
+                          + std::to_string(dropped) + " updates so far");
+            }
+            return;
+          }
+        }
+      }
+
+      /// Removes entry from the pending update bookkeeping. queueMutex needs to be held
+      void forgetUpdate(std::list<OutboundMessage>::iterator entry) {
+        pendingUpdates_--;
+        auto latest = latestUpdate_.find(entry->key);
+        if (latest != latestUpdate_.end() && latest->second == entry) {
+          latestUpdate_.erase(latest);
+        }
+      }
+
+      /// Takes all queued messages in one go and starts sending them
+      void flush() {
+        {
+          std::unique_lock<std::mutex> lock(queueMutex);
+          if (writeQueue_.empty()) {
+            flushing_ = false;
+            return;
+          }
+          sending_.splice(sending_.end(), writeQueue_);
+          pendingUpdates_ = 0;
+          latestUpdate_.clear();
+        }
+        doWrite();
+      }
+
+      /// Sends the first message of sending_. Parts of the message are written
+      /// in place, the entry stays alive until the write completed
+      void doWrite() {
+        const OutboundMessage &message = sending_.front();
+        std::array<boost::asio::const_buffer, 3> buffers{{
+          boost::asio::buffer(message.head),
+          message.body ? boost::asio::buffer(*message.body) : boost::asio::const_buffer(),
+          boost::asio::buffer(message.tail)
+        }};
 
-        // send message
         derived().ws().async_write(
-            bufferWrite_.data(),
+            buffers,
             boost::asio::bind_executor(
                 strand_,
                 std::bind(
@@ -470,71 +734,65 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       }
 
       void onWrite(boost::system::error_code ec, std::size_t bytesTransferred) {
+        boost::ignore_unused(bytesTransferred);
+
         // Happens when the timer closes the socket
         if(ec == boost::asio::error::operation_aborted)
           return;
 
         if(ec) {
-          fail<>(&derived(), ec, "write");
+          fail(channel, ec, "write");
           return;
         }
 
-        // Clear the buffer
-        bufferWrite_.consume(bytesTransferred);
-
-        std::unique_lock<std::mutex> lock(queueMutex);
-
-        writeQueue_.pop_front();
-
-        // check if there is more to write
-        if (!writeQueue_.empty()) {
-          auto message = writeQueue_.front();
-          boost::asio::buffer_copy(bufferWrite_.prepare(message.size()), boost::asio::buffer(message));
-          bufferWrite_.commit(message.size()); // commit copied data for write
-
-          // send message
-          derived().ws().async_write(
-              bufferWrite_.data(),
-              boost::asio::bind_executor(
-                  strand_,
-                  std::bind(
-                      &WebSocketSession::onWrite,
-                      derived().shared_from_this(),
-                      std::placeholders::_1,
-                      std::placeholders::_2)));
+        if (compressing_) {
+          accountCompression(sending_.front());
+        }
+        sending_.pop_front();
+
+        // messages of the current flush are written back to back, only then
+        // the queue is looked at again
+        if (!sending_.empty()) {
+          doWrite();
+        } else {
+          flush();
         }
       }
   };
 
   // Handles a plain WebSocket connection
-  class PlainWebsocketSession : public WebSocketSession<PlainWebsocketSession>,
-                                public std::enable_shared_from_this<PlainWebsocketSession> {
-      websocket::stream<tcp::socket> ws_;
+  template<class Socket>
+  class BasicPlainWebsocketSession : public WebSocketSession<BasicPlainWebsocketSession<Socket>>,
+                                     public std::enable_shared_from_this<BasicPlainWebsocketSession<Socket>> {
+      using Base = WebSocketSession<BasicPlainWebsocketSession<Socket>>;
+
+      websocket::stream<Socket> ws_;
       bool close_ = false;
 
     public:
       // Create the session
-      explicit PlainWebsocketSession(tcp::socket socket, RequestHandler requestHandler)
-      : WebSocketSession<PlainWebsocketSession>(socket.get_executor().target<boost::asio::io_context::executor_type>()->context(), requestHandler),
+      explicit BasicPlainWebsocketSession(Socket socket, RequestHandler requestHandler)
+      : Base(socket.get_executor().template target<boost::asio::io_context::executor_type>()->context(), requestHandler),
         ws_(std::move(socket)) {
       }
 
       // Called by the base class
-      websocket::stream<tcp::socket>& ws() {
+      websocket::stream<Socket>& ws() {
         return ws_;
       }
 
       // Start the asynchronous operation
       template<class Body, class Allocator>
       void run(http::request<Body, http::basic_fields<Allocator>> req) {
-          channel = connHandler.AddClient(this);
+          this->channel = addClient(this->shared_from_this(), Transport<Socket>::websocketType());
+          Transport<Socket>::authorizePeer(ws_.next_layer(), this->channel);
 
           // Run the timer. The timer is operated
           // continuously, this simplifies the code.
-          onTimer({});
+          this->onTimer({});
 
           // Accept the WebSocket upgrade request
-          doAccept(std::move(req));
+          this->doAccept(std::move(req));
       }
 
       void doTimeout() {
@@ -544,16 +802,16 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         close_ = true;
 
         // Set the timer
-        timer_.expires_after(std::chrono::seconds(WEBSOCKET_TIMEOUT_VALUE));
+        this->timer_.expires_after(std::chrono::seconds(WEBSOCKET_TIMEOUT_VALUE));
 
         // Close the WebSocket Connection
         ws_.async_close(
             websocket::close_code::normal,
             boost::asio::bind_executor(
-                strand_,
+                this->strand_,
                 std::bind(
-                    &PlainWebsocketSession::on_close,
-                    shared_from_this(),
+                    &BasicPlainWebsocketSession::on_close,
+                    this->shared_from_this(),
                     std::placeholders::_1)));
       }
 
@@ -563,7 +821,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           return;
 
         if(ec) {
-          fail<>(this, ec, "close");
+          fail(this->channel, ec, "close");
           return;
         }
 
@@ -571,12 +829,14 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       }
   };
 
+  // Handles a plain WebSocket connection over TCP or a Unix domain socket
+  using PlainWebsocketSession = BasicPlainWebsocketSession<tcp::socket>;
+  using LocalWebsocketSession = BasicPlainWebsocketSession<local_stream::socket>;
+
   // Handles an SSL WebSocket connection
   class SslWebsocketSession : public WebSocketSession<SslWebsocketSession>,
                               public std::enable_shared_from_this<SslWebsocketSession> {
       websocket::stream<ssl_stream<tcp::socket>> ws_;
-      boost::asio::strand<
-      boost::asio::io_context::executor_type> strand_;
       bool eof_ = false;
 
     public:
@@ -584,8 +844,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       explicit SslWebsocketSession(ssl_stream<tcp::socket> stream, RequestHandler requestHandler)
         : WebSocketSession<SslWebsocketSession>(
           stream.get_executor().target<boost::asio::io_context::executor_type>()->context(), requestHandler)
-          , ws_(std::move(stream))
-          , strand_(*ws_.get_executor().target<boost::asio::io_context::executor_type>()) {
+          , ws_(std::move(stream)) {
       }
 
       // Called by the base class
@@ -598,7 +857,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       // Start the asynchronous operation
       template<class Body, class Allocator>
       void run(http::request<Body, http::basic_fields<Allocator>> req) {
-          channel = connHandler.AddClient(this);
+          channel = addClient(shared_from_this(), KuksaChannel::Type::WEBSOCKET_SSL);
 
           // Run the timer. The timer is operated
           // continuously, this simplifies the code.
@@ -630,11 +889,11 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           return;
 
         if(ec) {
-          fail<>(this, ec, "shutdown");
+          fail(channel, ec, "shutdown");
           return;
         }
 
-        connHandler.RemoveClient(this);
+        connections.remove(channel.getConnID());
         // At this point the connection is closed gracefully
       }
 
@@ -651,11 +910,11 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       }
   };
 
-  template<class Body, class Allocator>
-  void makeWebsocketSession(tcp::socket socket,
+  template<class Socket, class Body, class Allocator>
+  void makeWebsocketSession(Socket socket,
                             http::request<Body, http::basic_fields<Allocator>> req,
                             RequestHandler requestHandler) {
-    std::make_shared<PlainWebsocketSession>(
+    std::make_shared<BasicPlainWebsocketSession<Socket>>(
         std::move(socket), requestHandler)->run(std::move(req));
   }
 
@@ -673,7 +932,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
   // This uses the Curiously Recurring Template Pattern so that
   // the same code works with both SSL streams and regular sockets.
   template<class Derived>
-  class HttpSession {
+  class HttpSession : public IConnection {
       // Access the derived class, this is part of
       // the Curiously Recurring Template Pattern idiom.
       Derived& derived() {
@@ -707,6 +966,10 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
             return items_.size() >= limit;
           }
 
+          bool empty() const {
+            return items_.empty();
+          }
+
           // Called when a message finishes sending
           // Returns `true` if the caller should initiate a read
           bool onWrite() {
@@ -768,6 +1031,18 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       boost::beast::flat_buffer bufferRead_;
       RequestHandler requestHandler_;
       KuksaChannel channel;
+      /// Token the connection has been authorized with by REST requests
+      std::string restToken_;
+
+      /// Server-Sent Events stream sent on the connection, which then only
+      /// writes events. The members below are owned by strand_
+      std::shared_ptr<SseStream> eventStream_;
+      uint64_t eventStreamAttachment_ = 0;
+      bool eventStreamPending_ = false;
+      bool eventStreamClosing_ = false;
+      bool eventWriting_ = false;
+      std::deque<std::shared_ptr<const std::string>> eventQueue_;
+      std::array<char, 256> eventReadBuffer_;
 
     public:
       // Construct the session
@@ -782,6 +1057,19 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         , requestHandler_(requestHandler) {
       }
 
+      ~HttpSession() {
+        connections.remove(channel.getConnID());
+        // the client may resume the stream on another connection
+        if (eventStream_) {
+          eventStream_->detach(eventStreamAttachment_);
+        }
+      }
+
+      /// Nothing is pushed to REST clients, event streams are connections of their own
+      bool send(const OutboundMessage &) override {
+        return true;
+      }
+
       void doRead() {
         // Set the timer
         timer_.expires_after(std::chrono::seconds(HTTP_TIMEOUT_VALUE));
@@ -806,7 +1094,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       // Called when the timer expires.
       void onTimer(boost::system::error_code ec) {
         if(ec && ec != boost::asio::error::operation_aborted) {
-          fail<>(&derived(), ec, "timer");
+          fail(channel, ec, "timer");
           return;
         }
 
@@ -834,7 +1122,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           return derived().doEof();
 
         if(ec)
-          fail(ec, "read");
+          return fail(ec, "read");
 
         // See if it is a WebSocket Upgrade
         if(websocket::is_upgrade(req_)) {
@@ -844,20 +1132,72 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
               std::move(req_), requestHandler_);
         }
 
-        // Otherwise ignore request
+        // A subscription to be streamed as Server-Sent Events, which takes
+        // over the connection once the responses before are sent
+        if(req_.method() == http::verb::get &&
+           RestApi::isRestTarget(std::string(req_.target())) &&
+           std::string(req_[http::field::accept]).find("text/event-stream") != std::string::npos) {
+          eventStreamPending_ = true;
+          if(queue_.empty())
+            startEventStream();
+          return;
+        }
+
+        // Otherwise it is a REST request
+        queue_(handleRest());
 
         // If we aren't at the queue limit, try to pipeline another request
         if(! queue_.is_full())
           doRead();
       }
 
+      RestApi::Request restRequest() const {
+        RestApi::Request request;
+        request.method = std::string(req_.method_string());
+        request.target = std::string(req_.target());
+        request.body = req_.body();
+        request.ifNoneMatch = std::string(req_[http::field::if_none_match]);
+        request.authorization = std::string(req_[http::field::authorization]);
+        return request;
+      }
+
+      http::response<http::string_body> handleRest() {
+        RestApi::Response result = RestApi::handle(
+            restRequest(),
+            [this](jsoncons::json &query) {
+              return jsoncons::json::parse(requestHandler_(query.to_string(), channel));
+            },
+            [this](const std::string &path) {
+              return revisionHandler(path, channel);
+            },
+            restToken_);
+        return restResponse(std::move(result));
+      }
+
+      http::response<http::string_body> restResponse(RestApi::Response result) const {
+        http::response<http::string_body> res{static_cast<http::status>(result.status), req_.version()};
+        if (!result.body.empty()) {
+          res.set(http::field::content_type, "application/json");
+          res.body() = std::move(result.body);
+        }
+        if (!result.etag.empty()) {
+          res.set(http::field::etag, result.etag);
+        }
+        if (result.status == 405) {
+          res.set(http::field::allow, "GET, PUT");
+        }
+        res.keep_alive(req_.keep_alive());
+        res.prepare_payload();
+        return res;
+      }
+
       void onWrite(boost::system::error_code ec, bool close) {
         // Happens when the timer closes the socket
         if(ec == boost::asio::error::operation_aborted)
           return;// provide error JSON
 
         if(ec) {
-          fail<>(&derived(), ec, "write");
+          fail(channel, ec, "write");
           return;
         }
 
@@ -872,54 +1212,189 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           // Read another request
           doRead();
         }
+        else if(eventStreamPending_ && queue_.empty()) {
+          startEventStream();
+        }
+      }
+
+      /// Resumes the stream named by Last-Event-ID if it was authorized with
+      /// the same token, otherwise subscribes for a new stream
+      void startEventStream() {
+        eventStreamPending_ = false;
+        RestApi::Request request = restRequest();
+
+        uint64_t lastSeen = 0;
+        std::shared_ptr<SseStream> stream = sseStreams.resume(std::string(req_["Last-Event-ID"]), lastSeen);
+        if(stream && stream->token != RestApi::bearerToken(request.authorization)) {
+          stream = nullptr;
+        }
+        if(!stream) {
+          lastSeen = 0;
+          stream = sseStreams.create();
+          stream->token = restToken_;
+          // the subscriptions belong to the stream, not to this connection
+          KuksaChannel streamChannel = channel;
+          streamChannel.setConnID(stream->connID());
+          RestApi::Response result = RestApi::subscribe(
+              request,
+              [this, &streamChannel](jsoncons::json &query) {
+                return jsoncons::json::parse(requestHandler_(query.to_string(), streamChannel));
+              },
+              stream->token,
+              stream->subscriptionIds);
+          if(result.status != 200) {
+            sseStreams.remove(stream);
+            queue_(restResponse(std::move(result)));
+            doRead();
+            return;
+          }
+        }
+
+        eventStream_ = stream;
+        eventQueue_.push_back(std::make_shared<const std::string>(
+            std::string(req_.version() == 10 ? "HTTP/1.0" : "HTTP/1.1") + " 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: close\r\n\r\n"));
+        writeEvent();
+
+        std::weak_ptr<Derived> weakSelf = derived().shared_from_this();
+        eventStreamAttachment_ = stream->attach(
+            [weakSelf](std::shared_ptr<const std::string> event) {
+              if(auto self = weakSelf.lock()) {
+                boost::asio::post(self->strand_, [self, event]() { self->queueEvent(event); });
+              }
+            },
+            lastSeen);
+
+        // Nothing is expected from the client anymore, but reading tells when it goes away
+        readUntilClosed();
+      }
+
+      void queueEvent(std::shared_ptr<const std::string> event) {
+        if(eventStreamClosing_)
+          return;
+        if(eventQueue_.size() >= outboundQueueDepth) {
+          // the client gets the events from the replay buffer when it resumes
+          slowConsumerDisconnects++;
+          logger->Log(LogLevel::WARNING, "Closing event stream " + eventStream_->name()
+                      + ", client does not keep up with subscription updates");
+          return stopEventStream();
+        }
+        eventQueue_.push_back(std::move(event));
+        if(!eventWriting_)
+          writeEvent();
+      }
+
+      void writeEvent() {
+        eventWriting_ = true;
+        boost::asio::async_write(
+            derived().stream(),
+            boost::asio::buffer(*eventQueue_.front()),
+            boost::asio::bind_executor(
+                strand_,
+                std::bind(
+                    &HttpSession::onEventWrite,
+                    derived().shared_from_this(),
+                    std::placeholders::_1)));
+      }
+
+      void onEventWrite(boost::system::error_code ec) {
+        eventWriting_ = false;
+        if(ec) {
+          if(ec != boost::asio::error::operation_aborted)
+            fail(ec, "write");
+          return stopEventStream();
+        }
+        // stopEventStream only kept the entry that has just been written
+        if(eventStreamClosing_ || eventQueue_.empty())
+          return;
+        eventQueue_.pop_front();
+        if(!eventQueue_.empty())
+          writeEvent();
+      }
+
+      void readUntilClosed() {
+        derived().stream().async_read_some(
+            boost::asio::buffer(eventReadBuffer_),
+            boost::asio::bind_executor(
+                strand_,
+                std::bind(
+                    &HttpSession::onReadUntilClosed,
+                    derived().shared_from_this(),
+                    std::placeholders::_1)));
+      }
+
+      void onReadUntilClosed(boost::system::error_code ec) {
+        if(ec)
+          return stopEventStream();
+        readUntilClosed();
+      }
+
+      /// Detaches from the stream, which can be resumed on another connection,
+      /// and closes the connection
+      void stopEventStream() {
+        if(eventStreamClosing_)
+          return;
+        eventStreamClosing_ = true;
+        eventStream_->detach(eventStreamAttachment_);
+        // a pending write still uses the buffer of the front entry
+        if(eventWriting_)
+          eventQueue_.erase(std::next(eventQueue_.begin()), eventQueue_.end());
+        else
+          eventQueue_.clear();
+
+        boost::system::error_code ec;
+        timer_.cancel(ec);
+        derived().stream().lowest_layer().shutdown(tcp::socket::shutdown_both, ec);
+        derived().stream().lowest_layer().close(ec);
       }
   };
 
-  // Handles a plain HTTP connection
-  class PlainHttpSession : public HttpSession<PlainHttpSession>,
-                           public std::enable_shared_from_this<PlainHttpSession> {
-      tcp::socket socket_;
-      boost::asio::strand<
-      boost::asio::io_context::executor_type> strand_;
+  // Handles a plain HTTP connection over TCP or a Unix domain socket
+  template<class Socket>
+  class BasicPlainHttpSession : public HttpSession<BasicPlainHttpSession<Socket>>,
+                                public std::enable_shared_from_this<BasicPlainHttpSession<Socket>> {
+      Socket socket_;
 
     public:
       // Create the http_session
-      PlainHttpSession(tcp::socket socket,
-                       boost::beast::flat_buffer buffer,
-                       RequestHandler requestHandler)
-        : HttpSession<PlainHttpSession>(
-            socket.get_executor().target<boost::asio::io_context::executor_type>()->context(),
+      BasicPlainHttpSession(Socket socket,
+                            boost::beast::flat_buffer buffer,
+                            RequestHandler requestHandler)
+        : HttpSession<BasicPlainHttpSession<Socket>>(
+            socket.get_executor().template target<boost::asio::io_context::executor_type>()->context(),
             std::move(buffer),
             requestHandler)
-            , socket_(std::move(socket))
-            , strand_(*socket_.get_executor().target<boost::asio::io_context::executor_type>()){
+            , socket_(std::move(socket)) {
       }
 
       // Called by the base class
-      tcp::socket& stream() {
+      Socket& stream() {
         return socket_;
       }
 
       // Called by the base class
-      tcp::socket release_stream() {
+      Socket release_stream() {
         return std::move(socket_);
       }
 
       // Start the asynchronous operation
       void run() {
-        channel = connHandler.AddClient(this);
+        this->channel = addClient(this->shared_from_this(), Transport<Socket>::httpType());
+        Transport<Socket>::authorizePeer(socket_, this->channel);
 
         // Run the timer. The timer is operated
         // continuously, this simplifies the code.
-        onTimer({});
+        this->onTimer({});
 
-        doRead();
+        this->doRead();
       }
 
       void doEof() {
         // Send a TCP shutdown
         boost::system::error_code ec;
-        socket_.shutdown(tcp::socket::shutdown_send, ec);
+        socket_.shutdown(Socket::shutdown_send, ec);
 
         // At this point the connection is closed gracefully
       }
@@ -928,17 +1403,18 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         // Closing the socket cancels all outstanding operations. They
         // will complete with boost::asio::error::operation_aborted
         boost::system::error_code ec;
-        socket_.shutdown(tcp::socket::shutdown_both, ec);
+        socket_.shutdown(Socket::shutdown_both, ec);
         socket_.close(ec);
       }
   };
 
+  using PlainHttpSession = BasicPlainHttpSession<tcp::socket>;
+  using LocalHttpSession = BasicPlainHttpSession<local_stream::socket>;
+
   // Handles an SSL HTTP connection
   class SslHttpSession : public HttpSession<SslHttpSession>,
                          public std::enable_shared_from_this<SslHttpSession> {
       ssl_stream<tcp::socket> stream_;
-      boost::asio::strand<
-      boost::asio::io_context::executor_type> strand_;
       bool eof_ = false;
 
     public:
@@ -951,8 +1427,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
             socket.get_executor().target<boost::asio::io_context::executor_type>()->context(),
             std::move(buffer),
             requestHandler)
-            , stream_(std::move(socket), ctx)
-            , strand_(*stream_.get_executor().target<boost::asio::io_context::executor_type>()) {
+            , stream_(std::move(socket), ctx) {
       }
 
       // Called by the base class
@@ -967,7 +1442,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
 
       // Start the asynchronous operation
       void run() {
-        channel = connHandler.AddClient(this);
+        channel = addClient(shared_from_this(), KuksaChannel::Type::HTTP_SSL);
 
         // Run the timer. The timer is operated
         // continuously, this simplifies the code.
@@ -1031,7 +1506,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         if(ec)
           return fail(ec, "shutdown");
 
-        connHandler.RemoveClient(this);
+        connections.remove(channel.getConnID());
         // At this point the connection is closed gracefully
       }
 
@@ -1112,6 +1587,10 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       }
   };
 
+  /// Lets several sockets bind the same address, the kernel distributes
+  /// incoming connections across them
+  using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
   //// Accepts incoming connections and launches the sessions
   class BeastListener : public std::enable_shared_from_this<BeastListener> {
       ssl::context& ctx_;
@@ -1123,7 +1602,8 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       BeastListener(boost::asio::io_context& ioc,
                     ssl::context& ctx,
                     tcp::endpoint endpoint,
-                    RequestHandler requestHandler)
+                    RequestHandler requestHandler,
+                    bool reusePort = false)
         : ctx_(ctx)
         , acceptor_(ioc)
         , socket_(ioc)
@@ -1145,6 +1625,15 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           failFatal(ec, "set_option");
           return;
         }
+        if(reusePort)
+        {
+          acceptor_.set_option(reuse_port(true), ec);
+          if(ec)
+          {
+            failFatal(ec, "set_option SO_REUSEPORT");
+            return;
+          }
+        }
 
         // Bind to the server address
         acceptor_.bind(endpoint, ec);
@@ -1199,25 +1688,291 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       }
   };
 
+  //// Accepts connections on a Unix domain socket and launches plain sessions,
+  //// distributing them across the io_contexts
+  class LocalListener : public std::enable_shared_from_this<LocalListener> {
+      local_stream::acceptor acceptor_;
+      std::vector<boost::asio::io_context*> iocs_;
+      size_t next_ = 0;
+      RequestHandler requestHandler_;
+
+    public:
+      LocalListener(std::vector<boost::asio::io_context*> iocs,
+                    const std::string &path,
+                    RequestHandler requestHandler)
+        : acceptor_(*iocs.front())
+        , iocs_(std::move(iocs))
+        , requestHandler_(requestHandler) {
+        boost::system::error_code ec;
+
+        // A socket file left behind by a previous run would make bind fail
+        struct stat status;
+        if(::stat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+          ::unlink(path.c_str());
+
+        acceptor_.open(local_stream(), ec);
+        if(ec)
+        {
+          failFatal(ec, "open");
+          return;
+        }
+
+        acceptor_.bind(local_stream::endpoint(path), ec);
+        if(ec)
+        {
+          failFatal(ec, "bind");
+          return;
+        }
+
+        acceptor_.listen(
+            boost::asio::socket_base::max_listen_connections, ec);
+        if(ec)
+        {
+          failFatal(ec, "listen");
+          return;
+        }
+      }
+
+      // Start accepting incoming connections
+      void run() {
+        if(! acceptor_.is_open())
+          return;
+        doAccept();
+      }
+
+      void doAccept() {
+        boost::asio::io_context &ioc = *iocs_[next_++ % iocs_.size()];
+        acceptor_.async_accept(
+            ioc,
+            std::bind(
+                &LocalListener::onAccept,
+                shared_from_this(),
+                std::placeholders::_1,
+                std::placeholders::_2));
+      }
+
+      void onAccept(boost::system::error_code ec, local_stream::socket socket) {
+        if(ec)
+        {
+          fail(ec, "accept");
+        }
+        else
+        {
+          // Local clients are trusted with plain connections, access is
+          // controlled by the permissions of the socket file
+          std::make_shared<LocalHttpSession>(
+              std::move(socket),
+              boost::beast::flat_buffer(),
+              requestHandler_)->run();
+        }
+
+        // Accept another connection
+        doAccept();
+      }
+  };
+
 
 const std::string WebSockHttpFlexServer::serverCertFilename_ = "Server.pem";
 const std::string WebSockHttpFlexServer::serverKeyFilename_  = "Server.key";
 
 
 WebSockHttpFlexServer::WebSockHttpFlexServer(std::shared_ptr<ILogger> loggerUtil)
- : logger_(loggerUtil),
-  ioc_(NumOfThreads)
+ : logger_(loggerUtil)
    {
   logger = logger_;
 }
 
+WebSockHttpFlexServer::WebSockHttpFlexServer(std::shared_ptr<ILogger> loggerUtil,
+                                             const boost::program_options::variables_map &config)
+ : WebSockHttpFlexServer(loggerUtil) {
+  std::string policy = config["websocket.slow-consumer-policy"].as<std::string>();
+  if (policy == "conflate") {
+    SetOutboundQueue(config["websocket.queue-depth"].as<size_t>(), SlowConsumerPolicy::CONFLATE);
+  } else if (policy == "drop-oldest") {
+    SetOutboundQueue(config["websocket.queue-depth"].as<size_t>(), SlowConsumerPolicy::DROP_OLDEST);
+  } else if (policy == "disconnect") {
+    SetOutboundQueue(config["websocket.queue-depth"].as<size_t>(), SlowConsumerPolicy::DISCONNECT);
+  } else {
+    throw boost::program_options::invalid_option_value(policy);
+  }
+  SetIoThreads(config["websocket.io-threads"].as<unsigned>(),
+               config["websocket.io-context-per-thread"].as<bool>(),
+               config["websocket.pin-io-threads"].as<bool>());
+  SetRequestWorkers(config["websocket.request-workers"].as<unsigned>(),
+                    config["websocket.request-queue-size"].as<size_t>());
+  SetCompression(config["websocket.deflate"].as<bool>(),
+                 config["websocket.deflate-window-bits"].as<int>(),
+                 config["websocket.deflate-mem-level"].as<int>(),
+                 config["websocket.deflate-threshold"].as<size_t>(),
+                 !config["websocket.deflate-no-context-takeover"].as<bool>());
+  SetEventStreamResume(config["websocket.sse-replay-size"].as<size_t>(),
+                       std::chrono::seconds(config["websocket.sse-resume-timeout"].as<unsigned>()));
+  if (config.count("websocket.unix-socket")) {
+    std::string permissions;
+    if (config.count("websocket.unix-socket-permissions")) {
+      permissions = config["websocket.unix-socket-permissions"].as<boost::filesystem::path>().string();
+    }
+    SetLocalSocket(config["websocket.unix-socket"].as<boost::filesystem::path>().string(), permissions);
+  }
+}
+
+boost::program_options::options_description& WebSockHttpFlexServer::getOptions() {
+  static boost::program_options::options_description websocket_desc("Web-Socket Options");
+  websocket_desc.add_options()(
+      "websocket.queue-depth", boost::program_options::value<size_t>()->default_value(outboundQueueDepth),
+      "Number of subscription updates that may be pending for a single Web-Socket "
+      "client that does not read them fast enough")(
+      "websocket.slow-consumer-policy", boost::program_options::value<std::string>()->default_value("conflate"),
+      "What to do when a client has queue-depth updates pending:\n"
+      "conflate: replace a pending update of the same subscription with the new value, "
+      "otherwise drop the oldest pending update\n"
+      "drop-oldest: drop the oldest pending update\n"
+      "disconnect: close the connection")(
+      "websocket.io-threads", boost::program_options::value<unsigned>()->default_value(1),
+      "Number of threads handling Web-Socket and HTTP connections. 0 uses one "
+      "thread per CPU core")(
+      "websocket.io-context-per-thread", boost::program_options::bool_switch()->default_value(false),
+      "Give every I/O thread its own event loop and listening socket, the "
+      "operating system distributes new connections across them. By default "
+      "all I/O threads share one event loop")(
+      "websocket.pin-io-threads", boost::program_options::bool_switch()->default_value(false),
+      "Bind every I/O thread to its own CPU core")(
+      "websocket.request-workers", boost::program_options::value<unsigned>()->default_value(0),
+      "Number of threads processing Web-Socket requests. 0 processes requests "
+      "on the I/O threads, so slow requests delay other connections")(
+      "websocket.request-queue-size", boost::program_options::value<size_t>()->default_value(requestQueueLimit),
+      "Number of requests that may be waiting for or in processing by the request "
+      "threads. Further requests are answered with error 503")(
+      "websocket.deflate", boost::program_options::bool_switch()->default_value(false),
+      "Compress Web-Socket messages (permessage-deflate) for clients supporting it")(
+      "websocket.deflate-window-bits", boost::program_options::value<int>()->default_value(15),
+      "Size of the compression window as power of two, 9 to 15. Smaller windows "
+      "need less memory per connection but compress less")(
+      "websocket.deflate-mem-level", boost::program_options::value<int>()->default_value(4),
+      "Memory used for compression state per connection, 1 to 9")(
+      "websocket.deflate-threshold", boost::program_options::value<size_t>()->default_value(0),
+      "Send messages smaller than this number of bytes uncompressed. Ignored, "
+      "with a warning, if the Boost.Beast version in use can not do that")(
+      "websocket.deflate-no-context-takeover", boost::program_options::bool_switch()->default_value(false),
+      "Compress every message on its own instead of referring to previous "
+      "messages. Saves memory per connection, but compresses less")(
+      "websocket.sse-replay-size", boost::program_options::value<size_t>()->default_value(256),
+      "Number of events kept per Server-Sent Events stream, so that clients "
+      "resuming with Last-Event-ID get the events they missed")(
+      "websocket.sse-resume-timeout", boost::program_options::value<unsigned>()->default_value(30),
+      "Seconds the subscriptions of a Server-Sent Events stream are kept after "
+      "its connection closed, for the client to resume the stream")(
+      "websocket.unix-socket", boost::program_options::value<boost::filesystem::path>(),
+      "Also accept plain Web-Socket and HTTP connections on this Unix domain "
+      "socket, for clients on the same host")(
+      "websocket.unix-socket-permissions", boost::program_options::value<boost::filesystem::path>(),
+      "JSON file granting permissions to clients on the Unix domain socket by "
+      "the user running them, in the format of the JWT token claims. Clients "
+      "of other users authorize with a token");
+  return websocket_desc;
+}
+
+void WebSockHttpFlexServer::SetOutboundQueue(size_t depth, SlowConsumerPolicy policy) {
+  if (depth == 0) {
+    throw std::invalid_argument("Web-Socket queue depth must not be 0");
+  }
+  outboundQueueDepth = depth;
+  slowConsumerPolicy = policy;
+}
+
+void WebSockHttpFlexServer::SetIoThreads(unsigned threads, bool contextPerThread, bool pinThreads) {
+  ioThreads_ = threads;
+  ioContextPerThread_ = contextPerThread;
+  pinIoThreads_ = pinThreads;
+}
+
+void WebSockHttpFlexServer::SetRequestWorkers(unsigned workers, size_t queueLimit) {
+  if (queueLimit == 0) {
+    throw std::invalid_argument("Request queue size must not be 0");
+  }
+  requestQueueLimit = queueLimit;
+  if (requestPool) {
+    requestPool->join();
+    requestPool.reset();
+  }
+  if (workers > 0) {
+    requestPool.reset(new boost::asio::thread_pool(workers));
+  }
+}
+
+void WebSockHttpFlexServer::SetCompression(bool enable, int windowBits, int memLevel,
+                                           size_t threshold, bool contextTakeover) {
+  // zlib does not support a window of 8 bits for raw deflate streams
+  if (windowBits < 9 || windowBits > 15) {
+    throw std::invalid_argument("Deflate window bits must be between 9 and 15");
+  }
+  if (memLevel < 1 || memLevel > 9) {
+    throw std::invalid_argument("Deflate memory level must be between 1 and 9");
+  }
+  deflateOptions.server_enable = enable;
+  deflateOptions.server_max_window_bits = windowBits;
+  deflateOptions.client_max_window_bits = windowBits;
+  deflateOptions.memLevel = memLevel;
+  deflateOptions.server_no_context_takeover = !contextTakeover;
+  deflateOptions.client_no_context_takeover = !contextTakeover;
+  deflateThreshold = threshold;
+  deflateThresholdSupported = setDeflateThreshold(deflateOptions, threshold, 0);
+  if (enable && threshold > 0 && !deflateThresholdSupported) {
+    logger_->Log(LogLevel::WARNING, "This Boost.Beast version compresses all messages, "
+                 "ignoring deflate threshold of " + std::to_string(threshold) + " bytes");
+  }
+}
+
+void WebSockHttpFlexServer::SetLocalSocket(const std::string &path, const std::string &permissionsFile) {
+  localSocketPath = path;
+  peerCredentials.reset();
+  if (!permissionsFile.empty()) {
+    peerCredentials = std::make_shared<const PeerCredentials>(PeerCredentials::fromFile(permissionsFile));
+  }
+}
+
+void WebSockHttpFlexServer::SetEventStreamResume(size_t replaySize, std::chrono::seconds resumeTimeout) {
+  sseStreams.configure(replaySize, resumeTimeout);
+}
+
+void WebSockHttpFlexServer::SetSubscriptionHandler(std::weak_ptr<ISubscriptionHandler> subHandler) {
+  sseStreams.setSubscriptionHandler(std::move(subHandler));
+}
+
+CompressionStats WebSockHttpFlexServer::GetCompressionStats() const {
+  return CompressionStats{compressedMessages.load(), compressedBytes.load(), sampledBytes.load(),
+                          sampledCompressedBytes.load(), sampledNanoseconds.load()};
+}
+
+OutboundQueueStats WebSockHttpFlexServer::GetOutboundQueueStats() const {
+  return OutboundQueueStats{droppedUpdates.load(), conflatedUpdates.load(), slowConsumerDisconnects.load()};
+}
+
 WebSockHttpFlexServer::~WebSockHttpFlexServer() {
-  ioc_.stop(); // stop execution of io runner
+  CompressionStats compression = GetCompressionStats();
+  if (compression.sampledBytes > 0) {
+    logger_->Log(LogLevel::INFO, "Compressed " + std::to_string(compression.messages) + " Web-Socket messages, "
+                 + std::to_string(compression.bytes) + " bytes, to about "
+                 + std::to_string(100 * compression.sampledCompressedBytes / compression.sampledBytes) + "%");
+  }
+
+  // stop execution of io runners
+  for(auto& ioc : iocs_) {
+    ioc->stop();
+  }
 
   // wait to finish
   for(auto& thread : iocRunners) {
     thread.join();
   }
+  sseSweepTimer.reset();
+  if (localListener) {
+    ::unlink(localSocketPath.c_str());
+  }
+  if (requestPool) {
+    requestPool->stop();
+    requestPool->join();
+  }
 }
 void WebSockHttpFlexServer::Initialize(std::string host,
                                        int port,
@@ -1233,7 +1988,20 @@ void WebSockHttpFlexServer::Initialize(std::string host,
 
     ctx.set_options(ssl::context::default_workarounds);
 
-    boost::asio::ip::tcp::resolver resolver{ioc_};
+    if (ioThreads_ == 0) {
+      ioThreads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (ioContextPerThread_) {
+      for (unsigned i = 0; i < ioThreads_; ++i) {
+        iocs_.emplace_back(new boost::asio::io_context(1));
+      }
+    } else {
+      iocs_.emplace_back(new boost::asio::io_context(ioThreads_));
+    }
+    logger_->Log(LogLevel::INFO, "Handling connections on " + std::to_string(ioThreads_) + " threads" +
+                 (ioContextPerThread_ ? ", each with its own event loop" : ""));
+
+    boost::asio::ip::tcp::resolver resolver{*iocs_.front()};
     boost::asio::ip::tcp::resolver::query query(host, to_string(port));
     boost::asio::ip::tcp::resolver::iterator resolvedHost = resolver.resolve(query);
 
@@ -1245,16 +2013,41 @@ void WebSockHttpFlexServer::Initialize(std::string host,
                                        this,
                                        std::placeholders::_1,
                                        std::placeholders::_2);
+    revisionHandler = std::bind(&WebSockHttpFlexServer::HandleRevisionRequest,
+                                this,
+                                std::placeholders::_1,
+                                std::placeholders::_2);
+
+    // create listeners for handling incoming connections, one per io_context
+    for (auto& ioc : iocs_) {
+      connListeners.push_back(std::make_shared<BeastListener>(
+        *ioc,
+        ctx,
+        resolvedHost->endpoint(),
+        reqHndl,
+        ioContextPerThread_));
+    }
 
-    // create listener for handling incoming connections
-    connListener = std::make_shared<BeastListener>(
-      ioc_,
-      ctx,
-      resolvedHost->endpoint(),
-      std::bind(&WebSockHttpFlexServer::HandleRequest,
-                this,
-                std::placeholders::_1,
-                std::placeholders::_2));
+    if (!localSocketPath.empty()) {
+      logger_->Log(LogLevel::INFO, "Accepting local connections on " + localSocketPath);
+      std::vector<boost::asio::io_context*> localIocs;
+      for (auto& ioc : iocs_) {
+        localIocs.push_back(ioc.get());
+      }
+      localListener = std::make_shared<LocalListener>(localIocs, localSocketPath, reqHndl);
+    }
+}
+
+std::string WebSockHttpFlexServer::HandleRevisionRequest(const std::string &path, KuksaChannel &channel) {
+  std::string tag;
+  for (auto const& handler : listeners_)
+  {
+    if ((handler.first == ObserverType::ALL) || (handler.first == ObserverType::HTTP))
+    {
+      tag = handler.second->getRevisionTag(channel, path);
+    }
+  }
+  return tag;
 }
 
 std::string WebSockHttpFlexServer::HandleRequest(const std::string &req_json, KuksaChannel &channel) {
@@ -1263,7 +2056,8 @@ std::string WebSockHttpFlexServer::HandleRequest(const std::string &req_json, Ku
   ObserverType handlerType;
 
   if ((type == KuksaChannel::Type::WEBSOCKET_PLAIN) ||
-      (type == KuksaChannel::Type::WEBSOCKET_SSL))
+      (type == KuksaChannel::Type::WEBSOCKET_SSL) ||
+      (type == KuksaChannel::Type::WEBSOCKET_LOCAL))
   {
     handlerType = ObserverType::WEBSOCKET;
   }
@@ -1272,15 +2066,30 @@ std::string WebSockHttpFlexServer::HandleRequest(const std::string &req_json, Ku
     handlerType = ObserverType::HTTP;
   }
 
+  auto const encoding = channel.getEncoding();
+  jsoncons::json request;
+  if (encoding != KuksaChannel::Encoding::JSON) {
+    try {
+      request = MessageEncoding::decode(req_json, encoding);
+    } catch (std::exception &e) {
+      logger_->Log(LogLevel::WARNING, "Can not decode " + MessageEncoding::subprotocol(encoding) + " request");
+      return MessageEncoding::encode(JsonResponses::malFormedRequest(e.what()), encoding);
+    }
+  }
+
   for (auto const& handler : listeners_)
   {
     if ((handler.first == ObserverType::ALL) || (handler.first == handlerType))
     {
-      response = handler.second->processQuery(req_json, channel);
+      if (encoding == KuksaChannel::Encoding::JSON) {
+        response = handler.second->processQuery(req_json, channel);
+      } else {
+        response = handler.second->processQuery(request, channel);
+      }
     }
   }
 
-  return response.as<std::string>();
+  return MessageEncoding::encode(response, encoding);
 }
 
 void WebSockHttpFlexServer::AddListener(ObserverType type,
@@ -1370,6 +2179,10 @@ void WebSockHttpFlexServer::LoadCertData(std::string & certPath, boost::asio::ss
 //Returns false, if connection is not found, as hint to caller to remove any state
 //regarding that connection
 bool WebSockHttpFlexServer::SendToConnection(ConnectionId connID, const std::string &message) {
+  return SendToConnection(connID, OutboundMessage{message, nullptr, std::string(), std::string()});
+}
+
+bool WebSockHttpFlexServer::SendToConnection(ConnectionId connID, const OutboundMessage &message) {
   if (!isInitialized)
   {
     std::string err("Cannot send to connection, server not initialized!");
@@ -1377,55 +2190,17 @@ bool WebSockHttpFlexServer::SendToConnection(ConnectionId connID, const std::str
     throw std::runtime_error(err);
   }
 
-  bool isFound = false;
-
-  // try to find active connection to send data to
-
-  if (!isFound) {
-    auto session = reinterpret_cast<PlainWebsocketSession *>(connID);
-    std::lock_guard<std::mutex> lock(connHandler.mPlainWebSock_);
-    auto iter = connHandler.connPlainWebSock_.find(session);
-    if (iter != std::end(connHandler.connPlainWebSock_))
-    {
-      isFound = true;
-      session->write(message);
-    }
-  }
-  if (!isFound) {
-    auto session = reinterpret_cast<SslWebsocketSession *>(connID);
-    std::lock_guard<std::mutex> lock(connHandler.mSslWebSock_);
-    auto iter = connHandler.connSslWebSock_.find(session);
-    if (iter != std::end(connHandler.connSslWebSock_))
-    {
-      isFound = true;
-      session->write(message);
-    }
-  }
-  if (!isFound) {
-    auto session = reinterpret_cast<PlainHttpSession *>(connID);
-    std::lock_guard<std::mutex> lock(connHandler.mPlainHttp_);
-    auto iter = connHandler.connPlainHttp_.find(session);
-    if (iter != std::end(connHandler.connPlainHttp_))
-    {
-      isFound = true;
-      // TODO: check how we are going to handle ASYNC writes on HTTP connection?
-    }
+  // one lookup for Web-Socket sessions, HTTP sessions and event streams alike
+  std::shared_ptr<IConnection> connection = connections.find(connID);
+  if (!connection) {
+    logger_->Log(LogLevel::VERBOSE, "Trying to publish on nonexisting connection ");
+    return false;
   }
-  if (!isFound) {
-    auto session = reinterpret_cast<SslHttpSession *>(connID);
-    std::lock_guard<std::mutex> lock(connHandler.mSslHttp_);
-    auto iter = connHandler.connSslHttp_.find(session);
-    if (iter != std::end(connHandler.connSslHttp_))
-    {
-      isFound = true;
-      // TODO: check how we are going to handle ASYNC writes on HTTP connection?
-    }
-  }
-
-  if(!isFound) {
-      logger_->Log(LogLevel::VERBOSE, "Trying to publish on nonexisting connection ");
+  if (!connection->send(message)) {
+    connections.remove(connID);
+    return false;
   }
-  return isFound;
+  return true;
 }
 
 void WebSockHttpFlexServer::Start() {
@@ -1439,16 +2214,40 @@ void WebSockHttpFlexServer::Start() {
   logger_->Log(LogLevel::INFO, "Starting Boost.Beast web-socket server");
 
   // start listening for connections
-  connListener->run();
+  for(auto& listener : connListeners) {
+    listener->run();
+  }
+  if (localListener) {
+    localListener->run();
+  }
+  sseSweepTimer.reset(new boost::asio::steady_timer(*iocs_.front()));
+  scheduleSseSweep();
 
   // run the I/O service on the requested number of threads
-  iocRunners.reserve(NumOfThreads);
-  for(auto i = 0; i < NumOfThreads; ++i) {
+  iocRunners.reserve(ioThreads_);
+  for(unsigned i = 0; i < ioThreads_; ++i) {
+    boost::asio::io_context& ioc = *iocs_[ioContextPerThread_ ? i : 0];
     iocRunners.emplace_back(
-      [this]
+      [&ioc]
       {
         boost::system::error_code ec;
-        ioc_.run(ec);
+        ioc.run(ec);
       });
+
+    if (pinIoThreads_) {
+#ifdef __linux__
+      unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(i % cores, &cpus);
+      int err = pthread_setaffinity_np(iocRunners.back().native_handle(), sizeof(cpus), &cpus);
+      if (err != 0) {
+        logger_->Log(LogLevel::WARNING, "Can not bind I/O thread " + std::to_string(i) +
+                     " to CPU " + std::to_string(i % cores) + ": " + std::strerror(err));
+      }
+#else
+      logger_->Log(LogLevel::WARNING, "Binding I/O threads to CPU cores is not supported on this platform");
+#endif
+    }
   }
 }
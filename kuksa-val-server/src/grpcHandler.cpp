@@ -30,6 +30,16 @@
 #include "ILogger.hpp"
 #include "IVssDatabase.hpp"
 #include "SubscriptionHandler.hpp"
+#include "exception.hpp"
+
+#include <grpcpp/alarm.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 using grpc::Channel;
@@ -45,48 +55,382 @@ using kuksa::SubscribeResponse;
 
 grpcHandler handler;
 
+const static std::string ServerVersion = "1.0.0";
+
 // Helper functions
-void grpcHandler::grpc_send_object_to_stream(
-    std::shared_ptr<ILogger> logger, const std::string& vssdatatype,
-    const jsoncons::json& data,
-    grpc::ServerReaderWriter<kuksa::SubscribeResponse, kuksa::SubscribeRequest>*
-        stream) {
-  SubscribeResponse resp;
-  resp.mutable_status()->set_statuscode(200);
-  grpcHandler::grpc_fill_value(logger, vssdatatype, data,
-                               resp.mutable_values());
-  try {
-    stream->Write(resp);
-  } catch (std::exception& e) {
-    logger->Log(LogLevel::WARNING,
-                "Error pushing data to GRPC subscriber: " + string(e.what()));
+
+// Value of a numeric (or boolean) signal as T, whatever type it has been
+// stored with. Default values may still be untyped
+template <typename T>
+static T numericValue(const VssValue& value) {
+  if (value.isUnsigned()) {
+    return static_cast<T>(value.asUInt64());
+  }
+  if (value.isSigned()) {
+    return static_cast<T>(value.asInt64());
+  }
+  switch (value.type()) {
+    case VssValue::Type::FLOAT:
+      return static_cast<T>(value.asFloat());
+    case VssValue::Type::DOUBLE:
+      return static_cast<T>(value.asDouble());
+    case VssValue::Type::BOOLEAN:
+      return static_cast<T>(value.asBool());
+    case VssValue::Type::STRING:
+      try {
+        return static_cast<T>(std::stod(value.asString()));
+      } catch (std::exception&) {
+        return T();
+      }
+    default:
+      return T();
+  }
+}
+
+static std::string stringValue(const VssValue& value) {
+  return value.type() == VssValue::Type::STRING ? value.asString()
+                                                : value.toString();
+}
+
+// Value and timestamp of attr in data as published by the database
+static VssValueSlot publishedSlot(const std::string& attr,
+                                  const jsoncons::json& data) {
+  const jsoncons::json& dp = data["dp"];
+  VssValueSlot slot;
+  slot.value = VssValue::fromJson(dp[attr]);
+  if (dp.contains("ts_s") && dp.contains("ts_ns")) {
+    slot.ts_s = dp["ts_s"].as<uint64_t>();
+    slot.ts_ns = dp["ts_ns"].as<uint32_t>();
+  }
+  return slot;
+}
+
+void grpcHandler::grpc_fill_subscribe_response(
+    const std::string& path, const std::string& vssdatatype,
+    const std::string& attr, const jsoncons::json& data,
+    kuksa::SubscribeResponse* resp) {
+  resp->mutable_status()->set_statuscode(200);
+  VssValueSlot slot = publishedSlot(attr, data);
+  kuksa::Value* grpcvalue = resp->mutable_values();
+  grpc_fill_value(slot.value, VssValue::typeFromDatatype(vssdatatype),
+                  grpcvalue);
+  grpcvalue->set_path(path);
+  grpcvalue->mutable_timestamp()->set_seconds(slot.ts_s);
+  grpcvalue->mutable_timestamp()->set_nanos(slot.ts_ns);
+}
+
+void grpcHandler::grpc_fill_value(const VssValue& value, VssValue::Type type,
+                                  kuksa::Value* grpcvalue) {
+  switch (type) {
+    case VssValue::Type::UINT8:
+    case VssValue::Type::UINT16:
+    case VssValue::Type::UINT32:
+      grpcvalue->set_valueuint32(numericValue<uint32_t>(value));
+      break;
+    case VssValue::Type::INT8:
+    case VssValue::Type::INT16:
+    case VssValue::Type::INT32:
+      grpcvalue->set_valueint32(numericValue<int32_t>(value));
+      break;
+    case VssValue::Type::UINT64:
+      grpcvalue->set_valueuint64(numericValue<uint64_t>(value));
+      break;
+    case VssValue::Type::INT64:
+      grpcvalue->set_valueint64(numericValue<int64_t>(value));
+      break;
+    case VssValue::Type::FLOAT:
+      grpcvalue->set_valuefloat(numericValue<float>(value));
+      break;
+    case VssValue::Type::DOUBLE:
+      grpcvalue->set_valuedouble(numericValue<double>(value));
+      break;
+    case VssValue::Type::BOOLEAN:
+      grpcvalue->set_valuebool(numericValue<bool>(value));
+      break;
+    default:  // Treat as a string
+      grpcvalue->set_valuestring(stringValue(value));
+  }
+}
+
+template <typename Array, typename T>
+static void fillArray(const VssValue& value, Array* array) {
+  for (const auto& element : value.asArray()) {
+    array->add_values(numericValue<T>(element));
   }
 }
 
-void grpcHandler::grpc_fill_value(
-    [[maybe_unused]] std::shared_ptr<ILogger> logger,
-    const std::string& vssdatatype, const jsoncons::json& data,
-    kuksa::Value* grpcvalue, const std::string& attr) {
-  if ((vssdatatype == "uint8") || (vssdatatype == "uint16") ||
-      (vssdatatype == "uint32")) {
-    grpcvalue->set_valueuint32(data["data"]["dp"][attr].as<uint32_t>());
-  } else if ((vssdatatype == "int8") || (vssdatatype == "int16") ||
-             (vssdatatype == "int32")) {
-    grpcvalue->set_valueint32(data["data"]["dp"][attr].as<int32_t>());
-  } else if (vssdatatype == "uint64") {
-    grpcvalue->set_valueuint64(data["data"]["dp"][attr].as<uint64_t>());
-  } else if (vssdatatype == "int64") {
-    grpcvalue->set_valueint64(data["data"]["dp"][attr].as<int64_t>());
-  } else if (vssdatatype == "float") {
-    grpcvalue->set_valuefloat(data["data"]["dp"][attr].as<float>());
-  } else if (vssdatatype == "double") {
-    grpcvalue->set_valuedouble(data["data"]["dp"][attr].as<double>());
-  } else if (vssdatatype == "boolean") {
-    grpcvalue->set_valuebool(data["data"]["dp"][attr].as<bool>());
-  } else {  // Treat as a string
-    grpcvalue->set_valuestring(data["data"]["dp"][attr].as<string>());
-  }
-  grpcvalue->set_path(data["data"]["path"].as<std::string>());
+static void fillArray(const VssValue& value, kuksa::val::v1::StringArray* array) {
+  for (const auto& element : value.asArray()) {
+    array->add_values(stringValue(element));
+  }
+}
+
+void grpcHandler::grpc_fill_datapoint(const VssValueSlot& slot,
+                                      const std::string& vssdatatype,
+                                      kuksa::val::v1::Datapoint* datapoint) {
+  datapoint->mutable_timestamp()->set_seconds(slot.ts_s);
+  datapoint->mutable_timestamp()->set_nanos(slot.ts_ns);
+  const VssValue& value = slot.value;
+  VssValue::Type type = VssValue::typeFromDatatype(vssdatatype);
+  if (type == VssValue::Type::ARRAY) {
+    type = VssValue::typeFromDatatype(
+        vssdatatype.substr(0, vssdatatype.size() - 2));
+    switch (type) {
+      case VssValue::Type::UINT8:
+      case VssValue::Type::UINT16:
+      case VssValue::Type::UINT32:
+        fillArray<kuksa::val::v1::Uint32Array, uint32_t>(
+            value, datapoint->mutable_uint32_array());
+        break;
+      case VssValue::Type::INT8:
+      case VssValue::Type::INT16:
+      case VssValue::Type::INT32:
+        fillArray<kuksa::val::v1::Int32Array, int32_t>(
+            value, datapoint->mutable_int32_array());
+        break;
+      case VssValue::Type::UINT64:
+        fillArray<kuksa::val::v1::Uint64Array, uint64_t>(
+            value, datapoint->mutable_uint64_array());
+        break;
+      case VssValue::Type::INT64:
+        fillArray<kuksa::val::v1::Int64Array, int64_t>(
+            value, datapoint->mutable_int64_array());
+        break;
+      case VssValue::Type::FLOAT:
+        fillArray<kuksa::val::v1::FloatArray, float>(
+            value, datapoint->mutable_float_array());
+        break;
+      case VssValue::Type::DOUBLE:
+        fillArray<kuksa::val::v1::DoubleArray, double>(
+            value, datapoint->mutable_double_array());
+        break;
+      case VssValue::Type::BOOLEAN:
+        fillArray<kuksa::val::v1::BoolArray, bool>(
+            value, datapoint->mutable_bool_array());
+        break;
+      default:  // Treat as strings
+        fillArray(value, datapoint->mutable_string_array());
+    }
+    return;
+  }
+  switch (type) {
+    case VssValue::Type::UINT8:
+    case VssValue::Type::UINT16:
+    case VssValue::Type::UINT32:
+      datapoint->set_uint32(numericValue<uint32_t>(value));
+      break;
+    case VssValue::Type::INT8:
+    case VssValue::Type::INT16:
+    case VssValue::Type::INT32:
+      datapoint->set_int32(numericValue<int32_t>(value));
+      break;
+    case VssValue::Type::UINT64:
+      datapoint->set_uint64(numericValue<uint64_t>(value));
+      break;
+    case VssValue::Type::INT64:
+      datapoint->set_int64(numericValue<int64_t>(value));
+      break;
+    case VssValue::Type::FLOAT:
+      datapoint->set_float_(numericValue<float>(value));
+      break;
+    case VssValue::Type::DOUBLE:
+      datapoint->set_double_(numericValue<double>(value));
+      break;
+    case VssValue::Type::BOOLEAN:
+      datapoint->set_bool_(numericValue<bool>(value));
+      break;
+    default:  // Treat as a string
+      datapoint->set_string(stringValue(value));
+  }
+}
+
+template <typename Array, typename Element>
+static VssValue arrayValue(const Array& array, Element element) {
+  std::vector<VssValue> values;
+  values.reserve(array.size());
+  for (const auto& value : array) {
+    values.push_back(element(value));
+  }
+  return VssValue::fromArray(std::move(values));
+}
+
+VssValue grpcHandler::grpc_datapoint_value(
+    const kuksa::val::v1::Datapoint& datapoint) {
+  using kuksa::val::v1::Datapoint;
+  switch (datapoint.value_case()) {
+    case Datapoint::kString:
+      return VssValue::fromString(datapoint.string());
+    case Datapoint::kBool:
+      return VssValue::fromBool(datapoint.bool_());
+    case Datapoint::kInt32:
+      return VssValue::fromInt64(datapoint.int32(), VssValue::Type::INT32);
+    case Datapoint::kInt64:
+      return VssValue::fromInt64(datapoint.int64());
+    case Datapoint::kUint32:
+      return VssValue::fromUInt64(datapoint.uint32(), VssValue::Type::UINT32);
+    case Datapoint::kUint64:
+      return VssValue::fromUInt64(datapoint.uint64());
+    case Datapoint::kFloat:
+      return VssValue::fromFloat(datapoint.float_());
+    case Datapoint::kDouble:
+      return VssValue::fromDouble(datapoint.double_());
+    case Datapoint::kStringArray:
+      return arrayValue(datapoint.string_array().values(),
+                        [](const std::string& v) { return VssValue::fromString(v); });
+    case Datapoint::kBoolArray:
+      return arrayValue(datapoint.bool_array().values(),
+                        [](bool v) { return VssValue::fromBool(v); });
+    case Datapoint::kInt32Array:
+      return arrayValue(datapoint.int32_array().values(), [](int32_t v) {
+        return VssValue::fromInt64(v, VssValue::Type::INT32);
+      });
+    case Datapoint::kInt64Array:
+      return arrayValue(datapoint.int64_array().values(),
+                        [](int64_t v) { return VssValue::fromInt64(v); });
+    case Datapoint::kUint32Array:
+      return arrayValue(datapoint.uint32_array().values(), [](uint32_t v) {
+        return VssValue::fromUInt64(v, VssValue::Type::UINT32);
+      });
+    case Datapoint::kUint64Array:
+      return arrayValue(datapoint.uint64_array().values(),
+                        [](uint64_t v) { return VssValue::fromUInt64(v); });
+    case Datapoint::kFloatArray:
+      return arrayValue(datapoint.float_array().values(),
+                        [](float v) { return VssValue::fromFloat(v); });
+    case Datapoint::kDoubleArray:
+      return arrayValue(datapoint.double_array().values(),
+                        [](double v) { return VssValue::fromDouble(v); });
+    default:
+      return VssValue();
+  }
+}
+
+void grpcHandler::grpc_fill_entry_update(const std::string& path,
+                                         const std::string& vssdatatype,
+                                         const std::string& attr,
+                                         const jsoncons::json& data,
+                                         kuksa::val::v1::EntryUpdate* update) {
+  VssValueSlot slot = publishedSlot(attr, data);
+  auto entry = update->mutable_entry();
+  entry->set_path(path);
+  if (attr == "targetValue") {
+    grpc_fill_datapoint(slot, vssdatatype, entry->mutable_actuator_target());
+    update->add_fields(kuksa::val::v1::FIELD_ACTUATOR_TARGET);
+  } else {
+    grpc_fill_datapoint(slot, vssdatatype, entry->mutable_value());
+    update->add_fields(kuksa::val::v1::FIELD_VALUE);
+  }
+}
+
+// Map VSS datatype -> kuksa.val.v1 data type
+const static std::unordered_map<std::string, kuksa::val::v1::DataType>
+    DataTypeMap = {
+        {"string", kuksa::val::v1::DATA_TYPE_STRING},
+        {"boolean", kuksa::val::v1::DATA_TYPE_BOOLEAN},
+        {"int8", kuksa::val::v1::DATA_TYPE_INT8},
+        {"int16", kuksa::val::v1::DATA_TYPE_INT16},
+        {"int32", kuksa::val::v1::DATA_TYPE_INT32},
+        {"int64", kuksa::val::v1::DATA_TYPE_INT64},
+        {"uint8", kuksa::val::v1::DATA_TYPE_UINT8},
+        {"uint16", kuksa::val::v1::DATA_TYPE_UINT16},
+        {"uint32", kuksa::val::v1::DATA_TYPE_UINT32},
+        {"uint64", kuksa::val::v1::DATA_TYPE_UINT64},
+        {"float", kuksa::val::v1::DATA_TYPE_FLOAT},
+        {"double", kuksa::val::v1::DATA_TYPE_DOUBLE},
+        {"string[]", kuksa::val::v1::DATA_TYPE_STRING_ARRAY},
+        {"boolean[]", kuksa::val::v1::DATA_TYPE_BOOLEAN_ARRAY},
+        {"int8[]", kuksa::val::v1::DATA_TYPE_INT8_ARRAY},
+        {"int16[]", kuksa::val::v1::DATA_TYPE_INT16_ARRAY},
+        {"int32[]", kuksa::val::v1::DATA_TYPE_INT32_ARRAY},
+        {"int64[]", kuksa::val::v1::DATA_TYPE_INT64_ARRAY},
+        {"uint8[]", kuksa::val::v1::DATA_TYPE_UINT8_ARRAY},
+        {"uint16[]", kuksa::val::v1::DATA_TYPE_UINT16_ARRAY},
+        {"uint32[]", kuksa::val::v1::DATA_TYPE_UINT32_ARRAY},
+        {"uint64[]", kuksa::val::v1::DATA_TYPE_UINT64_ARRAY},
+        {"float[]", kuksa::val::v1::DATA_TYPE_FLOAT_ARRAY},
+        {"double[]", kuksa::val::v1::DATA_TYPE_DOUBLE_ARRAY},
+};
+
+template <typename Restriction, typename T>
+static void fillRestriction(const jsoncons::json& node, Restriction* restriction) {
+  if (node.contains("min")) {
+    restriction->set_min(node["min"].as<T>());
+  }
+  if (node.contains("max")) {
+    restriction->set_max(node["max"].as<T>());
+  }
+  if (node.contains("allowed")) {
+    for (const auto& allowed : node["allowed"].array_range()) {
+      restriction->add_allowed_values(allowed.as<T>());
+    }
+  }
+}
+
+void grpcHandler::grpc_fill_metadata(const jsoncons::json& node,
+                                     kuksa::val::v1::Metadata* metadata) {
+  std::string datatype = node.get_value_or<std::string>("datatype", "");
+  auto dataType = DataTypeMap.find(datatype);
+  if (dataType != DataTypeMap.end()) {
+    metadata->set_data_type(dataType->second);
+  }
+  std::string type = node.get_value_or<std::string>("type", "");
+  if (type == "sensor") {
+    metadata->set_entry_type(kuksa::val::v1::ENTRY_TYPE_SENSOR);
+    metadata->mutable_sensor();
+  } else if (type == "actuator") {
+    metadata->set_entry_type(kuksa::val::v1::ENTRY_TYPE_ACTUATOR);
+    metadata->mutable_actuator();
+  } else if (type == "attribute") {
+    metadata->set_entry_type(kuksa::val::v1::ENTRY_TYPE_ATTRIBUTE);
+    metadata->mutable_attribute();
+  }
+  if (node.contains("description")) {
+    metadata->set_description(node["description"].as<std::string>());
+  }
+  if (node.contains("comment")) {
+    metadata->set_comment(node["comment"].as<std::string>());
+  }
+  if (node.contains("deprecation")) {
+    metadata->set_deprecation(node["deprecation"].as<std::string>());
+  }
+  if (node.contains("unit")) {
+    metadata->set_unit(node["unit"].as<std::string>());
+  }
+
+  if (!node.contains("min") && !node.contains("max") &&
+      !node.contains("allowed")) {
+    return;
+  }
+  VssValue::Type valueType = VssValue::typeFromDatatype(datatype);
+  auto restriction = metadata->mutable_value_restriction();
+  switch (valueType) {
+    case VssValue::Type::UINT8:
+    case VssValue::Type::UINT16:
+    case VssValue::Type::UINT32:
+    case VssValue::Type::UINT64:
+      fillRestriction<kuksa::val::v1::ValueRestrictionUint, uint64_t>(
+          node, restriction->mutable_unsigned_());
+      break;
+    case VssValue::Type::INT8:
+    case VssValue::Type::INT16:
+    case VssValue::Type::INT32:
+    case VssValue::Type::INT64:
+      fillRestriction<kuksa::val::v1::ValueRestrictionInt, int64_t>(
+          node, restriction->mutable_signed_());
+      break;
+    case VssValue::Type::FLOAT:
+    case VssValue::Type::DOUBLE:
+      fillRestriction<kuksa::val::v1::ValueRestrictionFloat, double>(
+          node, restriction->mutable_floating_point());
+      break;
+    default:  // only allowed values are known for strings
+      if (node.contains("allowed")) {
+        for (const auto& allowed : node["allowed"].array_range()) {
+          restriction->mutable_string()->add_allowed_values(
+              allowed.as<std::string>());
+        }
+      }
+  }
 }
 
 // class for reading certificates
@@ -136,29 +480,178 @@ struct GrpcSessionHasher {
   }
 };
 
+using SubscriptionMap = GrpcSubscriptionMap;
+
+// Maps a protobuf value to the native value it carries, an empty one if none
+// is set. The database converts it to the datatype of the signal
+static VssValue toVssValue(const kuksa::Value& value) {
+  switch (value.val_case()) {
+    case kuksa::Value::kValueUint32:
+      return VssValue::fromUInt64(value.valueuint32(), VssValue::Type::UINT32);
+    case kuksa::Value::kValueInt32:
+      return VssValue::fromInt64(value.valueint32(), VssValue::Type::INT32);
+    case kuksa::Value::kValueUint64:
+      return VssValue::fromUInt64(value.valueuint64());
+    case kuksa::Value::kValueInt64:
+      return VssValue::fromInt64(value.valueint64());
+    case kuksa::Value::kValueBool:
+      return VssValue::fromBool(value.valuebool());
+    case kuksa::Value::kValueFloat:
+      return VssValue::fromFloat(value.valuefloat());
+    case kuksa::Value::kValueDouble:
+      return VssValue::fromDouble(value.valuedouble());
+    case kuksa::Value::kValueString:
+      return VssValue::fromString(value.valuestring());
+    default:
+      return VssValue();
+  }
+}
+
+/* Subscribes path, or unsubscribes it if start is false. status receives
+ * the outcome.
+ */
+static void subscribePath(VssCommandProcessor& processor, ILogger& logger,
+                          KuksaChannel& kc, const std::string& path,
+                          const std::string& attr, bool start,
+                          SubscriptionMap& currentSubs, kuksa::Status& status) {
+  jsoncons::json req_json, resp_json;
+  // Create appropriate subscribe request
+  auto uuid = boost::uuids::random_generator()();
+  req_json["requestId"] = boost::uuids::to_string(uuid);
+
+  if (start) {  // Send a subscribe request
+    req_json["action"] = "subscribe";
+    req_json["path"] = path;
+    req_json["attribute"] = attr;
+
+    try {
+      resp_json = processor.processSubscribe(kc, req_json);
+      if (resp_json.contains("error")) {  // Failure Case
+        uint32_t code = resp_json["error"]["number"].as<unsigned int>();
+        std::string reason = resp_json["error"]["reason"].as_string() + " " +
+                             resp_json["error"]["message"].as_string();
+        status.set_statuscode(code);
+        status.set_statusdescription(reason);
+      } else {  // Success Case
+        status.set_statuscode(200);
+        status.set_statusdescription(
+            "Subscribe request successfully processed");
+
+        subscription_keys_t key = subscription_keys_t(path, attr);
+        currentSubs[key] = resp_json["subscriptionId"].as_string();
+      }
+    } catch (std::exception& e) {
+      logger.Log(LogLevel::ERROR, e.what());
+      status.set_statuscode(500);
+      status.set_statusdescription(e.what());
+    }
+  } else {  // Send a unsubscribe request
+    req_json["action"] = "unsubscribe";
+
+    // Check if the path to unsubscribe exists
+    subscription_keys_t key = subscription_keys_t(path, attr);
+    if (currentSubs.find(key) !=
+        currentSubs.end()) {  // Path is currently subscribed
+      req_json["subscriptionId"] = currentSubs[key];
+      resp_json = processor.processUnsubscribe(kc, req_json);
+      if (resp_json.contains("error")) {  // Failure Case
+        uint32_t code = resp_json["error"]["number"].as<unsigned int>();
+        std::string reason = resp_json["error"]["reason"].as_string() + " " +
+                             resp_json["error"]["message"].as_string();
+        status.set_statuscode(code);
+        status.set_statusdescription(reason);
+      } else {  // Success Case
+        currentSubs.erase(key);
+
+        status.set_statuscode(200);
+        status.set_statusdescription(
+            "Unsubscribe request successfully processed");
+      }
+    } else {  // Path is not subscribed. So unsubscribe wont work.
+      status.set_statuscode(400);
+      status.set_statusdescription(
+          "Subscribe request error. No valid subscription existed");
+    }
+  }
+}
+
+void grpcHandler::grpc_subscribe(VssCommandProcessor& processor,
+                                 ILogger& logger, KuksaChannel& kc,
+                                 const kuksa::SubscribeRequest& request,
+                                 GrpcSubscriptionMap& currentSubs,
+                                 kuksa::SubscribeResponse* response) {
+  auto iter = AttributeStringMap.find(request.type());
+  std::string attr;
+  if (iter != AttributeStringMap.end()) {
+    attr = iter->second;
+  } else {
+    attr = "value";  // By default attribute is value
+  }
+
+  std::vector<std::string> paths;
+  if (!request.path().empty() || request.paths().empty()) {
+    paths.push_back(request.path());
+  }
+  paths.insert(paths.end(), request.paths().begin(), request.paths().end());
+
+  bool singleFailure = false;
+  for (const auto& path : paths) {
+    kuksa::Status status;
+    subscribePath(processor, logger, kc, path, attr, request.start(),
+                  currentSubs, status);
+    if (status.statuscode() != 200) {
+      *response->mutable_status() = status;
+      singleFailure = true;
+    } else if (!singleFailure) {
+      *response->mutable_status() = status;
+    }
+  }
+  if (singleFailure && paths.size() > 1) {
+    response->mutable_status()->set_statuscode(400);
+    response->mutable_status()->set_statusdescription(
+        "One or more paths could not be processed. Try individual "
+        "requests.");
+  }
+}
+
+void GrpcUpdateBatch::add(const kuksa::Value& value) {
+  auto known = index_.find(value.path());
+  if (known != index_.end()) {
+    // only the latest value of a signal is of interest
+    updates_[known->second] = value;
+    return;
+  }
+  index_.emplace(value.path(), updates_.size());
+  updates_.push_back(value);
+}
+
+void GrpcUpdateBatch::take(kuksa::SubscribeResponse* resp) {
+  auto updates = resp->mutable_updates();
+  updates->Reserve(updates->size() + static_cast<int>(updates_.size()));
+  for (auto& value : updates_) {
+    updates->Add()->Swap(&value);
+  }
+  updates_.clear();
+  index_.clear();
+}
+
 // Logic and data behind the servers behaviour
-// implementation of the rpc interfaces server side
-class RequestServiceImpl final : public kuksa_grpc_if::Service {
+// implementation of the rpc interfaces server side, the calls are driven by
+// the asynchronous call objects below
+class RequestServiceImpl final {
  private:
   std::shared_ptr<ILogger> logger;
   std::shared_ptr<IVssDatabase> database;
   std::shared_ptr<ISubscriptionHandler> subhandler;
 
-  // We need to maps to store session information (KUKSA Channels).
-  //  The generic one grpcSessionMap identifes the remote peer and can be
-  // used for simple RPCs
+  // grpcSessionMap stores session information (KUKSA Channels). It
+  // identifes the remote peer and is used for simple RPCs. Every
+  // bidirectional subscribe call gets a KuksaChannel of its own, see
+  // subscriptionChannel()
   std::unordered_map<grpcSession_t, KuksaChannel, GrpcSessionHasher>
       grpcSessionMap;
-  // when going into bidirectional streaming mode, as done bei subscription,
-  // every call to that RPC gets a different GRPC context. Upon end of that
-  // context any subscriptions from this context (tracked in KuksaChannel) need
-  // to be cleared, but NOT subscriptions from other context, therefore we
-  // need a KuksaChannel for each subscription context
-  std::unordered_map<uint64_t, std::shared_ptr<KuksaChannel>>
-      grpcSubscribeSessionMap;
 
   mutable std::mutex grpcSessionMapAccess;
-  mutable std::mutex grpcSubscribeSessionMapAccess;
 
   /* Internal helper function to authorize the session
    *  Will create and assign a KuksaChannel object to the session.
@@ -175,11 +668,9 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     req_json["token"] = token;
 
     auto newChannel = std::make_shared<KuksaChannel>();
-    auto grpcSubs = std::make_shared<gRPCSubscriptionMap_t>();
 
     newChannel->setConnID(
         0);  // Connection ID is used only for websocket connections.
-    newChannel->grpcSubsMap = grpcSubs;
     newChannel->setType(KuksaChannel::Type::GRPC);
 
     auto Processor = handler.getGrpcProcessor();
@@ -194,6 +685,57 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     return resJson;
   }
 
+  /* Sets a failure status of a get or set, the last failure of a request
+   * is reported to the client
+   */
+  void failed(kuksa::Status* status, uint32_t code,
+              const std::string& description) {
+    logger->Log(LogLevel::WARNING, description);
+    status->set_statuscode(code);
+    status->set_statusdescription(description);
+  }
+
+  Status getMetaData(const kuksa::GetRequest* request,
+                     kuksa::GetResponse* reply) {
+    jsoncons::json req_json;
+    req_json["action"] = "getMetaData";
+    req_json["requestId"] =
+        boost::uuids::to_string(boost::uuids::random_generator()());
+    bool singleFailure = false;
+
+    for (const auto& pathString : request->path()) {
+      req_json["path"] = pathString;
+      try {
+        auto resJson = handler.getGrpcProcessor()->processGetMetaData(req_json);
+        if (resJson.contains("error")) {  // Failure Case
+          uint32_t code = resJson["error"]["number"].as<unsigned int>();
+          std::string reason = resJson["error"]["reason"].as_string() + " " +
+                               resJson["error"]["message"].as_string();
+          reply->mutable_status()->set_statuscode(code);
+          reply->mutable_status()->set_statusdescription(reason);
+          singleFailure = true;
+        } else {  // Success Case
+          auto val = reply->add_values();
+          val->set_valuestring(resJson["metadata"].as_string());
+        }
+      } catch (std::exception& e) {
+        singleFailure = true;
+        logger->Log(LogLevel::ERROR, e.what());
+      }
+    }
+
+    if (singleFailure && request->path().size() > 1) {
+      reply->mutable_status()->set_statuscode(400);
+      reply->mutable_status()->set_statusdescription(
+          "One or more paths could not be resolved. Try individual requests.");
+    } else if (!singleFailure) {
+      reply->mutable_status()->set_statuscode(200);
+      reply->mutable_status()->set_statusdescription(
+          "Get request successfully processed");
+    }
+    return Status::OK;
+  }
+
   /* Internal helper function to retrieve KuksaChannel object to the session.
    * Needs the UUID assigned to the session in the context metadata.
    */
@@ -220,34 +762,6 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     return kc;
   }
 
-  KuksaChannel* getKuksaChannelForSubscriptionContext(ServerContext* context) {
-    KuksaChannel* kc = NULL;
-    uint64_t key = (uint64_t)context;
-    std::unique_lock<std::mutex> lock(grpcSubscribeSessionMapAccess);
-    // check in our map
-    std::unordered_map<uint64_t, std::shared_ptr<KuksaChannel>>::const_iterator
-        got = grpcSubscribeSessionMap.find(key);
-
-    if (got != grpcSubscribeSessionMap.end()) {  // found
-      return got->second.get();
-    }
-
-    // need to create from base
-    kc = authChecker(context);
-    if (kc == NULL) {  // never authorized
-      return kc;
-    }
-
-    // create new subscribe session Channel
-    std::shared_ptr<KuksaChannel> newChannel = std::make_shared<KuksaChannel>();
-    (*newChannel) = *kc;
-    newChannel->setConnID(key);
-    newChannel->grpcSubsMap = std::make_shared<gRPCSubscriptionMap_t>();
-    grpcSubscribeSessionMap[key] = newChannel;
-
-    return newChannel.get();
-  }
-
  public:
   RequestServiceImpl(std::shared_ptr<ILogger> _logger,
                      std::shared_ptr<IVssDatabase> _database,
@@ -257,9 +771,27 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     subhandler = _subhandler;
   }
 
+  /* Creates the KuksaChannel of a subscribe call from the one the session
+   * has been authorized with. Upon end of the call any subscriptions made
+   * on it need to be cleared, but NOT subscriptions of other calls, therefore
+   * every call needs a KuksaChannel with a connection id of its own.
+   * Returns nullptr if the session has never been authorized.
+   */
+  std::shared_ptr<KuksaChannel> subscriptionChannel(
+      ServerContext* context, uint64_t connId,
+      std::weak_ptr<IGrpcSubscriptionSink> sink) {
+    KuksaChannel* kc = authChecker(context);
+    if (kc == NULL) {  // never authorized
+      return nullptr;
+    }
+    auto newChannel = std::make_shared<KuksaChannel>(*kc);
+    newChannel->setConnID(connId);
+    newChannel->grpcSink = sink;
+    return newChannel;
+  }
+
   Status get(ServerContext* context, const kuksa::GetRequest* request,
-             kuksa::GetResponse* reply) override {
-    jsoncons::json req_json;
+             kuksa::GetResponse* reply) {
     stringstream msg;
     msg << "gRPC get invoked with type "
         << kuksa::RequestType_Name(request->type()) << " by "
@@ -281,71 +813,49 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
       return Status::OK;
     }
 
-    req_json["action"] = "get";
     if (request->type() == kuksa::RequestType::METADATA) {
-      req_json["action"] = "getMetaData";
+      return getMetaData(request, reply);
     }
 
     auto iter = AttributeStringMap.find(request->type());
     std::string attr;
     if (iter != AttributeStringMap.end()) {
       attr = iter->second;
-      req_json["attribute"] = attr;
     } else {
       attr = "value";
     }
 
+    // Values are read from the database directly, the JSON request
+    // processing and its validation would cost more than the read itself
+    auto accessChecker = handler.getGrpcProcessor()->getAccessChecker();
     bool singleFailure = false;
 
-    for (int i = 0; i < request->path().size(); i++) {
-      req_json["requestId"] =
-          boost::uuids::to_string(boost::uuids::random_generator()());
-      req_json["path"] = request->path()[i];
-
+    for (const auto& pathString : request->path()) {
       try {
-        auto Processor = handler.getGrpcProcessor();
-        std::string result;
-        jsoncons::json resJson;
-        if (request->type() != kuksa::RequestType::METADATA) {
-          resJson = Processor->processGet(*kc, req_json);
-        } else {
-          resJson = Processor->processGetMetaData(req_json);
-        }
-
-        if (resJson.contains("error")) {  // Failure Case
-          uint32_t code = resJson["error"]["number"].as<unsigned int>();
-          std::string reason = resJson["error"]["reason"].as_string() + " " +
-                               resJson["error"]["message"].as_string();
-          reply->mutable_status()->set_statuscode(code);
-          reply->mutable_status()->set_statusdescription(reason);
+        VSSPath path = VSSPath::fromVSS(pathString);
+        if (!accessChecker->checkReadAccess(*kc, path)) {
+          failed(reply->mutable_status(), 403,
+                     "Forbidden Insufficient read access to " + pathString);
           singleFailure = true;
-        } else {  // Success Case
-          auto val = reply->add_values();
-          if (request->type() != kuksa::RequestType::METADATA) {
-            string datatype;
-            try {
-              datatype = database->getDatatypeForPath(
-                  VSSPath::fromVSS(request->path()[i]));
-              stringstream ss;
-              ss << "Datatype for " << request->path()[i] << " is " << datatype;
-              logger->Log(LogLevel::INFO, ss.str());
-            } catch (std::exception& e) {
-              stringstream ss;
-              ss << "Error getting datatype for " << request->path()[i] << ": "
-                 << e.what();
-              logger->Log(LogLevel::WARNING, ss.str());
-            }
-
-            grpcHandler::grpc_fill_value(logger, datatype, resJson, val, attr);
-
-            val->mutable_timestamp()->set_seconds(
-                resJson["data"]["dp"]["ts_s"].as<uint64_t>());
-            val->mutable_timestamp()->set_nanos(
-                resJson["data"]["dp"]["ts_ns"].as<uint32_t>());
-          } else {
-            val->set_valuestring(resJson["metadata"].as_string());
-          }
+          continue;
         }
+        VssValueSlot slot = database->getSignalValue(path, attr);
+        auto val = reply->add_values();
+        grpcHandler::grpc_fill_value(slot.value, slot.value.type(), val);
+        val->set_path(pathString);
+        val->mutable_timestamp()->set_seconds(slot.ts_s);
+        val->mutable_timestamp()->set_nanos(slot.ts_ns);
+      } catch (noPathFoundonTree&) {
+        failed(reply->mutable_status(), 404,
+                   "Path not found I can not find " + pathString + " in my db");
+        singleFailure = true;
+      } catch (notSetException& e) {
+        failed(reply->mutable_status(), 404,
+                   std::string("unavailable_data ") + e.what());
+        singleFailure = true;
+      } catch (notValidException& e) {
+        failed(reply->mutable_status(), 400, std::string("bad_request ") + e.what());
+        singleFailure = true;
       } catch (std::exception& e) {
         singleFailure = true;
         logger->Log(LogLevel::ERROR, e.what());
@@ -365,8 +875,7 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
   }
 
   Status set(ServerContext* context, const kuksa::SetRequest* request,
-             kuksa::SetResponse* reply) override {
-    jsoncons::json req_json;
+             kuksa::SetResponse* reply) {
     stringstream msg;
     msg << "gRPC set invoked with type "
         << kuksa::RequestType_Name(request->type()) << " by "
@@ -385,7 +894,6 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
       // Do Nothing!!
       // Setting Metadata is not supported
     } else {
-      req_json["action"] = "set";
       auto iter = AttributeStringMap.find(request->type());
       std::string attr;
       if (iter != AttributeStringMap.end()) {
@@ -393,53 +901,39 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
       } else {
         attr = "value";
       }
-      req_json["attribute"] = attr;
+      auto accessChecker = handler.getGrpcProcessor()->getAccessChecker();
       bool singleFailure = false;
 
-      for (int i = 0; i < request->values().size(); i++) {
-        auto val = request->values()[i];
-        req_json["requestId"] =
-            boost::uuids::to_string(boost::uuids::random_generator()());
-        req_json["path"] = val.path();
-
+      for (const auto& val : request->values()) {
         try {
-          std::string datatype =
-              database->getDatatypeForPath(VSSPath::fromVSS(val.path()));
-
-          if ((datatype == "uint8") || (datatype == "uint16") ||
-              (datatype == "uint32")) {
-            req_json[attr] = val.valueuint32();
-          } else if ((datatype == "int8") || (datatype == "int16") ||
-                     (datatype == "int32")) {
-            req_json[attr] = val.valueint32();
-          } else if (datatype == "uint64") {
-            req_json[attr] = val.valueuint64();
-          } else if (datatype == "int64") {
-            req_json[attr] = val.valueint64();
-          } else if (datatype == "float") {
-            req_json[attr] = val.valuefloat();
-          } else if (datatype == "double") {
-            req_json[attr] = val.valuedouble();
-          } else if (datatype == "boolean") {
-            req_json[attr] = val.valuebool();
-          } else {  // Treat as a string
-            req_json[attr] = val.valuestring();
-          }
-
-          auto Processor = handler.getGrpcProcessor();
-          auto resJson = Processor->processSet(*kc, req_json);
-          if (resJson.contains("error")) {  // Failure Case
-            uint32_t code = resJson["error"]["number"].as<unsigned int>();
-            std::string reason = resJson["error"]["reason"].as_string() + " " +
-                                 resJson["error"]["message"].as_string();
-            reply->mutable_status()->set_statuscode(code);
-            reply->mutable_status()->set_statusdescription(reason);
+          VSSPath path = VSSPath::fromVSS(val.path());
+          if (!accessChecker->checkWriteAccess(*kc, path)) {
+            failed(reply->mutable_status(), 403,
+                       "Forbidden No write access to " + val.path());
             singleFailure = true;
-          } else {  // Success Case
-            reply->mutable_status()->set_statuscode(200);
-            reply->mutable_status()->set_statusdescription(
-                "Set request successfully processed");
+            continue;
           }
+          // the database converts the value to the datatype of the signal
+          database->setSignalValue(path, attr, toVssValue(val));
+          reply->mutable_status()->set_statuscode(200);
+          reply->mutable_status()->set_statusdescription(
+              "Set request successfully processed");
+        } catch (noPathFoundonTree&) {
+          failed(reply->mutable_status(), 404,
+                     "Path not found I can not find " + val.path() + " in my db");
+          singleFailure = true;
+        } catch (noPermissionException& e) {
+          failed(reply->mutable_status(), 403,
+                     std::string("Forbidden ") + e.what());
+          singleFailure = true;
+        } catch (outOfBoundException& e) {
+          failed(reply->mutable_status(), 400,
+                     std::string("Value passed is out of bounds ") + e.what());
+          singleFailure = true;
+        } catch (genException& e) {
+          failed(reply->mutable_status(), 401,
+                     std::string("Unknown error ") + e.what());
+          singleFailure = true;
         } catch (std::exception& e) {
           singleFailure = true;
           logger->Log(LogLevel::ERROR, e.what());
@@ -460,141 +954,27 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     return Status::OK;
   }
 
-  Status subscribe(ServerContext* context,
-                   ServerReaderWriter<SubscribeResponse, SubscribeRequest>*
-                       stream) override {
-    stringstream msg;
-    SubscribeRequest request;
-    SubscribeResponse response;
-
-    msg << "gRPC subscribe invoked"
-        << " by " << context->peer();
-    logger->Log(LogLevel::INFO, msg.str());
-
-    // Check if authorized and get the corresponding KuksaChannel
-    KuksaChannel* kc = getKuksaChannelForSubscriptionContext(context);
-    if (kc == NULL) {
-      response.mutable_status()->set_statuscode(404);
-      response.mutable_status()->set_statusdescription("No Authorization!.");
-      stream->Write(response);
-      return Status::OK;
-    }
-
-    jsoncons::json req_json, resp_json;
-    std::unordered_map<subscription_keys_t, std::string, SubscriptionKeyHasher>
-        currentSubs;
-
-    // Keep reading from the stream till it terminates
-    while (stream->Read(&request)) {
-      auto Processor = handler.getGrpcProcessor();
-      // Create appropriate subscribe request
-      auto uuid = boost::uuids::random_generator()();
-      req_json["requestId"] = boost::uuids::to_string(uuid);
-
-      bool subscribe = request.start();
-      if (subscribe) {  // Send a subscribe request
-        req_json["action"] = "subscribe";
-        auto path = request.path();
-        req_json["path"] = path;
-        auto iter = AttributeStringMap.find(request.type());
-        std::string attr;
-        if (iter != AttributeStringMap.end()) {
-          attr = iter->second;
-          req_json["attribute"] = attr;
-        } else {
-          attr = "value";  // By default attribute is value
-        }
-
-        try {
-          resp_json = Processor->processSubscribe(*kc, req_json);
-          if (resp_json.contains("error")) {  // Failure Case
-            uint32_t code = resp_json["error"]["number"].as<unsigned int>();
-            std::string reason = resp_json["error"]["reason"].as_string() +
-                                 " " +
-                                 resp_json["error"]["message"].as_string();
-            response.mutable_status()->set_statuscode(code);
-            response.mutable_status()->set_statusdescription(reason);
-            stream->Write(response);
-          } else {  // Success Case
-            response.mutable_status()->set_statuscode(200);
-            response.mutable_status()->set_statusdescription(
-                "Subscribe request successfully processed");
-            stream->Write(response);
-
-            subscription_keys_t key = subscription_keys_t(path, attr);
-            currentSubs[key] = resp_json["subscriptionId"].as_string();
-            auto subsMap = (kc->grpcSubsMap).get();
-            auto id = boost::uuids::string_generator()(
-                resp_json["subscriptionId"].as_string());
-            (*subsMap)[id] = stream;
-          }
-        } catch (std::exception& e) {
-          logger->Log(LogLevel::ERROR, e.what());
-        }
-      } else {  // Send a unsubscribe request∏
-        req_json["action"] = "unsubscribe";
-
-        std::string path = request.path();
-        auto iter = AttributeStringMap.find(request.type());
-        std::string attr;
-        if (iter != AttributeStringMap.end()) {
-          attr = iter->second;
-        } else {
-          attr = "value";  // By default attribute is value
-        }
-
-        // Check if the path to unsubscribe exists
-        subscription_keys_t key = subscription_keys_t(request.path(), attr);
-        if (currentSubs.find(key) !=
-            currentSubs.end()) {  // Path is currently subscribed
-          req_json["subscriptionId"] = currentSubs[key];
-          resp_json = Processor->processUnsubscribe(*kc, req_json);
-          if (resp_json.contains("error")) {  // Failure Case
-            uint32_t code = resp_json["error"]["number"].as<unsigned int>();
-            std::string reason = resp_json["error"]["reason"].as_string() +
-                                 " " +
-                                 resp_json["error"]["message"].as_string();
-            response.mutable_status()->set_statuscode(code);
-            response.mutable_status()->set_statusdescription(reason);
-            stream->Write(response);
-          } else {  // Success Case
-            auto subsMap = (kc->grpcSubsMap).get();
-            subsMap->erase(boost::uuids::string_generator()(currentSubs[key]));
-            currentSubs.erase(key);
-
-            response.mutable_status()->set_statuscode(200);
-            response.mutable_status()->set_statusdescription(
-                "Unsubscribe request successfully processed");
-            stream->Write(response);
-          }
-        } else {  // Path is not subscribed. So unsubscribe wont work.
-          response.mutable_status()->set_statuscode(400);
-          response.mutable_status()->set_statusdescription(
-              "Subscribe request error. No valid subscription existed");
-          stream->Write(response);
-        }
-      }
-
-      if (kc->grpcSubsMap->size() <= 0) {
-        logger->Log(LogLevel::VERBOSE, "Last valid subscription gone");
-        break;
-      }
-    }
+  /* Processes a request read from a subscribe call. currentSubs are the
+   * subscriptions made on the call so far.
+   */
+  void subscribe(KuksaChannel& kc, const SubscribeRequest& request,
+                 SubscriptionMap& currentSubs, SubscribeResponse& response) {
+    grpcHandler::grpc_subscribe(*handler.getGrpcProcessor(), *logger, kc,
+                                request, currentSubs, &response);
+  }
 
-    // We need to clean up any remaining subscriptions (in case the channel was
-    // not closed orderly by unsubscribing the last remaingin subscription, but
-    // rather by a client error/shutdown or network disconnection)
+  /* Clears the subscriptions of a subscribe call that has ended. (in case the
+   * channel was not closed orderly by unsubscribing the last remaining
+   * subscription, but rather by a client error/shutdown or network
+   * disconnection)
+   */
+  void subscribeEnded(KuksaChannel& kc) {
     logger->Log(LogLevel::VERBOSE, "GRPC bidirectional channel closed");
-    // logger->Log(LogLevel::VERBOSE, "On close VALID Subs is:
-    // "+std::to_string(kc->grpcSubsMap->size()));
-
-    subhandler->unsubscribeAll(*kc);
-    kc->grpcSubsMap->clear();
-    return Status::OK;
+    subhandler->unsubscribeAll(kc);
   }
 
   Status authorize(ServerContext* context, const kuksa::AuthRequest* request,
-                   kuksa::AuthResponse* reply) override {
+                   kuksa::AuthResponse* reply) {
     stringstream msg;
     msg << "gRPC authorize invoked with token " << request->token();
     logger->Log(LogLevel::INFO, msg.str());
@@ -619,13 +999,956 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
   }
 };
 
+// Implementation of the kuksa.val.v1 API. Calls are not bound to a session,
+// every call carries the JWT token in its "authorization" metadata.
+class ValServiceImpl final {
+ private:
+  /// Channel a token has been validated for, until the token expires
+  struct Authorization {
+    std::shared_ptr<KuksaChannel> channel;
+    int64_t expires;
+  };
+  /// Tokens are chosen by the clients, so keep the number of validated
+  /// ones bounded
+  static constexpr size_t MaxAuthorizations = 1024;
+
+  /// What to fill in of a DataEntry
+  struct Selection {
+    bool value = false;
+    bool target = false;
+    bool metadata = false;
+  };
+
+  std::shared_ptr<ILogger> logger;
+  std::shared_ptr<IVssDatabase> database;
+  std::shared_ptr<ISubscriptionHandler> subhandler;
+
+  std::unordered_map<std::string, Authorization> authorizations;
+  std::mutex authorizationsAccess;
+
+  static Selection select(kuksa::val::v1::View view,
+                          const google::protobuf::RepeatedField<int>& fields) {
+    Selection selection;
+    if (view == kuksa::val::v1::VIEW_UNSPECIFIED && fields.empty()) {
+      view = kuksa::val::v1::VIEW_CURRENT_VALUE;
+    }
+    switch (view) {
+      case kuksa::val::v1::VIEW_CURRENT_VALUE:
+        selection.value = true;
+        break;
+      case kuksa::val::v1::VIEW_TARGET_VALUE:
+        selection.target = true;
+        break;
+      case kuksa::val::v1::VIEW_METADATA:
+        selection.metadata = true;
+        break;
+      case kuksa::val::v1::VIEW_ALL:
+        selection.value = selection.target = selection.metadata = true;
+        break;
+      default:  // VIEW_FIELDS, or fields without a view
+        for (int field : fields) {
+          if (field == kuksa::val::v1::FIELD_UNSPECIFIED) {
+            selection.value = selection.target = selection.metadata = true;
+          } else if (field == kuksa::val::v1::FIELD_VALUE) {
+            selection.value = true;
+          } else if (field == kuksa::val::v1::FIELD_ACTUATOR_TARGET) {
+            selection.target = true;
+          } else if (field >= kuksa::val::v1::FIELD_METADATA) {
+            selection.metadata = true;
+          }
+        }
+    }
+    return selection;
+  }
+
+  void entryFailed(
+      google::protobuf::RepeatedPtrField<kuksa::val::v1::DataEntryError>* errors,
+      const std::string& path, uint32_t code, const std::string& reason,
+      const std::string& message) {
+    logger->Log(LogLevel::WARNING, "gRPC kuksa.val.v1: " + reason + " " + message);
+    auto error = errors->Add();
+    error->set_path(path);
+    error->mutable_error()->set_code(code);
+    error->mutable_error()->set_reason(reason);
+    error->mutable_error()->set_message(message);
+  }
+
+  /* Fills datapoint with attr of path, leaves it empty if it has not been
+   * set yet */
+  void fillAttribute(const VSSPath& path, const std::string& attr,
+                     const std::string& datatype,
+                     kuksa::val::v1::Datapoint* datapoint) {
+    try {
+      grpcHandler::grpc_fill_datapoint(database->getSignalValue(path, attr),
+                                       datatype, datapoint);
+    } catch (notSetException&) {
+      datapoint->Clear();
+    }
+  }
+
+  void setAttribute(const VSSPath& path, const std::string& attr,
+                    const kuksa::val::v1::Datapoint& datapoint) {
+    VssValue value = grpcHandler::grpc_datapoint_value(datapoint);
+    if (!value.isSet()) {
+      throw genException("No " + attr + " given for " + path.getVSSPath());
+    }
+    uint64_t timestampNs = 0;
+    if (datapoint.has_timestamp() && datapoint.timestamp().seconds() > 0) {
+      timestampNs = uint64_t(datapoint.timestamp().seconds()) * 1000000000 +
+                    datapoint.timestamp().nanos();
+    }
+    database->setSignalValue(path, attr, value, timestampNs);
+  }
+
+ public:
+  ValServiceImpl(std::shared_ptr<ILogger> _logger,
+                 std::shared_ptr<IVssDatabase> _database,
+                 std::shared_ptr<ISubscriptionHandler> _subhandler)
+      : logger(_logger), database(_database), subhandler(_subhandler) {}
+
+  /* Returns the channel for the token passed as "authorization: Bearer
+   * <token>" metadata, or nullptr if there is none or it is not valid.
+   * Tokens are validated once and then looked up until they expire, the
+   * channel must not be modified by callers.
+   */
+  std::shared_ptr<KuksaChannel> authorize(ServerContext* context) {
+    const auto& metadata = context->client_metadata();
+    auto header = metadata.find("authorization");
+    if (header == metadata.end()) {
+      return nullptr;
+    }
+    std::string token(header->second.begin(), header->second.end());
+    const std::string bearer = "Bearer ";
+    if (token.compare(0, bearer.size(), bearer) == 0) {
+      token.erase(0, bearer.size());
+    }
+
+    int64_t now = std::time(nullptr);
+    {
+      std::lock_guard<std::mutex> lock(authorizationsAccess);
+      auto authorization = authorizations.find(token);
+      if (authorization != authorizations.end() &&
+          authorization->second.expires > now) {
+        return authorization->second.channel;
+      }
+    }
+
+    auto channel = std::make_shared<KuksaChannel>();
+    channel->setConnID(0);
+    channel->setType(KuksaChannel::Type::GRPC_VAL_V1);
+    auto resJson = handler.getGrpcProcessor()->processAuthorize(
+        *channel, boost::uuids::to_string(boost::uuids::random_generator()()),
+        token);
+    if (resJson.contains("error")) {
+      logger->Log(LogLevel::WARNING, "gRPC kuksa.val.v1: invalid token from " +
+                                         context->peer());
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(authorizationsAccess);
+    if (authorizations.size() >= MaxAuthorizations) {
+      for (auto it = authorizations.begin(); it != authorizations.end();) {
+        it = it->second.expires <= now ? authorizations.erase(it) : std::next(it);
+      }
+      if (authorizations.size() >= MaxAuthorizations) {
+        authorizations.clear();
+      }
+    }
+    authorizations[token] =
+        Authorization{channel, resJson["TTL"].as<int64_t>()};
+    return channel;
+  }
+
+  Status get(ServerContext* context, const kuksa::val::v1::GetRequest* request,
+             kuksa::val::v1::GetResponse* reply) {
+    logger->Log(LogLevel::INFO,
+                "gRPC kuksa.val.v1 Get invoked by " + context->peer());
+    auto channel = authorize(context);
+    if (!channel) {
+      return Status(grpc::StatusCode::UNAUTHENTICATED,
+                    "Missing or invalid authorization token");
+    }
+    auto accessChecker = handler.getGrpcProcessor()->getAccessChecker();
+
+    for (const auto& entryRequest : request->entries()) {
+      Selection selection = select(entryRequest.view(), entryRequest.fields());
+      std::list<VSSPath> leaves;
+      try {
+        leaves = database->getLeafPaths(VSSPath::fromVSS(entryRequest.path()));
+      } catch (std::exception& e) {
+        logger->Log(LogLevel::VERBOSE, e.what());
+      }
+      if (leaves.empty()) {
+        entryFailed(reply->mutable_errors(), entryRequest.path(), 404,
+                    "not_found", "I can not find " + entryRequest.path() + " in my db");
+        continue;
+      }
+
+      for (const auto& leaf : leaves) {
+        const std::string& path = leaf.getVSSPath();
+        if (!accessChecker->checkReadAccess(*channel, leaf)) {
+          entryFailed(reply->mutable_errors(), path, 403, "forbidden",
+                      "Insufficient read access to " + path);
+          continue;
+        }
+        auto entry = reply->add_entries();
+        try {
+          jsoncons::json meta = database->getNodeMetaData(leaf);
+          std::string datatype = meta.get_value_or<std::string>("datatype", "");
+          entry->set_path(path);
+          if (selection.value) {
+            fillAttribute(leaf, "value", datatype, entry->mutable_value());
+          }
+          if (selection.target && meta.get_value_or<std::string>("type", "") == "actuator") {
+            fillAttribute(leaf, "targetValue", datatype,
+                          entry->mutable_actuator_target());
+          }
+          if (selection.metadata) {
+            grpcHandler::grpc_fill_metadata(meta, entry->mutable_metadata());
+          }
+        } catch (noPathFoundonTree&) {  // the tree has been updated meanwhile
+          reply->mutable_entries()->RemoveLast();
+          entryFailed(reply->mutable_errors(), path, 404, "not_found",
+                      "I can not find " + path + " in my db");
+        }
+      }
+    }
+    return Status::OK;
+  }
+
+  Status set(ServerContext* context, const kuksa::val::v1::SetRequest* request,
+             kuksa::val::v1::SetResponse* reply) {
+    logger->Log(LogLevel::INFO,
+                "gRPC kuksa.val.v1 Set invoked by " + context->peer());
+    auto channel = authorize(context);
+    if (!channel) {
+      return Status(grpc::StatusCode::UNAUTHENTICATED,
+                    "Missing or invalid authorization token");
+    }
+    auto accessChecker = handler.getGrpcProcessor()->getAccessChecker();
+
+    for (const auto& update : request->updates()) {
+      const auto& entry = update.entry();
+      bool setValue = update.fields().empty() && entry.has_value();
+      bool setTarget = update.fields().empty() && entry.has_actuator_target();
+      for (int field : update.fields()) {
+        setValue |= field == kuksa::val::v1::FIELD_VALUE;
+        setTarget |= field == kuksa::val::v1::FIELD_ACTUATOR_TARGET;
+      }
+      try {
+        VSSPath path = VSSPath::fromVSS(entry.path());
+        if (!accessChecker->checkWriteAccess(*channel, path)) {
+          entryFailed(reply->mutable_errors(), entry.path(), 403, "forbidden",
+                      "No write access to " + entry.path());
+          continue;
+        }
+        // the database converts the values to the datatype of the signal
+        if (setValue) {
+          setAttribute(path, "value", entry.value());
+        }
+        if (setTarget) {
+          setAttribute(path, "targetValue", entry.actuator_target());
+        }
+      } catch (noPathFoundonTree&) {
+        entryFailed(reply->mutable_errors(), entry.path(), 404, "not_found",
+                    "I can not find " + entry.path() + " in my db");
+      } catch (noPermissionException& e) {
+        entryFailed(reply->mutable_errors(), entry.path(), 403, "forbidden",
+                    e.what());
+      } catch (outOfBoundException& e) {
+        entryFailed(reply->mutable_errors(), entry.path(), 400,
+                    "out_of_bounds", e.what());
+      } catch (std::exception& e) {
+        entryFailed(reply->mutable_errors(), entry.path(), 400,
+                    "bad_request", e.what());
+      }
+    }
+    return Status::OK;
+  }
+
+  /* Subscribes channel to the entries of request. If one of them can not
+   * be subscribed to, the subscriptions made so far are removed again and
+   * the error is returned. current receives the values of the subscribed
+   * signals that have been set already.
+   */
+  Status subscribe(KuksaChannel& channel,
+                   const kuksa::val::v1::SubscribeRequest& request,
+                   kuksa::val::v1::SubscribeResponse& current) {
+    if (request.entries().empty()) {
+      return Status(grpc::StatusCode::INVALID_ARGUMENT,
+                    "No entries to subscribe to");
+    }
+    auto accessChecker = handler.getGrpcProcessor()->getAccessChecker();
+
+    for (const auto& entry : request.entries()) {
+      std::vector<std::string> attrs;
+      for (int field : entry.fields()) {
+        if (field == kuksa::val::v1::FIELD_VALUE) {
+          attrs.push_back("value");
+        } else if (field == kuksa::val::v1::FIELD_ACTUATOR_TARGET) {
+          attrs.push_back("targetValue");
+        }
+      }
+      if (attrs.empty()) {
+        attrs.push_back("value");
+      }
+
+      std::list<VSSPath> leaves;
+      for (const auto& attr : attrs) {
+        try {
+          subhandler->subscribe(channel, database, entry.path(), attr);
+          if (leaves.empty()) {
+            leaves = database->getLeafPaths(VSSPath::fromVSS(entry.path()));
+          }
+        } catch (noPathFoundonTree&) {
+          subscribeEnded(channel);
+          return Status(grpc::StatusCode::NOT_FOUND,
+                        "I can not find " + entry.path() + " in my db");
+        } catch (noPermissionException& e) {
+          subscribeEnded(channel);
+          return Status(grpc::StatusCode::PERMISSION_DENIED, e.what());
+        } catch (std::exception& e) {
+          subscribeEnded(channel);
+          return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        for (const auto& leaf : leaves) {
+          if (!accessChecker->checkReadAccess(channel, leaf)) {
+            continue;
+          }
+          try {
+            VssValueSlot slot = database->getSignalValue(leaf, attr);
+            std::string datatype = database->getDatatypeForPath(leaf);
+            auto update = current.add_updates();
+            update->mutable_entry()->set_path(leaf.getVSSPath());
+            if (attr == "targetValue") {
+              grpcHandler::grpc_fill_datapoint(
+                  slot, datatype, update->mutable_entry()->mutable_actuator_target());
+              update->add_fields(kuksa::val::v1::FIELD_ACTUATOR_TARGET);
+            } else {
+              grpcHandler::grpc_fill_datapoint(
+                  slot, datatype, update->mutable_entry()->mutable_value());
+              update->add_fields(kuksa::val::v1::FIELD_VALUE);
+            }
+          } catch (std::exception&) {
+            // not set yet
+          }
+        }
+      }
+    }
+    return Status::OK;
+  }
+
+  void subscribeEnded(KuksaChannel& channel) {
+    logger->Log(LogLevel::VERBOSE, "gRPC kuksa.val.v1 subscribe call ended");
+    subhandler->unsubscribeAll(channel);
+  }
+
+  Status getServerInfo(ServerContext*,
+                       const kuksa::val::v1::GetServerInfoRequest*,
+                       kuksa::val::v1::GetServerInfoResponse* reply) {
+    reply->set_name("kuksa-val-server");
+    reply->set_version(ServerVersion);
+    return Status::OK;
+  }
+};
+
+// Asynchronous calls. Every completion queue is polled by one thread, all
+// operations of a call complete on the queue it has been accepted on. The
+// tag of an operation is a CompletionEvent, calling back the call object.
+
+class CompletionEvent {
+ public:
+  virtual ~CompletionEvent() {}
+  virtual void complete(bool ok) = 0;
+};
+
+template <typename Call>
+class CallEvent final : public CompletionEvent {
+ public:
+  CallEvent(Call* call, void (Call::*handler)(bool))
+      : call_(call), handler_(handler) {}
+  void complete(bool ok) override { (call_->*handler_)(ok); }
+
+ private:
+  Call* call_;
+  void (Call::*handler_)(bool);
+};
+
+struct AsyncServer {
+  AsyncServer(std::shared_ptr<ILogger> logger,
+              std::shared_ptr<IVssDatabase> database,
+              std::shared_ptr<ISubscriptionHandler> subhandler,
+              size_t queueDepth, std::chrono::milliseconds batchWindow)
+      : impl(logger, database, subhandler),
+        valImpl(logger, database, subhandler),
+        logger(logger),
+        queueDepth(queueDepth),
+        batchWindow(batchWindow) {}
+
+  kuksa_grpc_if::AsyncService service;
+  RequestServiceImpl impl;
+  kuksa::val::v1::VAL::AsyncService valService;
+  ValServiceImpl valImpl;
+  std::shared_ptr<ILogger> logger;
+  /// Number of responses that may be waiting to be written on a subscribe
+  /// call
+  const size_t queueDepth;
+  /// Time notifications are collected for, before they are written as one
+  /// response to a subscribe call that subscribed with paths
+  const std::chrono::milliseconds batchWindow;
+};
+
+/* A unary call, e.g. get, set or authorize. It is processed right away on
+ * the thread polling the completion queue.
+ */
+template <typename Service, typename Impl, typename Request, typename Reply>
+class UnaryCall {
+ public:
+  using Requester = void (Service::*)(
+      ServerContext*, Request*, grpc::ServerAsyncResponseWriter<Reply>*,
+      grpc::CompletionQueue*, grpc::ServerCompletionQueue*, void*);
+  using Handler = Status (Impl::*)(ServerContext*, const Request*, Reply*);
+
+  /* Waits for the next call of the method on cq */
+  static void listen(Service& service, Impl& impl,
+                     grpc::ServerCompletionQueue* cq, Requester requester,
+                     Handler handler) {
+    auto call = new UnaryCall(service, impl, cq, requester, handler);
+    (service.*requester)(&call->context_, &call->request_, &call->responder_,
+                         cq, cq, &call->requested_);
+  }
+
+ private:
+  UnaryCall(Service& service, Impl& impl, grpc::ServerCompletionQueue* cq,
+            Requester requester, Handler handler)
+      : service_(service),
+        impl_(impl),
+        cq_(cq),
+        requester_(requester),
+        handler_(handler),
+        responder_(&context_),
+        requested_(this, &UnaryCall::onRequested),
+        finished_(this, &UnaryCall::onFinished) {}
+
+  void onRequested(bool ok) {
+    if (!ok) {  // server shutting down
+      delete this;
+      return;
+    }
+    listen(service_, impl_, cq_, requester_, handler_);
+    Status status = (impl_.*handler_)(&context_, &request_, &reply_);
+    responder_.Finish(reply_, status, &finished_);
+  }
+
+  void onFinished(bool) { delete this; }
+
+  Service& service_;
+  Impl& impl_;
+  grpc::ServerCompletionQueue* cq_;
+  Requester requester_;
+  Handler handler_;
+  ServerContext context_;
+  Request request_;
+  Reply reply_;
+  grpc::ServerAsyncResponseWriter<Reply> responder_;
+  CallEvent<UnaryCall> requested_;
+  CallEvent<UnaryCall> finished_;
+};
+
+template <typename Request, typename Reply>
+using KuksaUnaryCall =
+    UnaryCall<kuksa_grpc_if::AsyncService, RequestServiceImpl, Request, Reply>;
+template <typename Request, typename Reply>
+using ValUnaryCall = UnaryCall<kuksa::val::v1::VAL::AsyncService,
+                               ValServiceImpl, Request, Reply>;
+
+/// gRPC subscribe calls get connection ids with the top bit set, which the
+/// connection registry does not hand out
+static uint64_t nextSubscribeConnectionId() {
+  static std::atomic<uint64_t> counter(0);
+  return (uint64_t(1) << 63) | ++counter;
+}
+
+/* A bidirectional subscribe call. A read is outstanding as long as the
+ * client may send requests, responses and notifications are queued and
+ * written one at a time. No thread is blocked for the call, so the number of
+ * subscribe calls is not limited by the number of threads.
+ *
+ * Once the client subscribed with SubscribeRequest.paths, notifications are
+ * collected for the batching window and written as SubscribeResponse.updates
+ * of a single response.
+ */
+class SubscribeCall final
+    : public IGrpcSubscriptionSink,
+      public std::enable_shared_from_this<SubscribeCall> {
+ public:
+  /* Waits for the next subscribe call on cq */
+  static void listen(AsyncServer& server, grpc::ServerCompletionQueue* cq) {
+    auto call = std::make_shared<SubscribeCall>(server, cq);
+    // the call owns itself until it is finished, subscriptions only refer
+    // to it weakly
+    call->self_ = call;
+    server.service.Requestsubscribe(&call->context_, &call->stream_, cq, cq,
+                                    &call->requested_);
+  }
+
+  SubscribeCall(AsyncServer& server, grpc::ServerCompletionQueue* cq)
+      : server_(server),
+        cq_(cq),
+        stream_(&context_),
+        requested_(this, &SubscribeCall::onRequested),
+        read_(this, &SubscribeCall::onRead),
+        written_(this, &SubscribeCall::onWritten),
+        batchDue_(this, &SubscribeCall::onBatchDue),
+        finished_(this, &SubscribeCall::onFinished) {}
+
+  bool send(const SubscribeResponse& resp) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_ || broken_) {
+      return false;
+    }
+    if (!batching_) {
+      queue(resp);
+      return true;
+    }
+    // conflated per signal, so the batch is bounded by the subscriptions
+    bool first = batch_.empty();
+    batch_.add(resp.values());
+    if (first && !timing_) {
+      if (server_.batchWindow.count() > 0) {
+        timing_ = true;
+        alarm_.Set(cq_, std::chrono::system_clock::now() + server_.batchWindow,
+                   &batchDue_);
+      } else {
+        due_ = true;
+      }
+    }
+    if (due_ && !writing_) {
+      writeBatch();
+    }
+    return true;
+  }
+
+ private:
+  void onRequested(bool ok) {
+    if (!ok) {  // server shutting down
+      self_.reset();
+      return;
+    }
+    listen(server_, cq_);
+
+    stringstream msg;
+    msg << "gRPC subscribe invoked"
+        << " by " << context_.peer();
+    server_.logger->Log(LogLevel::INFO, msg.str());
+
+    // Check if authorized and get the corresponding KuksaChannel
+    channel_ = server_.impl.subscriptionChannel(&context_, nextSubscribeConnectionId(),
+                                                shared_from_this());
+    if (!channel_) {
+      SubscribeResponse response;
+      response.mutable_status()->set_statuscode(404);
+      response.mutable_status()->set_statusdescription("No Authorization!.");
+      std::lock_guard<std::mutex> lock(mutex_);
+      closing_ = true;
+      finishing_ = true;
+      stream_.WriteAndFinish(response, grpc::WriteOptions(), Status::OK,
+                             &finished_);
+      return;
+    }
+    stream_.Read(&request_, &read_);
+  }
+
+  void onRead(bool ok) {
+    if (!ok) {  // client done or gone
+      close();
+      return;
+    }
+    if (!request_.paths().empty()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batching_ = true;
+    }
+    SubscribeResponse response;
+    server_.impl.subscribe(*channel_, request_, currentSubs_, response);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!broken_) {
+        queue(response);
+      }
+    }
+
+    if (currentSubs_.empty()) {
+      server_.logger->Log(LogLevel::VERBOSE, "Last valid subscription gone");
+      close();
+      return;
+    }
+    stream_.Read(&request_, &read_);
+  }
+
+  void onWritten(bool ok) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writing_ = false;
+    // if writing failed the client is gone, the outstanding read fails as
+    // well and closes the call
+    if (!ok) {
+      broken_ = true;
+      pending_.clear();
+      batch_ = GrpcUpdateBatch();
+    }
+    if (!pending_.empty()) {
+      current_ = std::move(pending_.front());
+      pending_.pop_front();
+      write();
+    } else if (due_ && !batch_.empty()) {
+      writeBatch();
+    } else {
+      finishIfIdle();
+    }
+  }
+
+  /* The batching window has passed, or the alarm has been cancelled */
+  void onBatchDue(bool) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timing_ = false;
+    due_ = true;
+    if (!writing_ && !batch_.empty() && !broken_) {
+      writeBatch();
+    } else {
+      finishIfIdle();
+    }
+  }
+
+  void onFinished(bool) { self_.reset(); }
+
+  /* No read is outstanding anymore. The call is finished once the last
+   * write completed */
+  void close() {
+    server_.impl.subscribeEnded(*channel_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    closing_ = true;
+    if (timing_) {
+      alarm_.Cancel();
+    }
+    finishIfIdle();
+  }
+
+  /// mutex_ is held
+  void queue(const SubscribeResponse& resp) {
+    if (!writing_) {
+      current_ = resp;
+      write();
+      return;
+    }
+    // the client does not read fast enough, drop the oldest response
+    if (pending_.size() >= server_.queueDepth) {
+      pending_.pop_front();
+      droppedNotification();
+    }
+    pending_.push_back(resp);
+  }
+
+  /// mutex_ is held
+  void droppedNotification() {
+    if (dropped_++ == 0) {
+      server_.logger->Log(LogLevel::WARNING,
+                          "gRPC subscriber " + context_.peer() +
+                              " does not read fast enough, dropping "
+                              "notifications");
+    }
+  }
+
+  /// mutex_ is held, writes the notifications collected so far as one
+  /// response
+  void writeBatch() {
+    due_ = false;
+    current_.Clear();
+    current_.mutable_status()->set_statuscode(200);
+    batch_.take(&current_);
+    write();
+  }
+
+  /// mutex_ is held
+  void write() {
+    writing_ = true;
+    stream_.Write(current_, &written_);
+  }
+
+  /// mutex_ is held
+  void finishIfIdle() {
+    if (closing_ && !writing_ && !timing_ && !finishing_) {
+      finishing_ = true;
+      stream_.Finish(Status::OK, &finished_);
+    }
+  }
+
+  AsyncServer& server_;
+  grpc::ServerCompletionQueue* cq_;
+  ServerContext context_;
+  grpc::ServerAsyncReaderWriter<SubscribeResponse, SubscribeRequest> stream_;
+  std::shared_ptr<SubscribeCall> self_;
+  std::shared_ptr<KuksaChannel> channel_;
+  SubscribeRequest request_;
+  SubscriptionMap currentSubs_;
+
+  /// Guards the write state, notifications are sent from the subscription
+  /// threads
+  std::mutex mutex_;
+  bool writing_ = false;
+  bool closing_ = false;
+  /// set when a write failed
+  bool broken_ = false;
+  bool finishing_ = false;
+  SubscribeResponse current_;
+  std::deque<SubscribeResponse> pending_;
+  uint64_t dropped_ = 0;
+
+  /// set once the client subscribed with paths
+  bool batching_ = false;
+  /// notifications of the current batching window
+  GrpcUpdateBatch batch_;
+  /// set while alarm_ is pending
+  bool timing_ = false;
+  /// set when the batch is to be written as soon as no write is pending
+  bool due_ = false;
+  grpc::Alarm alarm_;
+
+  CallEvent<SubscribeCall> requested_;
+  CallEvent<SubscribeCall> read_;
+  CallEvent<SubscribeCall> written_;
+  CallEvent<SubscribeCall> batchDue_;
+  CallEvent<SubscribeCall> finished_;
+};
+
+/* A kuksa.val.v1 subscribe call, streaming updates of the entries
+ * requested when the call started. Updates that arrive while a response is
+ * being written are batched into the next response. As the client sends
+ * nothing after the request, a cancelled call is noticed through
+ * AsyncNotifyWhenDone.
+ */
+class ValSubscribeCall final
+    : public IValSubscriptionSink,
+      public std::enable_shared_from_this<ValSubscribeCall> {
+ public:
+  /* Waits for the next subscribe call on cq */
+  static void listen(AsyncServer& server, grpc::ServerCompletionQueue* cq) {
+    auto call = std::make_shared<ValSubscribeCall>(server, cq);
+    call->self_ = call;
+    call->context_.AsyncNotifyWhenDone(&call->done_);
+    server.valService.RequestSubscribe(&call->context_, &call->request_,
+                                       &call->writer_, cq, cq,
+                                       &call->requested_);
+  }
+
+  ValSubscribeCall(AsyncServer& server, grpc::ServerCompletionQueue* cq)
+      : server_(server),
+        cq_(cq),
+        writer_(&context_),
+        requested_(this, &ValSubscribeCall::onRequested),
+        written_(this, &ValSubscribeCall::onWritten),
+        done_(this, &ValSubscribeCall::onDone),
+        finished_(this, &ValSubscribeCall::onFinished) {}
+
+  bool send(const kuksa::val::v1::EntryUpdate& update) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_ || broken_) {
+      return false;
+    }
+    // the client does not read fast enough, drop the oldest update
+    if (pending_.size() >= server_.queueDepth) {
+      pending_.pop_front();
+      if (dropped_++ == 0) {
+        server_.logger->Log(LogLevel::WARNING,
+                            "gRPC subscriber " + context_.peer() +
+                                " does not read fast enough, dropping "
+                                "updates");
+      }
+    }
+    pending_.push_back(update);
+    if (!writing_) {
+      writePending();
+    }
+    return true;
+  }
+
+ private:
+  void onRequested(bool ok) {
+    if (!ok) {  // server shutting down, done_ is only delivered for calls
+                // that have started
+      self_.reset();
+      return;
+    }
+    listen(server_, cq_);
+    server_.logger->Log(LogLevel::INFO, "gRPC kuksa.val.v1 Subscribe invoked by " +
+                                            context_.peer());
+
+    auto authorized = server_.valImpl.authorize(&context_);
+    if (!authorized) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closing_ = true;
+      finish(Status(grpc::StatusCode::UNAUTHENTICATED,
+                    "Missing or invalid authorization token"));
+      return;
+    }
+    // every call needs a channel of its own, so that its subscriptions can
+    // be removed when it ends
+    channel_ = std::make_shared<KuksaChannel>(*authorized);
+    channel_->setConnID(nextSubscribeConnectionId());
+    channel_->valSink = shared_from_this();
+
+    {
+      // hold back updates until the current values have been queued
+      std::lock_guard<std::mutex> lock(mutex_);
+      writing_ = true;
+    }
+    kuksa::val::v1::SubscribeResponse current;
+    Status status = server_.valImpl.subscribe(*channel_, request_, current);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    writing_ = false;
+    if (!status.ok()) {
+      closing_ = true;
+      pending_.clear();
+      finish(status);
+      return;
+    }
+    auto updates = current.mutable_updates();
+    for (int i = updates->size() - 1; i >= 0; i--) {
+      pending_.emplace_front();
+      pending_.front().Swap(updates->Mutable(i));
+    }
+    if (!pending_.empty() && !closing_) {
+      writePending();
+    }
+  }
+
+  void onWritten(bool ok) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writing_ = false;
+    if (!ok) {  // the client is gone, done_ follows
+      broken_ = true;
+      pending_.clear();
+    }
+    if (closing_) {
+      finish(Status::OK);
+    } else if (!pending_.empty()) {
+      writePending();
+    }
+  }
+
+  /* The call has been cancelled, or finished */
+  void onDone(bool) {
+    done_fired_ = true;
+    if (channel_) {
+      server_.valImpl.subscribeEnded(*channel_);
+    }
+    bool release;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closing_ = true;
+      if (!writing_) {
+        finish(Status::CANCELLED);
+      }
+      release = finished_fired_;
+    }
+    if (release) {
+      self_.reset();
+    }
+  }
+
+  void onFinished(bool) {
+    finished_fired_ = true;
+    if (done_fired_) {
+      self_.reset();
+    }
+  }
+
+  /// mutex_ is held. Writes all pending updates as one response
+  void writePending() {
+    writing_ = true;
+    response_.Clear();
+    for (auto& update : pending_) {
+      response_.add_updates()->Swap(&update);
+    }
+    pending_.clear();
+    writer_.Write(response_, &written_);
+  }
+
+  /// mutex_ is held
+  void finish(const Status& status) {
+    if (!finishing_) {
+      finishing_ = true;
+      writer_.Finish(status, &finished_);
+    }
+  }
+
+  AsyncServer& server_;
+  grpc::ServerCompletionQueue* cq_;
+  ServerContext context_;
+  kuksa::val::v1::SubscribeRequest request_;
+  grpc::ServerAsyncWriter<kuksa::val::v1::SubscribeResponse> writer_;
+  std::shared_ptr<ValSubscribeCall> self_;
+  std::shared_ptr<KuksaChannel> channel_;
+  /// the call is released once both done_ and finished_ have been
+  /// delivered. Only touched by the thread polling cq_
+  bool done_fired_ = false;
+  bool finished_fired_ = false;
+
+  /// Guards the write state, updates are sent from the subscription threads
+  std::mutex mutex_;
+  bool writing_ = false;
+  bool closing_ = false;
+  /// set when a write failed
+  bool broken_ = false;
+  bool finishing_ = false;
+  kuksa::val::v1::SubscribeResponse response_;
+  std::deque<kuksa::val::v1::EntryUpdate> pending_;
+  uint64_t dropped_ = 0;
+
+  CallEvent<ValSubscribeCall> requested_;
+  CallEvent<ValSubscribeCall> written_;
+  CallEvent<ValSubscribeCall> done_;
+  CallEvent<ValSubscribeCall> finished_;
+};
+
+void pollCompletionQueue(grpc::ServerCompletionQueue* cq) {
+  void* tag;
+  bool ok;
+  while (cq->Next(&tag, &ok)) {
+    static_cast<CompletionEvent*>(tag)->complete(ok);
+  }
+}
+
+boost::program_options::options_description& grpcHandler::getOptions() {
+  static boost::program_options::options_description grpc_desc("gRPC Options");
+  grpc_desc.add_options()(
+      "grpc.threads", boost::program_options::value<unsigned>()->default_value(0),
+      "Number of threads processing gRPC calls, each polling a completion "
+      "queue of its own. 0 uses one thread per CPU core")(
+      "grpc.queue-depth", boost::program_options::value<size_t>()->default_value(256),
+      "Number of notifications that may be pending for a single gRPC "
+      "subscriber that does not read them fast enough. Exceeding this drops "
+      "the oldest pending notification")(
+      "grpc.batch-window", boost::program_options::value<unsigned>()->default_value(0),
+      "Milliseconds notifications are collected for before they are written "
+      "as one response, on gRPC subscribe calls that subscribed with paths. "
+      "0 writes them as soon as the previous response is written");
+  return grpc_desc;
+}
+
 void grpcHandler::RunServer(std::shared_ptr<VssCommandProcessor> Processor,
                             std::shared_ptr<IVssDatabase> database,
                             std::shared_ptr<ISubscriptionHandler> subhandler_,
                             std::shared_ptr<ILogger> logger_,
-                            std::string certPath, bool allowInsecureConn) {
+                            std::string certPath, bool allowInsecureConn,
+                            unsigned threads, size_t queueDepth,
+                            unsigned batchWindow) {
   string server_address("0.0.0.0:50051");
-  RequestServiceImpl service(logger_, database, subhandler_);
+  AsyncServer server(logger_, database, subhandler_, queueDepth,
+                     std::chrono::milliseconds(batchWindow));
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
 
   grpc::EnableDefaultHealthCheckService(true);
   grpc::reflection::InitProtoReflectionServerBuilderPlugin();
@@ -655,20 +1978,62 @@ void grpcHandler::RunServer(std::shared_ptr<VssCommandProcessor> Processor,
   }
 
   // Register "service" as the instance through which we'll communicate with
-  // clients. In this case it corresponds to an *synchronous* service.
-  builder.RegisterService(&service);
+  // clients. In this case it corresponds to an *asynchronous* service.
+  builder.RegisterService(&server.service);
+  builder.RegisterService(&server.valService);
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> queues;
+  for (unsigned i = 0; i < threads; i++) {
+    queues.push_back(builder.AddCompletionQueue());
+  }
   // Finally assemble the server
   handler.grpcServer = builder.BuildAndStart();
   handler.grpcProcessor = Processor;
   handler.grpcDatabase = database;
   handler.logger_ = logger_;
-  handler.logger_->Log(LogLevel::INFO, "Kuksa viss gRPC server Version 1.0.0");
+  handler.logger_->Log(LogLevel::INFO,
+                       "Kuksa viss gRPC server Version " + ServerVersion);
   handler.logger_->Log(LogLevel::INFO,
                        "gRPC Server listening on " + string(server_address));
 
+  handler.logger_->Log(LogLevel::INFO, "gRPC Server uses " +
+                                           std::to_string(threads) +
+                                           " threads");
+
+  std::vector<std::thread> pollers;
+  for (auto& cq : queues) {
+    KuksaUnaryCall<kuksa::GetRequest, kuksa::GetResponse>::listen(
+        server.service, server.impl, cq.get(),
+        &kuksa_grpc_if::AsyncService::Requestget, &RequestServiceImpl::get);
+    KuksaUnaryCall<kuksa::SetRequest, kuksa::SetResponse>::listen(
+        server.service, server.impl, cq.get(),
+        &kuksa_grpc_if::AsyncService::Requestset, &RequestServiceImpl::set);
+    KuksaUnaryCall<kuksa::AuthRequest, kuksa::AuthResponse>::listen(
+        server.service, server.impl, cq.get(),
+        &kuksa_grpc_if::AsyncService::Requestauthorize,
+        &RequestServiceImpl::authorize);
+    SubscribeCall::listen(server, cq.get());
+
+    ValUnaryCall<kuksa::val::v1::GetRequest, kuksa::val::v1::GetResponse>::listen(
+        server.valService, server.valImpl, cq.get(),
+        &kuksa::val::v1::VAL::AsyncService::RequestGet, &ValServiceImpl::get);
+    ValUnaryCall<kuksa::val::v1::SetRequest, kuksa::val::v1::SetResponse>::listen(
+        server.valService, server.valImpl, cq.get(),
+        &kuksa::val::v1::VAL::AsyncService::RequestSet, &ValServiceImpl::set);
+    ValUnaryCall<kuksa::val::v1::GetServerInfoRequest,
+                 kuksa::val::v1::GetServerInfoResponse>::
+        listen(server.valService, server.valImpl, cq.get(),
+               &kuksa::val::v1::VAL::AsyncService::RequestGetServerInfo,
+               &ValServiceImpl::getServerInfo);
+    ValSubscribeCall::listen(server, cq.get());
+    pollers.emplace_back(pollCompletionQueue, cq.get());
+  }
+
   // Wait for the server to shutdown. Note that some other thread must be
-  // responsible for shutting down the server for this call to ever return.
-  handler.getGrpcServer()->Wait();
+  // responsible for shutting down the server and the completion queues for
+  // this call to ever return.
+  for (auto& poller : pollers) {
+    poller.join();
+  }
 }
 
 grpcHandler::grpcHandler() = default;
@@ -47,6 +47,8 @@
 #include "exception.hpp"
 #include "grpcHandler.hpp"
 #include "OverlayLoader.hpp"
+#include "ShmIngestor.hpp"
+#include "VssModelCache.hpp"
 
 
 #include "../buildinfo.h"
@@ -116,6 +118,7 @@ int main(int argc, const char *argv[]) {
       "log-level = ALL\n")
     ("vss", program_options::value<boost::filesystem::path>()->required(), "[mandatory] Path to VSS data file describing VSS data tree structure which `kuksa-val-server` shall handle. Sample 'vss_release_4.0.json' file can be found under [data](./data/vss-core/vss_release_4.0.json)")
     ("overlays", program_options::value<boost::filesystem::path>(), "Path to a directory cotaiing additional VSS models. All json files will be applied on top of the main vss file given by the -vss parameter in alphanumerical order")
+    ("vss-cache", program_options::value<boost::filesystem::path>(), "If provided, `kuksa-val-server` keeps a precompiled binary copy of the VSS model (vss file with overlays applied) in this directory. As long as neither the vss file nor any overlay changes, the server starts from this cache instead of parsing the JSON files")
     ("cert-path", program_options::value<boost::filesystem::path>()->required()->default_value(boost::filesystem::path(".")),
       "[mandatory] Directory path where 'Server.pem', 'Server.key' and 'jwt.key.pub' are located. ")
     ("insecure", program_options::bool_switch()->default_value(false), "By default, `kuksa-val-server` shall accept only SSL (TLS) secured connections. If provided, `kuksa-val-server` shall also accept plain un-secured connections for Web-Socket and GRPC API connections, and also shall not fail connections due to self-signed certificates.")
@@ -135,6 +138,10 @@ int main(int argc, const char *argv[]) {
       "log level values.\n"
       "Supported log levels: NONE, VERBOSE, INFO, WARNING, ERROR, ALL");
   desc.add(MQTTPublisher::getOptions());
+  desc.add(SubscriptionHandler::getOptions());
+  desc.add(WebSockHttpFlexServer::getOptions());
+  desc.add(grpcHandler::getOptions());
+  desc.add(ShmIngestor::getOptions());
   program_options::variables_map variables;
   program_options::store(parse_command_line(argc, argv, desc), variables);
   // if config file passed, get configuration from it
@@ -214,7 +221,7 @@ int main(int argc, const char *argv[]) {
     string jwtPubkey =
         Authenticator::getPublicKeyFromFile(pubKeyFile.string(), logger);
     auto httpServer = std::make_shared<WebSockHttpFlexServer>(
-        logger);
+        logger, variables);
 
     auto tokenValidator =
         std::make_shared<Authenticator>(logger, jwtPubkey, "RS256");
@@ -224,8 +231,11 @@ int main(int argc, const char *argv[]) {
         logger, "vss", variables);
 
     auto subHandler = std::make_shared<SubscriptionHandler>(
-        logger, httpServer, tokenValidator, accessCheck);
+        logger, httpServer, tokenValidator, accessCheck,
+        variables["subscription.workers"].as<unsigned>(),
+        variables["subscription.queue-size"].as<size_t>());
     subHandler->addPublisher(mqttPublisher);
+    httpServer->SetSubscriptionHandler(subHandler);
 
     std::shared_ptr<VssDatabase> database = std::make_shared<VssDatabase>(logger,subHandler);
 
@@ -245,8 +255,24 @@ int main(int argc, const char *argv[]) {
     auto cmdProcessor = std::make_shared<VssCommandProcessor>(
         logger, database, tokenValidator, accessCheck, subHandler);
 
-    database->initJsonTree(vss_path);
-    applyOverlays(logger, overlayfiles ,database);
+    if (variables.count("vss-cache")) {
+      std::vector<boost::filesystem::path> modelFiles{vss_path};
+      modelFiles.insert(modelFiles.end(), overlayfiles.begin(), overlayfiles.end());
+      auto modelHash = VssModelCache::hashFiles(modelFiles);
+
+      VssModelCache modelCache(logger, variables["vss-cache"].as<boost::filesystem::path>());
+      jsoncons::json compiledTree;
+      if (modelCache.load(modelHash, compiledTree)) {
+        database->initCompiledTree(std::move(compiledTree));
+      } else {
+        database->initJsonTree(vss_path);
+        applyOverlays(logger, overlayfiles ,database);
+        modelCache.store(modelHash, database->getCompiledTree());
+      }
+    } else {
+      database->initJsonTree(vss_path);
+      applyOverlays(logger, overlayfiles ,database);
+    }
 
     if(variables.count("mqtt.publish")){
         string path_to_publish = variables["mqtt.publish"].as<string>();
@@ -268,12 +294,31 @@ int main(int argc, const char *argv[]) {
           }
         }
       }
+      std::unique_ptr<ShmIngestor> shmIngestor;
+      if (variables.count("shm.feeder")) {
+        shmIngestor.reset(new ShmIngestor(logger, database,
+                                          variables["shm.batch-size"].as<size_t>(),
+                                          std::chrono::microseconds(variables["shm.poll-interval"].as<unsigned>())));
+        for (const auto &feeder : variables["shm.feeder"].as<vector<string>>()) {
+          shmIngestor->addFeeder(feeder, variables["shm.ring-size"].as<uint32_t>(),
+                                 variables["shm.signals"].as<uint32_t>());
+        }
+        shmIngestor->start();
+      }
       bool insecureConn;
       if(variables.count("insecure")){
         insecureConn = variables["insecure"].as<bool>();
       }
+      // subscribe calls drop the oldest pending notification to make room,
+      // which needs room for at least one
+      if (variables["grpc.queue-depth"].as<size_t>() == 0) {
+        throw program_options::validation_error(program_options::validation_error::invalid_option_value,
+                                                "grpc.queue-depth");
+      }
       std::thread http(httpRunServer, variables, httpServer, cmdProcessor);
-      std::thread grpc(grpcHandler::RunServer, cmdProcessor, database, subHandler, logger, variables["cert-path"].as<boost::filesystem::path>().string(),insecureConn);
+      std::thread grpc(grpcHandler::RunServer, cmdProcessor, database, subHandler, logger, variables["cert-path"].as<boost::filesystem::path>().string(),insecureConn,
+                       variables["grpc.threads"].as<unsigned>(), variables["grpc.queue-depth"].as<size_t>(),
+                       variables["grpc.batch-window"].as<unsigned>());
       http.join();
       grpc.join();
       
@@ -0,0 +1,123 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ConnectionRegistry.hpp"
+
+namespace {
+  struct FakeConnection : public IConnection {
+    int sent = 0;
+    bool send(const OutboundMessage &) override {
+      sent++;
+      return true;
+    }
+  };
+}
+
+BOOST_AUTO_TEST_SUITE( ConnectionRegistryTests )
+
+BOOST_AUTO_TEST_CASE(Added_Connection_Is_Found_By_Id) {
+    ConnectionRegistry registry;
+    auto first = std::make_shared<FakeConnection>();
+    auto second = std::make_shared<FakeConnection>();
+    ConnectionId firstId = registry.add(first);
+    ConnectionId secondId = registry.add(second);
+
+    BOOST_TEST(firstId != 0u);
+    BOOST_TEST(firstId != secondId);
+    BOOST_TEST(registry.find(firstId) == first);
+    BOOST_TEST(registry.find(secondId) == second);
+    BOOST_TEST(registry.size() == 2u);
+    BOOST_TEST(registry.find(0) == nullptr);
+    BOOST_TEST(registry.find(secondId + 1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Id_Of_Removed_Connection_Does_Not_Reach_Slot_Reuser) {
+    ConnectionRegistry registry;
+    auto first = std::make_shared<FakeConnection>();
+    ConnectionId firstId = registry.add(first);
+    registry.remove(firstId);
+    BOOST_TEST(registry.find(firstId) == nullptr);
+
+    auto second = std::make_shared<FakeConnection>();
+    ConnectionId secondId = registry.add(second);
+    // same slot, next generation
+    BOOST_TEST(static_cast<uint32_t>(secondId) == static_cast<uint32_t>(firstId));
+    BOOST_TEST(secondId != firstId);
+    BOOST_TEST(registry.find(firstId) == nullptr);
+    BOOST_TEST(registry.find(secondId) == second);
+
+    // removing the stale id again does not remove the new connection
+    registry.remove(firstId);
+    BOOST_TEST(registry.find(secondId) == second);
+    BOOST_TEST(registry.size() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(Destroyed_Connection_Is_Not_Found_Before_Removal) {
+    ConnectionRegistry registry;
+    auto connection = std::make_shared<FakeConnection>();
+    ConnectionId id = registry.add(connection);
+    connection.reset();
+    BOOST_TEST(registry.find(id) == nullptr);
+    registry.remove(id);
+    BOOST_TEST(registry.size() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Connections_Are_Found_While_Others_Come_And_Go) {
+    ConnectionRegistry registry;
+    auto stable = std::make_shared<FakeConnection>();
+    ConnectionId stableId = registry.add(stable);
+
+    std::atomic<bool> stop{false};
+    std::thread churn([&registry, &stop]() {
+      // spans several chunks of slots
+      std::vector<std::shared_ptr<FakeConnection>> connections;
+      std::vector<ConnectionId> ids;
+      for (size_t i = 0; i < 3 * ConnectionRegistry::CHUNK_SIZE; i++) {
+        connections.push_back(std::make_shared<FakeConnection>());
+        ids.push_back(registry.add(connections.back()));
+      }
+      while (!stop) {
+        for (size_t i = 0; i < ids.size(); i += 2) {
+          registry.remove(ids[i]);
+          ids[i] = registry.add(connections[i]);
+        }
+      }
+    });
+
+    bool alwaysFound = true;
+    for (int i = 0; i < 100000; i++) {
+      alwaysFound = alwaysFound && registry.find(stableId) == stable;
+    }
+    stop = true;
+    churn.join();
+    BOOST_TEST(alwaysFound);
+    BOOST_TEST(registry.size() == 3 * ConnectionRegistry::CHUNK_SIZE + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
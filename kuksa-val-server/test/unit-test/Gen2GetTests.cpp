@@ -413,7 +413,7 @@ BOOST_AUTO_TEST_CASE(Gen2_Get_StableTimestamp) {
   jsoncons::json value="100";
   MOCK_EXPECT(subHandlerMock->publishForVSSPath)
       .once()
-      .with(mock::any, "float", "value", mock::any)
+      .with(mock::any, "float", "value", mock::any, mock::any)
       .returns(true);
   db->setSignal(vss_path, "value", value);
   
@@ -0,0 +1,237 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <turtle/mock.hpp>
+#undef BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+#include <memory>
+#include <string>
+
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#include "KuksaChannel.hpp"
+#include "ILoggerMock.hpp"
+#include "IVssDatabaseMock.hpp"
+#include "IAuthenticatorMock.hpp"
+#include "IAccessCheckerMock.hpp"
+#include "ISubscriptionHandlerMock.hpp"
+
+#include "exception.hpp"
+#include "grpcHandler.hpp"
+#include "VssCommandProcessor.hpp"
+
+namespace {
+  // common resources for tests
+  std::shared_ptr<ILoggerMock> logMock;
+  std::shared_ptr<IVssDatabaseMock> dbMock;
+  std::shared_ptr<IAuthenticatorMock> authMock;
+  std::shared_ptr<IAccessCheckerMock> accCheckMock;
+  std::shared_ptr<ISubscriptionHandlerMock> subsHndlMock;
+
+  std::unique_ptr<VssCommandProcessor> processor;
+
+  // Pre-test initialization and post-test desctruction of common resources
+  struct TestSuiteFixture {
+    TestSuiteFixture() {
+      logMock = std::make_shared<ILoggerMock>();
+      dbMock = std::make_shared<IVssDatabaseMock>();
+      authMock = std::make_shared<IAuthenticatorMock>();
+      accCheckMock = std::make_shared<IAccessCheckerMock>();
+      subsHndlMock = std::make_shared<ISubscriptionHandlerMock>();
+
+      processor = std::make_unique<VssCommandProcessor>(logMock, dbMock, authMock, accCheckMock, subsHndlMock);
+    }
+    ~TestSuiteFixture() {
+      logMock.reset();
+      dbMock.reset();
+      authMock.reset();
+      accCheckMock.reset();
+      subsHndlMock.reset();
+      processor.reset();
+    }
+  };
+
+  kuksa::Value doubleValue(const std::string& path, double value) {
+    kuksa::Value v;
+    v.set_path(path);
+    v.set_valuedouble(value);
+    return v;
+  }
+
+  KuksaChannel grpcChannel() {
+    KuksaChannel channel;
+    channel.setAuthorized(true);
+    channel.setConnID(1);
+    channel.setType(KuksaChannel::Type::GRPC);
+    return channel;
+  }
+}
+
+BOOST_FIXTURE_TEST_SUITE(GrpcSubscribeTests, TestSuiteFixture)
+
+///////////////////////////
+// Test batching of notifications
+
+BOOST_AUTO_TEST_CASE(Batch_Conflates_Updates_Of_A_Signal) {
+  GrpcUpdateBatch batch;
+  batch.add(doubleValue("Vehicle.Speed", 1.0));
+  batch.add(doubleValue("Vehicle.Cabin.Lights.AmbientLight", 2.0));
+  batch.add(doubleValue("Vehicle.Speed", 3.0));
+
+  BOOST_TEST(batch.size() == 2u);
+
+  kuksa::SubscribeResponse response;
+  batch.take(&response);
+
+  // one entry per signal, in the order the signals first changed, with the
+  // latest value
+  BOOST_TEST(response.updates_size() == 2);
+  BOOST_TEST(response.updates(0).path() == "Vehicle.Speed");
+  BOOST_TEST(response.updates(0).valuedouble() == 3.0);
+  BOOST_TEST(response.updates(1).path() == "Vehicle.Cabin.Lights.AmbientLight");
+  BOOST_TEST(response.updates(1).valuedouble() == 2.0);
+}
+
+BOOST_AUTO_TEST_CASE(Batch_Is_Empty_After_Take) {
+  GrpcUpdateBatch batch;
+  batch.add(doubleValue("Vehicle.Speed", 1.0));
+
+  kuksa::SubscribeResponse first;
+  batch.take(&first);
+  BOOST_TEST(batch.empty());
+  BOOST_TEST(first.updates_size() == 1);
+
+  // the next window starts over, a signal of the previous one is new again
+  batch.add(doubleValue("Vehicle.Speed", 2.0));
+  kuksa::SubscribeResponse second;
+  batch.take(&second);
+  BOOST_TEST(second.updates_size() == 1);
+  BOOST_TEST(second.updates(0).valuedouble() == 2.0);
+}
+
+BOOST_AUTO_TEST_CASE(Batch_Keeps_All_Distinct_Signals_Of_A_Window) {
+  GrpcUpdateBatch batch;
+  const int signals = 1000;
+  for (int i = 0; i < signals; ++i) {
+    batch.add(doubleValue("Vehicle.Signal" + std::to_string(i), i));
+  }
+
+  kuksa::SubscribeResponse response;
+  batch.take(&response);
+
+  // nothing is dropped, however many signals changed within the window
+  BOOST_TEST(response.updates_size() == signals);
+  BOOST_TEST(response.updates(signals - 1).path() == "Vehicle.Signal999");
+}
+
+///////////////////////////
+// Test subscribing several paths with one request
+
+BOOST_AUTO_TEST_CASE(Given_SeveralPaths_When_Subscribe_Shall_SubscribeEachPath) {
+  KuksaChannel channel = grpcChannel();
+  GrpcSubscriptionMap currentSubs;
+  boost::uuids::uuid speedId = boost::uuids::random_generator()();
+  boost::uuids::uuid lightId = boost::uuids::random_generator()();
+
+  kuksa::SubscribeRequest request;
+  request.set_type(kuksa::RequestType::CURRENT_VALUE);
+  request.set_start(true);
+  request.add_paths("Vehicle.Speed");
+  request.add_paths("Vehicle.Cabin.Lights.AmbientLight");
+
+  MOCK_EXPECT(logMock->Log).at_least(0);
+  MOCK_EXPECT(subsHndlMock->subscribe)
+    .once()
+    .with(mock::any, dbMock, "Vehicle.Speed", "value")
+    .returns(speedId);
+  MOCK_EXPECT(subsHndlMock->subscribe)
+    .once()
+    .with(mock::any, dbMock, "Vehicle.Cabin.Lights.AmbientLight", "value")
+    .returns(lightId);
+
+  kuksa::SubscribeResponse response;
+  grpcHandler::grpc_subscribe(*processor, *logMock, channel, request, currentSubs, &response);
+
+  BOOST_TEST(response.status().statuscode() == 200u);
+  BOOST_TEST(currentSubs.size() == 2u);
+  BOOST_TEST(currentSubs[subscription_keys_t("Vehicle.Speed", "value")] == boost::uuids::to_string(speedId));
+  BOOST_TEST(currentSubs[subscription_keys_t("Vehicle.Cabin.Lights.AmbientLight", "value")] == boost::uuids::to_string(lightId));
+}
+
+BOOST_AUTO_TEST_CASE(Given_SeveralPaths_When_Unsubscribe_Shall_UnsubscribeEachPath) {
+  KuksaChannel channel = grpcChannel();
+  GrpcSubscriptionMap currentSubs;
+  boost::uuids::uuid speedId = boost::uuids::random_generator()();
+  boost::uuids::uuid lightId = boost::uuids::random_generator()();
+  currentSubs[subscription_keys_t("Vehicle.Speed", "value")] = boost::uuids::to_string(speedId);
+  currentSubs[subscription_keys_t("Vehicle.Cabin.Lights.AmbientLight", "value")] = boost::uuids::to_string(lightId);
+
+  kuksa::SubscribeRequest request;
+  request.set_type(kuksa::RequestType::CURRENT_VALUE);
+  request.set_start(false);
+  request.add_paths("Vehicle.Speed");
+  request.add_paths("Vehicle.Cabin.Lights.AmbientLight");
+
+  MOCK_EXPECT(logMock->Log).at_least(0);
+  MOCK_EXPECT(subsHndlMock->unsubscribe).once().with(speedId).returns(0);
+  MOCK_EXPECT(subsHndlMock->unsubscribe).once().with(lightId).returns(0);
+
+  kuksa::SubscribeResponse response;
+  grpcHandler::grpc_subscribe(*processor, *logMock, channel, request, currentSubs, &response);
+
+  BOOST_TEST(response.status().statuscode() == 200u);
+  BOOST_TEST(currentSubs.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Given_SeveralPaths_When_OnePathUnknown_Shall_SubscribeOthersAndReturnError) {
+  KuksaChannel channel = grpcChannel();
+  GrpcSubscriptionMap currentSubs;
+  boost::uuids::uuid speedId = boost::uuids::random_generator()();
+
+  kuksa::SubscribeRequest request;
+  request.set_type(kuksa::RequestType::CURRENT_VALUE);
+  request.set_start(true);
+  request.add_paths("Vehicle.Speed");
+  request.add_paths("Vehicle.Unknown");
+
+  MOCK_EXPECT(logMock->Log).at_least(1);
+  MOCK_EXPECT(subsHndlMock->subscribe)
+    .once()
+    .with(mock::any, dbMock, "Vehicle.Speed", "value")
+    .returns(speedId);
+  MOCK_EXPECT(subsHndlMock->subscribe)
+    .once()
+    .with(mock::any, dbMock, "Vehicle.Unknown", "value")
+    .throws(noPathFoundonTree("Vehicle.Unknown"));
+
+  kuksa::SubscribeResponse response;
+  grpcHandler::grpc_subscribe(*processor, *logMock, channel, request, currentSubs, &response);
+
+  BOOST_TEST(response.status().statuscode() == 400u);
+  BOOST_TEST(currentSubs.size() == 1u);
+  BOOST_TEST(currentSubs.count(subscription_keys_t("Vehicle.Speed", "value")) == 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
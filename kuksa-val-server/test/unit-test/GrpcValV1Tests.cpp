@@ -0,0 +1,151 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <jsoncons/json.hpp>
+
+#include <string>
+
+#include "grpcHandler.hpp"
+#include "VssValueStore.hpp"
+
+
+BOOST_AUTO_TEST_SUITE( GrpcValV1Tests )
+
+BOOST_AUTO_TEST_CASE(Datapoint_Carries_Type_Of_Datatype) {
+    VssValueSlot slot;
+    // untyped, as default values may be
+    slot.value = VssValue::fromUInt64(42);
+    slot.ts_s = 1234;
+    slot.ts_ns = 5678;
+
+    kuksa::val::v1::Datapoint datapoint;
+    grpcHandler::grpc_fill_datapoint(slot, "uint8", &datapoint);
+    BOOST_TEST((datapoint.value_case() == kuksa::val::v1::Datapoint::kUint32));
+    BOOST_TEST(datapoint.uint32() == 42u);
+    BOOST_TEST(datapoint.timestamp().seconds() == 1234);
+    BOOST_TEST(datapoint.timestamp().nanos() == 5678);
+
+    grpcHandler::grpc_fill_datapoint(slot, "double", &datapoint);
+    BOOST_TEST((datapoint.value_case() == kuksa::val::v1::Datapoint::kDouble));
+    BOOST_TEST(datapoint.double_() == 42.0);
+
+    slot.value = VssValue::fromString("AUTO");
+    grpcHandler::grpc_fill_datapoint(slot, "string", &datapoint);
+    BOOST_TEST((datapoint.value_case() == kuksa::val::v1::Datapoint::kString));
+    BOOST_TEST(datapoint.string() == "AUTO");
+}
+
+BOOST_AUTO_TEST_CASE(Array_Datapoint_Roundtrip) {
+    VssValueSlot slot;
+    slot.value = VssValue::fromArray({VssValue::fromInt64(-1, VssValue::Type::INT8),
+                                      VssValue::fromInt64(7, VssValue::Type::INT8)});
+
+    kuksa::val::v1::Datapoint datapoint;
+    grpcHandler::grpc_fill_datapoint(slot, "int8[]", &datapoint);
+    BOOST_TEST((datapoint.value_case() == kuksa::val::v1::Datapoint::kInt32Array));
+    BOOST_TEST(datapoint.int32_array().values_size() == 2);
+    BOOST_TEST(datapoint.int32_array().values(0) == -1);
+
+    VssValue value = grpcHandler::grpc_datapoint_value(datapoint);
+    BOOST_TEST((value.type() == VssValue::Type::ARRAY));
+    BOOST_TEST(value.asArray().size() == 2u);
+    BOOST_TEST(value.asArray()[1].asInt64() == 7);
+}
+
+BOOST_AUTO_TEST_CASE(Empty_Datapoint_Has_No_Value) {
+    kuksa::val::v1::Datapoint datapoint;
+    BOOST_TEST(grpcHandler::grpc_datapoint_value(datapoint).isSet() == false);
+
+    datapoint.set_bool_(true);
+    VssValue value = grpcHandler::grpc_datapoint_value(datapoint);
+    BOOST_TEST((value == VssValue::fromBool(true)));
+}
+
+BOOST_AUTO_TEST_CASE(Entry_Update_Of_Published_Target_Value) {
+    jsoncons::json data;
+    jsoncons::json dp;
+    dp["targetValue"] = true;
+    dp["ts_s"] = 10;
+    dp["ts_ns"] = 20;
+    data["path"] = "Vehicle.Cabin.Door.Row1.Left.IsOpen";
+    data["dp"] = dp;
+
+    kuksa::val::v1::EntryUpdate update;
+    grpcHandler::grpc_fill_entry_update("Vehicle.Cabin.Door.Row1.Left.IsOpen", "boolean",
+                                        "targetValue", data, &update);
+    BOOST_TEST(update.entry().path() == "Vehicle.Cabin.Door.Row1.Left.IsOpen");
+    BOOST_TEST(update.entry().has_value() == false);
+    BOOST_TEST(update.entry().actuator_target().bool_() == true);
+    BOOST_TEST(update.entry().actuator_target().timestamp().seconds() == 10);
+    BOOST_TEST(update.fields_size() == 1);
+    BOOST_TEST(update.fields(0) == kuksa::val::v1::FIELD_ACTUATOR_TARGET);
+}
+
+BOOST_AUTO_TEST_CASE(Subscribe_Response_Of_Published_Value) {
+    jsoncons::json data;
+    jsoncons::json dp;
+    dp["value"] = 120;
+    dp["ts_s"] = 10;
+    dp["ts_ns"] = 20;
+    data["path"] = "Vehicle.Speed";
+    data["dp"] = dp;
+
+    kuksa::SubscribeResponse resp;
+    grpcHandler::grpc_fill_subscribe_response("Vehicle.Speed", "float", "value", data, &resp);
+    BOOST_TEST(resp.status().statuscode() == 200u);
+    BOOST_TEST(resp.values().path() == "Vehicle.Speed");
+    BOOST_TEST((resp.values().val_case() == kuksa::Value::kValueFloat));
+    BOOST_TEST(resp.values().valuefloat() == 120.0f);
+    BOOST_TEST(resp.values().timestamp().seconds() == 10);
+    BOOST_TEST(resp.values().timestamp().nanos() == 20);
+
+    kuksa::Value value;
+    grpcHandler::grpc_fill_value(VssValue::fromString("AUTO"), VssValue::Type::STRING, &value);
+    BOOST_TEST(value.valuestring() == "AUTO");
+}
+
+BOOST_AUTO_TEST_CASE(Metadata_Of_Node) {
+    jsoncons::json node = jsoncons::json::parse(R"({
+        "datatype": "int8",
+        "type": "actuator",
+        "description": "Mirror pan as a percent",
+        "unit": "percent",
+        "min": -100,
+        "max": 100
+    })");
+
+    kuksa::val::v1::Metadata metadata;
+    grpcHandler::grpc_fill_metadata(node, &metadata);
+    BOOST_TEST(metadata.data_type() == kuksa::val::v1::DATA_TYPE_INT8);
+    BOOST_TEST(metadata.entry_type() == kuksa::val::v1::ENTRY_TYPE_ACTUATOR);
+    BOOST_TEST(metadata.has_actuator());
+    BOOST_TEST(metadata.description() == "Mirror pan as a percent");
+    BOOST_TEST(metadata.unit() == "percent");
+    BOOST_TEST(metadata.has_comment() == false);
+    BOOST_TEST(metadata.value_restriction().signed_().min() == -100);
+    BOOST_TEST(metadata.value_restriction().signed_().max() == 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+#include "MessageEncoding.hpp"
+
+namespace {
+  const KuksaChannel::Encoding AllEncodings[] = {
+    KuksaChannel::Encoding::JSON,
+    KuksaChannel::Encoding::CBOR,
+    KuksaChannel::Encoding::MSGPACK
+  };
+}
+
+BOOST_AUTO_TEST_SUITE( MessageEncodingTests )
+
+BOOST_AUTO_TEST_CASE(First_Supported_Subprotocol_Is_Selected) {
+    KuksaChannel::Encoding encoding = KuksaChannel::Encoding::JSON;
+    BOOST_TEST(MessageEncoding::fromSubprotocols("chat, kuksa.msgpack ,kuksa.cbor", encoding));
+    BOOST_TEST((encoding == KuksaChannel::Encoding::MSGPACK));
+    BOOST_TEST(MessageEncoding::fromSubprotocols("kuksa.cbor", encoding));
+    BOOST_TEST((encoding == KuksaChannel::Encoding::CBOR));
+    BOOST_TEST(MessageEncoding::fromSubprotocols("kuksa.json", encoding));
+    BOOST_TEST((encoding == KuksaChannel::Encoding::JSON));
+    BOOST_TEST(MessageEncoding::fromSubprotocols("chat,superchat", encoding) == false);
+
+    for (auto enc : AllEncodings) {
+      BOOST_TEST(MessageEncoding::fromSubprotocols(MessageEncoding::subprotocol(enc), encoding));
+      BOOST_TEST((encoding == enc));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Encoded_Message_Decodes_To_Same_Json) {
+    jsoncons::json message = jsoncons::json::parse(
+        R"({"action":"get","path":"Vehicle.Speed","requestId":"1234","value":[1.5,-2,true,null]})");
+    for (auto encoding : AllEncodings) {
+      BOOST_TEST(MessageEncoding::decode(MessageEncoding::encode(message, encoding), encoding) == message);
+    }
+    BOOST_TEST(MessageEncoding::encode(message, KuksaChannel::Encoding::JSON).find(' ') == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(Subscription_Envelope_Completes_Encoded_Data) {
+    jsoncons::json data = jsoncons::json::parse(
+        R"({"path":"Vehicle.Speed","dp":{"value":"42.0","ts":"2022-01-01T00:00:00.000000000Z"}})");
+    const std::string subscriptionId = "1e0fc6b4-1a2c-4b6a-9e4c-1a2b3c4d5e6f";
+
+    jsoncons::json expected;
+    expected["action"] = "subscription";
+    expected["data"] = data;
+    expected["subscriptionId"] = subscriptionId;
+
+    for (auto encoding : AllEncodings) {
+      std::string head, tail;
+      MessageEncoding::subscriptionEnvelope(encoding, subscriptionId, head, tail);
+      std::string message = head + MessageEncoding::encode(data, encoding) + tail;
+      BOOST_TEST(MessageEncoding::decode(message, encoding) == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Malformed_Message_Throws) {
+    BOOST_CHECK_THROW(MessageEncoding::decode("{\"action\":", KuksaChannel::Encoding::JSON), std::exception);
+    BOOST_CHECK_THROW(MessageEncoding::decode(std::string(1, '\xa3'), KuksaChannel::Encoding::CBOR), std::exception);
+    BOOST_CHECK_THROW(MessageEncoding::decode(std::string(1, '\x83'), KuksaChannel::Encoding::MSGPACK), std::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
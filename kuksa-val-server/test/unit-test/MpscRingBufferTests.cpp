@@ -0,0 +1,112 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MpscRingBuffer.hpp"
+
+
+BOOST_AUTO_TEST_SUITE( MpscRingBufferTests )
+
+BOOST_AUTO_TEST_CASE(Capacity_Is_Rounded_To_Power_Of_Two) {
+    MpscRingBuffer<int> queue(100);
+    BOOST_TEST(queue.capacity() == 128u);
+    BOOST_CHECK_THROW(MpscRingBuffer<int>(0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Pop_Returns_Items_In_Push_Order) {
+    MpscRingBuffer<std::string> queue(4);
+    std::string item;
+    BOOST_TEST(queue.empty());
+    BOOST_TEST(queue.tryPop(item) == false);
+
+    BOOST_TEST(queue.tryPush("a"));
+    BOOST_TEST(queue.tryPush("b"));
+    BOOST_TEST(queue.empty() == false);
+
+    BOOST_TEST(queue.tryPop(item));
+    BOOST_TEST(item == "a");
+    BOOST_TEST(queue.tryPop(item));
+    BOOST_TEST(item == "b");
+    BOOST_TEST(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Push_Fails_When_Full) {
+    MpscRingBuffer<std::string> queue(2);
+    std::string item;
+    BOOST_TEST(queue.tryPush("a"));
+    BOOST_TEST(queue.tryPush("b"));
+
+    std::string rejected("c");
+    BOOST_TEST(queue.tryPush(std::move(rejected)) == false);
+    BOOST_TEST(rejected == "c");
+
+    // space becomes available again after pop, also when wrapping around
+    BOOST_TEST(queue.tryPop(item));
+    BOOST_TEST(queue.tryPush(std::move(rejected)));
+    BOOST_TEST(queue.tryPop(item));
+    BOOST_TEST(item == "b");
+    BOOST_TEST(queue.tryPop(item));
+    BOOST_TEST(item == "c");
+}
+
+BOOST_AUTO_TEST_CASE(Concurrent_Producers_Keep_Per_Producer_Order) {
+    const int producers = 4;
+    const int itemsPerProducer = 20000;
+    MpscRingBuffer<std::pair<int, int>> queue(64);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < itemsPerProducer; i++) {
+                while (!queue.tryPush(std::make_pair(p, i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    bool ordered = true;
+    std::pair<int, int> item;
+    while (received < producers * itemsPerProducer) {
+        if (queue.tryPop(item)) {
+            ordered = ordered && (item.second == next[item.first]);
+            next[item.first] = item.second + 1;
+            received++;
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    BOOST_TEST(ordered);
+    BOOST_TEST(queue.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+#include "AccessChecker.hpp"
+#include "KuksaChannel.hpp"
+#include "PeerCredentials.hpp"
+#include "VSSPath.hpp"
+
+namespace {
+  const char *users = R"({
+    "gps-feeder": { "kuksa-vss": { "Vehicle.CurrentLocation.*": "rw" } },
+    "1001": { "kuksa-vss": { "Vehicle.Speed": "r" }, "modifyTree": true }
+  })";
+}
+
+BOOST_AUTO_TEST_SUITE( PeerCredentialsTests )
+
+BOOST_AUTO_TEST_CASE(User_Is_Granted_Permissions_By_Name) {
+    PeerCredentials credentials(jsoncons::json::parse(users));
+    AccessChecker checker(nullptr);
+    KuksaChannel channel;
+
+    BOOST_TEST(credentials.authorize(channel, 1000, "gps-feeder"));
+    BOOST_TEST(channel.isAuthorized());
+    BOOST_TEST(!channel.authorizedToModifyTree());
+    BOOST_TEST(checker.checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.CurrentLocation.Latitude")));
+    BOOST_TEST(!checker.checkReadAccess(channel, VSSPath::fromVSS("Vehicle.Speed")));
+}
+
+BOOST_AUTO_TEST_CASE(User_Is_Granted_Permissions_By_Id) {
+    PeerCredentials credentials(jsoncons::json::parse(users));
+    AccessChecker checker(nullptr);
+    KuksaChannel channel;
+
+    BOOST_TEST(credentials.authorize(channel, 1001, "obd"));
+    BOOST_TEST(channel.authorizedToModifyTree());
+    BOOST_TEST(checker.checkReadAccess(channel, VSSPath::fromVSS("Vehicle.Speed")));
+    BOOST_TEST(!checker.checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Speed")));
+}
+
+BOOST_AUTO_TEST_CASE(Unknown_User_Is_Not_Authorized) {
+    PeerCredentials credentials(jsoncons::json::parse(users));
+    KuksaChannel channel;
+
+    BOOST_TEST(!credentials.authorize(channel, 1002, "guest"));
+    BOOST_TEST(!channel.isAuthorized());
+}
+
+BOOST_AUTO_TEST_CASE(Invalid_Permission_Is_Rejected) {
+    BOOST_CHECK_THROW(PeerCredentials(jsoncons::json::parse(R"({"1001": {"kuksa-vss": {"Vehicle.*": "x"}}})")),
+                      std::invalid_argument);
+    BOOST_CHECK_THROW(PeerCredentials(jsoncons::json::parse(R"(["1001"])")), std::invalid_argument);
+    BOOST_CHECK_THROW(PeerCredentials::fromFile("does-not-exist.json"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
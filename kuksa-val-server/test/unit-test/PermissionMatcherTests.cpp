@@ -0,0 +1,77 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+#include "PermissionMatcher.hpp"
+
+BOOST_AUTO_TEST_SUITE( PermissionMatcherTests )
+
+BOOST_AUTO_TEST_CASE(Path_Without_Asterisk_Matches_Signal_Only) {
+    PermissionMatcher matcher(jsoncons::json::parse(R"({"Vehicle.Speed": "r", "Vehicle.Cabin.Door.Row1.Left.IsOpen": "rw"})"));
+    BOOST_TEST(matcher.allows("Vehicle.Speed", PermissionMatcher::READ));
+    BOOST_TEST(!matcher.allows("Vehicle.Speed", PermissionMatcher::WRITE));
+    BOOST_TEST(matcher.access("Vehicle.Cabin.Door.Row1.Left.IsOpen") == (PermissionMatcher::READ | PermissionMatcher::WRITE));
+    BOOST_TEST(matcher.access("Vehicle") == PermissionMatcher::NONE);
+    BOOST_TEST(matcher.access("Vehicle.Speed.Unit") == PermissionMatcher::NONE);
+    BOOST_TEST(matcher.access("Vehicle.SpeedX") == PermissionMatcher::NONE);
+}
+
+BOOST_AUTO_TEST_CASE(Asterisk_Element_Matches_One_Or_More_Elements) {
+    PermissionMatcher matcher(jsoncons::json::parse(R"({"Vehicle.OBD.*": "w", "Vehicle.*.IsOpen": "r"})"));
+    BOOST_TEST(matcher.access("Vehicle.OBD.DTC1") == PermissionMatcher::WRITE);
+    BOOST_TEST(matcher.access("Vehicle.OBD.Catalyst.Bank1.Temperature1") == PermissionMatcher::WRITE);
+    BOOST_TEST(matcher.access("Vehicle.OBD") == PermissionMatcher::NONE);
+    BOOST_TEST(matcher.access("Vehicle.Cabin.Door.Row1.Left.IsOpen") == PermissionMatcher::READ);
+    BOOST_TEST(matcher.access("Vehicle.IsOpen") == PermissionMatcher::NONE);
+}
+
+BOOST_AUTO_TEST_CASE(Asterisk_Within_Element_Matches_Part_Of_It) {
+    PermissionMatcher matcher(jsoncons::json::parse(R"({"Vehicle.Cabin.Door.Row*.Left.IsOpen": "rw"})"));
+    BOOST_TEST(matcher.allows("Vehicle.Cabin.Door.Row1.Left.IsOpen", PermissionMatcher::WRITE));
+    BOOST_TEST(matcher.allows("Vehicle.Cabin.Door.Row.Left.IsOpen", PermissionMatcher::READ));
+    BOOST_TEST(!matcher.allows("Vehicle.Cabin.Door.Column1.Left.IsOpen", PermissionMatcher::READ));
+    BOOST_TEST(!matcher.allows("Vehicle.Cabin.Door.Row1.Right.IsOpen", PermissionMatcher::READ));
+}
+
+BOOST_AUTO_TEST_CASE(Path_Takes_Precedence_Over_Patterns) {
+    // given as JSON string, as channels store them
+    PermissionMatcher matcher(jsoncons::json(std::string(R"({"Vehicle.*": "r", "Vehicle.Speed": "w", "Vehicle.OBD.*": "rw"})")));
+    BOOST_TEST(matcher.access("Vehicle.Speed") == PermissionMatcher::WRITE);
+    // the last matching pattern in key order
+    BOOST_TEST(matcher.access("Vehicle.OBD.DTC1") == (PermissionMatcher::READ | PermissionMatcher::WRITE));
+    BOOST_TEST(matcher.access("Vehicle.Cabin.Door.Row1.Left.IsOpen") == PermissionMatcher::READ);
+}
+
+BOOST_AUTO_TEST_CASE(No_Permissions_Grant_Nothing) {
+    PermissionMatcher empty{jsoncons::json(std::string())};
+    BOOST_TEST(empty.access("Vehicle.Speed") == PermissionMatcher::NONE);
+    PermissionMatcher none(jsoncons::json::parse("{}"));
+    BOOST_TEST(none.access("") == PermissionMatcher::NONE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,228 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+
+#include "RestApi.hpp"
+
+namespace {
+  /// Answers get requests with the path as value, counting the requests
+  struct FakeProcessor {
+    int queries = 0;
+    std::string revision = "7";
+
+    RestApi::QueryHandler query() {
+      return [this](jsoncons::json &request) {
+        queries++;
+        jsoncons::json response;
+        response["action"] = request["action"];
+        response["requestId"] = request["requestId"];
+        if (request["path"].as<std::string>() == "Vehicle/Unknown") {
+          jsoncons::json error;
+          error["number"] = "404";
+          error["reason"] = "Path not found";
+          error["message"] = "Vehicle/Unknown";
+          response["error"] = error;
+          return response;
+        }
+        jsoncons::json data;
+        data["path"] = request["path"];
+        response["data"] = data;
+        return response;
+      };
+    }
+
+    RestApi::RevisionHandler revisions() {
+      return [this](const std::string &) { return revision; };
+    }
+  };
+}
+
+BOOST_AUTO_TEST_SUITE( RestApiTests )
+
+BOOST_AUTO_TEST_CASE(Target_Is_Split_Into_Path_And_Parameters) {
+    std::string path;
+    std::multimap<std::string, std::string> params;
+
+    BOOST_TEST(RestApi::parseTarget("/vss/Vehicle/Cabin%2FDoor?attribute=targetValue&metadata&path=a+b", path, params));
+    BOOST_TEST(path == "Vehicle/Cabin/Door");
+    BOOST_TEST(params.size() == 3u);
+    BOOST_TEST(params.find("attribute")->second == "targetValue");
+    BOOST_TEST(params.count("metadata") == 1u);
+    BOOST_TEST(params.find("path")->second == "a b");
+
+    BOOST_TEST(RestApi::parseTarget("/vss?path=Vehicle.Speed&path=Vehicle.Width", path, params));
+    BOOST_TEST(path.empty());
+    BOOST_TEST(params.count("path") == 2u);
+
+    BOOST_TEST(RestApi::parseTarget("/vssx/Vehicle", path, params) == false);
+    BOOST_TEST(RestApi::parseTarget("/", path, params) == false);
+}
+
+BOOST_AUTO_TEST_CASE(If_None_Match_Uses_Weak_Comparison) {
+    BOOST_TEST(RestApi::etagMatches("\"a\", W/\"b\"", "\"b\""));
+    BOOST_TEST(RestApi::etagMatches("*", "\"b\""));
+    BOOST_TEST(RestApi::etagMatches("\"a\"", "\"b\"") == false);
+    BOOST_TEST(RestApi::etagMatches("", "\"b\"") == false);
+    BOOST_TEST(RestApi::etagMatches("*", "") == false);
+}
+
+BOOST_AUTO_TEST_CASE(Viss_Error_Number_Is_Http_Status) {
+    BOOST_TEST(RestApi::statusOf(jsoncons::json::parse(R"({"action":"get"})")) == 200u);
+    BOOST_TEST(RestApi::statusOf(jsoncons::json::parse(R"({"error":{"number":403}})")) == 403u);
+    BOOST_TEST(RestApi::statusOf(jsoncons::json::parse(R"({"error":{"number":"404"}})")) == 404u);
+    BOOST_TEST(RestApi::statusOf(jsoncons::json::parse(R"({"error":{"number":"x"}})")) == 500u);
+}
+
+BOOST_AUTO_TEST_CASE(Unchanged_Signal_Is_Answered_Without_Reading_It) {
+    FakeProcessor processor;
+    std::string token;
+    RestApi::Request request;
+    request.method = "GET";
+    request.target = "/vss/Vehicle/Speed";
+
+    auto first = RestApi::handle(request, processor.query(), processor.revisions(), token);
+    BOOST_TEST(first.status == 200u);
+    BOOST_TEST(first.etag.empty() == false);
+    BOOST_TEST(jsoncons::json::parse(first.body)["path"].as<std::string>() == "Vehicle/Speed");
+    BOOST_TEST(processor.queries == 1);
+
+    request.ifNoneMatch = first.etag;
+    auto second = RestApi::handle(request, processor.query(), processor.revisions(), token);
+    BOOST_TEST(second.status == 304u);
+    BOOST_TEST(second.etag == first.etag);
+    BOOST_TEST(processor.queries == 1);
+
+    processor.revision = "8";
+    auto third = RestApi::handle(request, processor.query(), processor.revisions(), token);
+    BOOST_TEST(third.status == 200u);
+    BOOST_TEST(third.etag != first.etag);
+    BOOST_TEST(processor.queries == 2);
+}
+
+BOOST_AUTO_TEST_CASE(Batch_Get_Returns_Array_Or_First_Error) {
+    FakeProcessor processor;
+    std::string token;
+    RestApi::Request request;
+    request.method = "GET";
+    request.target = "/vss?path=Vehicle/Speed&path=Vehicle/Width";
+
+    auto response = RestApi::handle(request, processor.query(), processor.revisions(), token);
+    BOOST_TEST(response.status == 200u);
+    jsoncons::json body = jsoncons::json::parse(response.body);
+    BOOST_TEST(body.size() == 2u);
+    BOOST_TEST(body[1]["path"].as<std::string>() == "Vehicle/Width");
+
+    request.target = "/vss?path=Vehicle/Speed&path=Vehicle/Unknown";
+    response = RestApi::handle(request, processor.query(), processor.revisions(), token);
+    BOOST_TEST(response.status == 404u);
+}
+
+BOOST_AUTO_TEST_CASE(Put_Sets_Attribute_And_Other_Methods_Are_Rejected) {
+    std::string token;
+    jsoncons::json received;
+    RestApi::QueryHandler query = [&received](jsoncons::json &request) {
+      received = request;
+      return jsoncons::json::parse(R"({"action":"set"})");
+    };
+    RestApi::RevisionHandler revision = [](const std::string &) { return std::string(); };
+
+    RestApi::Request request;
+    request.method = "PUT";
+    request.target = "/vss/Vehicle.Cabin.Door.Row1.Left.IsOpen?attribute=targetValue";
+    request.body = "true";
+    auto response = RestApi::handle(request, query, revision, token);
+    BOOST_TEST(response.status == 204u);
+    BOOST_TEST(received["action"].as<std::string>() == "set");
+    BOOST_TEST(received["path"].as<std::string>() == "Vehicle.Cabin.Door.Row1.Left.IsOpen");
+    BOOST_TEST(received["targetValue"].as<bool>() == true);
+
+    request.body = "{not json";
+    BOOST_TEST(RestApi::handle(request, query, revision, token).status == 400u);
+
+    request.method = "DELETE";
+    BOOST_TEST(RestApi::handle(request, query, revision, token).status == 405u);
+}
+
+BOOST_AUTO_TEST_CASE(Bearer_Token_Is_Authorized_Once) {
+    int authorizations = 0;
+    std::string token;
+    RestApi::QueryHandler query = [&authorizations](jsoncons::json &request) {
+      if (request["action"].as<std::string>() == "authorize") {
+        authorizations++;
+      }
+      return jsoncons::json::parse(R"({"data":{}})");
+    };
+    RestApi::RevisionHandler revision = [](const std::string &) { return std::string(); };
+
+    RestApi::Request request;
+    request.method = "GET";
+    request.target = "/vss/Vehicle/Speed";
+    request.authorization = "Bearer abc";
+    RestApi::handle(request, query, revision, token);
+    RestApi::handle(request, query, revision, token);
+    BOOST_TEST(token == "abc");
+    BOOST_TEST(authorizations == 1);
+}
+
+BOOST_AUTO_TEST_CASE(Failed_Event_Stream_Subscription_Leaves_No_Subscription) {
+    std::vector<std::string> subscribed;
+    std::vector<std::string> unsubscribed;
+    RestApi::QueryHandler query = [&subscribed, &unsubscribed](jsoncons::json &request) {
+      std::string action = request["action"].as<std::string>();
+      if (action == "unsubscribe") {
+        unsubscribed.push_back(request["subscriptionId"].as<std::string>());
+        return jsoncons::json::parse("{}");
+      }
+      if (request["path"].as<std::string>() == "Vehicle/Unknown") {
+        return jsoncons::json::parse(R"({"error":{"number":404,"reason":"Path not found"}})");
+      }
+      subscribed.push_back(request["path"].as<std::string>());
+      jsoncons::json response;
+      response["subscriptionId"] = "sub-" + request["path"].as<std::string>();
+      return response;
+    };
+
+    std::string token;
+    std::vector<std::string> ids;
+    RestApi::Request request;
+    request.method = "GET";
+    request.target = "/vss?path=Vehicle/Speed&path=Vehicle/Width";
+    BOOST_TEST(RestApi::subscribe(request, query, token, ids).status == 200u);
+    BOOST_TEST(ids.size() == 2u);
+    BOOST_TEST(ids[0] == "sub-Vehicle/Speed");
+
+    ids.clear();
+    request.target = "/vss?path=Vehicle/Speed&path=Vehicle/Unknown";
+    BOOST_TEST(RestApi::subscribe(request, query, token, ids).status == 404u);
+    BOOST_TEST(ids.empty());
+    BOOST_TEST(unsubscribed.size() == 1u);
+    BOOST_TEST(unsubscribed[0] == "sub-Vehicle/Speed");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,195 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#include <turtle/mock.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ILoggerMock.hpp"
+#include "IVssDatabaseMock.hpp"
+#include "ShmIngestor.hpp"
+#include "ShmRing.hpp"
+#include "VSSPath.hpp"
+
+namespace {
+  /// unique per test process, tests may run in parallel
+  std::string feederName(const std::string &test) {
+    return "unit-test-" + std::to_string(getpid()) + "-" + test;
+  }
+
+  ShmRing::Value doubleValue(double d) {
+    ShmRing::Value value;
+    value.d = d;
+    return value;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( ShmIngestorTests )
+
+BOOST_AUTO_TEST_CASE(Values_Are_Set_In_Order) {
+    auto logMock = std::make_shared<ILoggerMock>();
+    auto dbMock = std::make_shared<IVssDatabaseMock>();
+    MOCK_EXPECT(logMock->Log);
+    VSSPath speed = VSSPath::fromVSS("Vehicle.Speed");
+    MOCK_EXPECT(dbMock->pathExists).once().with(speed).returns(true);
+    MOCK_EXPECT(dbMock->pathIsWritable).once().with(speed).returns(true);
+
+    ShmIngestor ingestor(logMock, dbMock);
+    ingestor.addFeeder(feederName("order"), 16, 4);
+    ShmRing::Producer producer(feederName("order"));
+    uint32_t id = producer.signal("Vehicle.Speed");
+    BOOST_TEST(producer.signal("Vehicle.Speed") == id);
+
+    mock::sequence order;
+    MOCK_EXPECT(dbMock->setSignalValue).once().in(order).with(speed, "value", VssValue::fromDouble(10.5), 1u);
+    MOCK_EXPECT(dbMock->setSignalValue).once().in(order).with(speed, "value", VssValue::fromDouble(11.5), 2u);
+    BOOST_TEST(producer.push(id, ShmRing::ValueType::Double, doubleValue(10.5), 1));
+    BOOST_TEST(producer.push(id, ShmRing::ValueType::Double, doubleValue(11.5), 2));
+
+    BOOST_TEST(ingestor.drainOnce() == 2u);
+    BOOST_TEST(ingestor.drainOnce() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Feeder_Timestamp_Is_Applied) {
+    auto logMock = std::make_shared<ILoggerMock>();
+    auto dbMock = std::make_shared<IVssDatabaseMock>();
+    MOCK_EXPECT(logMock->Log);
+    VSSPath speed = VSSPath::fromVSS("Vehicle.Speed");
+    MOCK_EXPECT(dbMock->pathExists).returns(true);
+    MOCK_EXPECT(dbMock->pathIsWritable).returns(true);
+
+    ShmIngestor ingestor(logMock, dbMock);
+    ingestor.addFeeder(feederName("timestamp"), 16, 4);
+    ShmRing::Producer producer(feederName("timestamp"));
+    uint32_t id = producer.signal("Vehicle.Speed");
+
+    // passed on as is, 0 makes the database stamp the value
+    mock::sequence order;
+    MOCK_EXPECT(dbMock->setSignalValue).once().in(order).with(speed, "value", VssValue::fromDouble(1), 1500000000123456789u);
+    MOCK_EXPECT(dbMock->setSignalValue).once().in(order).with(speed, "value", VssValue::fromDouble(2), 0u);
+    producer.push(id, ShmRing::ValueType::Double, doubleValue(1), 1500000000123456789u);
+    producer.push(id, ShmRing::ValueType::Double, doubleValue(2), 0);
+
+    BOOST_TEST(ingestor.drainOnce() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(Full_Ring_Drops_Values) {
+    auto logMock = std::make_shared<ILoggerMock>();
+    auto dbMock = std::make_shared<IVssDatabaseMock>();
+    MOCK_EXPECT(logMock->Log);
+    MOCK_EXPECT(dbMock->pathExists).returns(true);
+    MOCK_EXPECT(dbMock->pathIsWritable).returns(true);
+    MOCK_EXPECT(dbMock->setSignalValue).exactly(4);
+
+    ShmIngestor ingestor(logMock, dbMock, 3);
+    ingestor.addFeeder(feederName("full"), 3, 4);
+    ShmRing::Producer producer(feederName("full"));
+    BOOST_TEST(producer.capacity() == 4u);
+    uint32_t id = producer.signal("Vehicle.Speed");
+    for (int i = 0; i < 4; i++) {
+      BOOST_TEST(producer.push(id, ShmRing::ValueType::Double, doubleValue(i), i));
+    }
+    BOOST_TEST(!producer.push(id, ShmRing::ValueType::Double, doubleValue(4), 4));
+    BOOST_TEST(producer.dropped() == 1u);
+
+    // batches are limited, the slots of a batch are free again afterwards
+    BOOST_TEST(ingestor.drainOnce() == 3u);
+    BOOST_TEST(producer.push(id, ShmRing::ValueType::Double, doubleValue(5), 5));
+    BOOST_TEST(ingestor.drainOnce() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(Unknown_Path_Is_Resolved_Once_And_Skipped) {
+    auto logMock = std::make_shared<ILoggerMock>();
+    auto dbMock = std::make_shared<IVssDatabaseMock>();
+    MOCK_EXPECT(logMock->Log);
+    MOCK_EXPECT(dbMock->pathExists).once().returns(false);
+    MOCK_EXPECT(dbMock->setSignalValue).never();
+
+    ShmIngestor ingestor(logMock, dbMock);
+    ingestor.addFeeder(feederName("unknown"), 16, 4);
+    ShmRing::Producer producer(feederName("unknown"));
+    uint32_t id = producer.signal("Vehicle.DoesNotExist");
+    producer.push(id, ShmRing::ValueType::Double, doubleValue(1), 1);
+    producer.push(id, ShmRing::ValueType::Double, doubleValue(2), 2);
+
+    BOOST_TEST(ingestor.drainOnce() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(Second_Producer_Is_Rejected) {
+    auto logMock = std::make_shared<ILoggerMock>();
+    auto dbMock = std::make_shared<IVssDatabaseMock>();
+    MOCK_EXPECT(logMock->Log);
+
+    ShmIngestor ingestor(logMock, dbMock);
+    ingestor.addFeeder(feederName("single"), 16, 4);
+    {
+      ShmRing::Producer producer(feederName("single"));
+      BOOST_CHECK_THROW(ShmRing::Producer second(feederName("single")), std::runtime_error);
+    }
+    // free again once the first one is gone
+    ShmRing::Producer producer(feederName("single"));
+    BOOST_CHECK_THROW(ShmRing::Producer(feederName("not-created")), std::system_error);
+    BOOST_CHECK_THROW(producer.signal(std::string(ShmRing::MaxPathLength, 'x')), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Layout_Overwritten_By_Feeder_Is_Ignored) {
+    auto logMock = std::make_shared<ILoggerMock>();
+    auto dbMock = std::make_shared<IVssDatabaseMock>();
+    MOCK_EXPECT(logMock->Log);
+    MOCK_EXPECT(dbMock->pathExists).returns(true);
+    MOCK_EXPECT(dbMock->pathIsWritable).returns(true);
+    MOCK_EXPECT(dbMock->setSignalValue).once().with(mock::any, "value", VssValue::fromDouble(1), 1u);
+
+    ShmIngestor ingestor(logMock, dbMock);
+    ingestor.addFeeder(feederName("layout"), 16, 4);
+    ShmRing::Producer producer(feederName("layout"));
+    uint32_t id = producer.signal("Vehicle.Speed");
+    BOOST_TEST(producer.push(id, ShmRing::ValueType::Double, doubleValue(1), 1));
+
+    // the feeder maps the segment writable and may write anything to it
+    int fd = shm_open(ShmRing::segmentName(feederName("layout")).c_str(), O_RDWR, 0);
+    BOOST_REQUIRE(fd >= 0);
+    size_t size = ShmRing::segmentSize(16, 4);
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    BOOST_REQUIRE(mapping != MAP_FAILED);
+    auto header = static_cast<ShmRing::Header*>(mapping);
+    header->capacity = 1u << 30;
+    header->signalCapacity = 1u << 30;
+    header->signalCount = 1u << 30;
+
+    BOOST_TEST(ingestor.drainOnce() == 1u);
+
+    // a head beyond the ring is skipped instead of being read
+    header->head = header->head.load() + 1000000;
+    BOOST_TEST(ingestor.drainOnce() == 0u);
+    munmap(mapping, size);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <turtle/mock.hpp>
+#undef BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ISubscriptionHandlerMock.hpp"
+#include "SseStream.hpp"
+
+namespace {
+  OutboundMessage update(const std::string &value) {
+    return OutboundMessage{"{\"data\":", std::make_shared<const std::string>(value), "}", "sub"};
+  }
+
+  SseStream::Sink collect(std::vector<std::string> &events) {
+    return [&events](std::shared_ptr<const std::string> event) { events.push_back(*event); };
+  }
+
+  std::function<bool(const KuksaChannel&)> channelOf(const std::shared_ptr<SseStream> &stream) {
+    ConnectionId connID = stream->connID();
+    return [connID](const KuksaChannel &channel) { return channel.getConnID() == connID; };
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( SseStreamTests )
+
+BOOST_AUTO_TEST_CASE(Event_Carries_Stream_Name_And_Sequence_Number) {
+    SseStream stream("s1", 4, std::chrono::seconds(30));
+    std::vector<std::string> events;
+    stream.attach(collect(events), 0);
+
+    BOOST_TEST(stream.publish(update("1")));
+    BOOST_TEST(stream.publish(update("2")));
+    BOOST_TEST(events.size() == 2u);
+    BOOST_TEST(events[0] == "id: s1-1\ndata: {\"data\":1}\n\n");
+    BOOST_TEST(events[1] == "id: s1-2\ndata: {\"data\":2}\n\n");
+
+    std::string name;
+    uint64_t seq = 0;
+    BOOST_TEST(SseStreamRegistry::parseEventId("a-b-c-17", name, seq));
+    BOOST_TEST(name == "a-b-c");
+    BOOST_TEST(seq == 17u);
+    BOOST_TEST(!SseStreamRegistry::parseEventId("abc-", name, seq));
+    BOOST_TEST(!SseStreamRegistry::parseEventId("abc-1x", name, seq));
+}
+
+BOOST_AUTO_TEST_CASE(Resumed_Stream_Replays_Missed_Events) {
+    SseStream stream("s1", 3, std::chrono::seconds(30));
+    std::vector<std::string> first;
+    uint64_t attachment = stream.attach(collect(first), 0);
+    stream.publish(update("1"));
+    stream.detach(attachment);
+
+    // events 2 to 5 are missed, only the last 3 are kept
+    for (int i = 2; i <= 5; i++) {
+      BOOST_TEST(stream.publish(update(std::to_string(i))));
+    }
+    BOOST_TEST(first.size() == 1u);
+
+    std::vector<std::string> second;
+    stream.attach(collect(second), 1);
+    BOOST_TEST(second.size() == 3u);
+    BOOST_TEST(second.front() == "id: s1-3\ndata: {\"data\":3}\n\n");
+
+    // a stale detach does not stop the new connection
+    stream.detach(attachment);
+    stream.publish(update("6"));
+    BOOST_TEST(second.size() == 4u);
+}
+
+BOOST_AUTO_TEST_CASE(Stream_Expires_After_Resume_Timeout) {
+    SseStream stream("s1", 3, std::chrono::seconds(0));
+    uint64_t attachment = stream.attach([](std::shared_ptr<const std::string>) {}, 0);
+    BOOST_TEST(stream.publish(update("1")));
+    BOOST_TEST(!stream.expired(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+
+    stream.detach(attachment);
+    BOOST_TEST(stream.expired(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+}
+
+BOOST_AUTO_TEST_CASE(Registry_Finds_Streams_By_Event_Id_And_Connection) {
+    ConnectionRegistry connections;
+    SseStreamRegistry registry(connections);
+    auto stream = registry.create();
+    auto other = registry.create();
+    BOOST_TEST(stream->connID() != other->connID());
+    BOOST_TEST(connections.find(stream->connID()) == stream);
+
+    uint64_t lastSeen = 0;
+    BOOST_TEST(registry.resume(stream->name() + "-12", lastSeen) == stream);
+    BOOST_TEST(lastSeen == 12u);
+    BOOST_TEST(registry.resume("unknown-12", lastSeen) == nullptr);
+
+    registry.remove(stream);
+    BOOST_TEST(connections.find(stream->connID()) == nullptr);
+    BOOST_TEST(registry.resume(stream->name() + "-12", lastSeen) == nullptr);
+    BOOST_TEST(connections.find(other->connID()) == other);
+}
+
+BOOST_AUTO_TEST_CASE(Expired_Streams_Are_Unsubscribed) {
+    ConnectionRegistry connections;
+    SseStreamRegistry registry(connections);
+    auto subHandler = std::make_shared<ISubscriptionHandlerMock>();
+    registry.setSubscriptionHandler(subHandler);
+    registry.configure(4, std::chrono::seconds(0));
+
+    auto attached = registry.create();
+    attached->attach([](std::shared_ptr<const std::string>) {}, 0);
+    // streams already expired would be dropped by create(), so created last
+    auto expiring = registry.create();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    MOCK_EXPECT(subHandler->unsubscribeAll).once().with(channelOf(expiring)).returns(0);
+    BOOST_TEST(registry.removeExpired() == 1u);
+    BOOST_TEST(connections.find(expiring->connID()) == nullptr);
+    BOOST_TEST(connections.find(attached->connID()) == attached);
+
+    // nothing left to sweep
+    BOOST_TEST(registry.removeExpired() == 0u);
+    mock::verify();
+
+    MOCK_EXPECT(subHandler->unsubscribeAll).once().with(channelOf(attached)).returns(0);
+    registry.remove(attached);
+    // removing twice does not unsubscribe twice
+    registry.remove(attached);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -34,7 +34,6 @@
 #include <set>
 #include <list>
 #include <thread>
-#include <fstream>
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
@@ -109,11 +108,6 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_SubscribeRequest_Shall_SubscribeCli
     .returns(true);
 
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   SubscriptionId res;
@@ -156,11 +150,6 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_SubscribeRequestOnDifferentPaths_Sh
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
@@ -211,11 +200,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_SubscribeRequestOnSinglePath_Sha
     .with(mock::any, vsspath)
     .returns(true);
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
@@ -274,11 +258,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_SubscribeRequestOnDifferentPaths
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   unsigned index = 0;
@@ -329,11 +308,6 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_UnsubscribeRequestOnDifferentPaths_
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
@@ -387,11 +361,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_Unsubscribe_Shall_UnsubscribeAll
     .with(mock::any, vsspath)
     .returns(true);
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
@@ -446,11 +415,6 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_MultipleSignalsSubscribedAndUpdated
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::map<unsigned, SubscriptionId> resMap;
@@ -537,11 +501,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   // subscribe every client to every signal
@@ -666,11 +625,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::vector<SubscriptionId> removedSubId;
@@ -734,4 +688,134 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
   BOOST_TEST(subHandler->publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, std::to_string(index))) == 0);
 }
 
+BOOST_AUTO_TEST_CASE(Given_SingleClient_When_BranchSubscribedAndSignalsUpdated_Shall_NotifyReadableSignalsOnly)
+{
+  KuksaChannel channel;
+  channel.setConnID(151515);
+
+  VSSPath branch = VSSPath::fromVSSGen1("Vehicle.Acceleration");
+  VSSPath readable = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+  VSSPath notReadable = VSSPath::fromVSSGen1("Vehicle.Acceleration.Lateral");
+  VSSPath outside = VSSPath::fromVSSGen1("Vehicle.Speed");
+
+  // expectations
+
+  MOCK_EXPECT(dbMock->pathExists)
+    .once()
+    .with(branch)
+    .returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable)
+    .once()
+    .with(branch)
+    .returns(false);
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .once()
+    .with(branch)
+    .returns(std::list<VSSPath>{notReadable, readable});
+  // checked once when subscribing, and for every published value
+  MOCK_EXPECT(accCheckMock->checkReadAccess)
+    .exactly(2)
+    .with(mock::any, notReadable)
+    .returns(false);
+  MOCK_EXPECT(accCheckMock->checkReadAccess)
+    .exactly(2)
+    .with(mock::any, readable)
+    .returns(true);
+
+  // verify
+
+  SubscriptionId subId;
+  BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(channel, dbMock, branch.getVSSGen1Path(), "value"));
+
+  auto jsonVerify = [&subId]( const std::string &actual ) {
+    jsoncons::json response = jsoncons::json::parse(actual);
+    return response["subscriptionId"].as<std::string>() == boost::uuids::to_string(subId);
+  };
+  MOCK_EXPECT(serverMock->SendToConnection)
+    .once()
+    .with(channel.getConnID(), jsonVerify)
+    .returns(true);
+
+  BOOST_TEST(subHandler->publishForVSSPath(readable, "float", "value", packDataInJson(readable, "1")) == 0);
+  BOOST_TEST(subHandler->publishForVSSPath(notReadable, "float", "value", packDataInJson(notReadable, "2")) == 0);
+  BOOST_TEST(subHandler->publishForVSSPath(outside, "float", "value", packDataInJson(outside, "3")) == 0);
+  usleep(10000); // allow for subthread handler to run
+
+  BOOST_TEST(subHandler->unsubscribe(subId) == 0);
+  BOOST_TEST(subHandler->unsubscribe(subId) == -1);
+}
+
+BOOST_AUTO_TEST_CASE(Given_SingleClient_When_OlderRevisionPublishedAfterNewer_Shall_DropOlderUpdate)
+{
+  KuksaChannel channel;
+  channel.setConnID(161616);
+  VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+
+  MOCK_EXPECT(dbMock->pathExists).once().with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable).once().with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).once().with(mock::any, vsspath).returns(true);
+
+  SubscriptionId subId;
+  BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(channel, dbMock, vsspath.getVSSPath(), "value"));
+
+  // sets of the signal raced, the older one is published last
+  auto newerValue = []( const std::string &actual ) {
+    jsoncons::json response = jsoncons::json::parse(actual);
+    return response["data"]["dp"]["value"].as<std::string>() == "2";
+  };
+  MOCK_EXPECT(serverMock->SendToConnection)
+    .once()
+    .with(channel.getConnID(), newerValue)
+    .returns(true);
+
+  BOOST_TEST(subHandler->publishForVSSPath(vsspath, "float", "value", packDataInJson(vsspath, "2"), 8) == 0);
+  BOOST_TEST(subHandler->publishForVSSPath(vsspath, "float", "value", packDataInJson(vsspath, "1"), 7) == 0);
+  usleep(10000); // allow for subthread handler to run
+
+  BOOST_TEST(subHandler->unsubscribe(subId) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(Given_SingleClient_When_AttributesPublishedOutOfRevisionOrder_Shall_NotifyBoth)
+{
+  KuksaChannel channel;
+  channel.setConnID(171717);
+  VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Body.Mirrors.DriverSide.Pan");
+
+  MOCK_EXPECT(dbMock->pathExists).exactly(2).with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable).exactly(2).with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).exactly(2).with(mock::any, vsspath).returns(true);
+
+  SubscriptionId valueSubId, targetSubId;
+  BOOST_CHECK_NO_THROW(valueSubId = subHandler->subscribe(channel, dbMock, vsspath.getVSSPath(), "value"));
+  BOOST_CHECK_NO_THROW(targetSubId = subHandler->subscribe(channel, dbMock, vsspath.getVSSPath(), "targetValue"));
+
+  // value and targetValue share the revision of the signal, a set of one
+  // does not overtake a set of the other
+  auto hasAttribute = []( const std::string &attr ) {
+    return [attr]( const std::string &actual ) {
+      jsoncons::json response = jsoncons::json::parse(actual);
+      return response["data"]["dp"].contains(attr);
+    };
+  };
+  MOCK_EXPECT(serverMock->SendToConnection)
+    .once()
+    .with(channel.getConnID(), hasAttribute("value"))
+    .returns(true);
+  MOCK_EXPECT(serverMock->SendToConnection)
+    .once()
+    .with(channel.getConnID(), hasAttribute("targetValue"))
+    .returns(true);
+
+  jsoncons::json targetData = packDataInJson(vsspath, "1");
+  targetData["dp"]["targetValue"] = targetData["dp"]["value"];
+  targetData["dp"].erase("value");
+
+  BOOST_TEST(subHandler->publishForVSSPath(vsspath, "int8", "value", packDataInJson(vsspath, "2"), 8) == 0);
+  BOOST_TEST(subHandler->publishForVSSPath(vsspath, "int8", "targetValue", targetData, 7) == 0);
+  usleep(10000); // allow for subthread handler to run
+
+  BOOST_TEST(subHandler->unsubscribe(valueSubId) == 0);
+  BOOST_TEST(subHandler->unsubscribe(targetSubId) == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
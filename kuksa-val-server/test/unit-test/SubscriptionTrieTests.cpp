@@ -0,0 +1,140 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "SubscriptionTrie.hpp"
+
+namespace {
+  // signals of the example tree in doc/wildcard_matching.md
+  const std::vector<std::string> Signals{
+    "Vehicle/Cabin/Sunroof/Position",
+    "Vehicle/Cabin/Sunroof/Shade/Position",
+    "Vehicle/Cabin/Sunroof/Shade/Switch",
+    "Vehicle/Cabin/Sunroof/Switch",
+    "Vehicle/Speed"
+  };
+
+  /** Signals matched by pattern, once using the trie and once using matches() */
+  std::vector<std::string> matchingSignals(const std::string &pattern) {
+    SubscriptionTrie trie;
+    trie.insert(SubscriptionTrie::split(pattern),
+                SubscriptionTrie::Entry{boost::uuids::random_generator()(), KuksaChannel(), true});
+
+    std::vector<std::string> result;
+    for (const auto &signal : Signals) {
+      std::vector<const SubscriptionTrie::Entry*> matches;
+      trie.match(SubscriptionTrie::split(signal), matches);
+      bool matched = SubscriptionTrie::matches(SubscriptionTrie::split(pattern), SubscriptionTrie::split(signal));
+      BOOST_TEST(matched == !matches.empty(), pattern + " on " + signal);
+      BOOST_TEST(matches.size() <= 1u);
+      if (matched) {
+        result.push_back(signal);
+      }
+    }
+    return result;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( SubscriptionTrieTests )
+
+BOOST_AUTO_TEST_CASE(Empty_Pattern_Matches_Everything) {
+    BOOST_TEST(matchingSignals("") == Signals);
+    BOOST_TEST(matchingSignals("Vehicle") == Signals);
+}
+
+BOOST_AUTO_TEST_CASE(Path_Matches_Signal_And_Signals_Below_Branch) {
+    std::vector<std::string> sunroof(Signals.begin(), Signals.begin() + 4);
+    BOOST_TEST(matchingSignals("Vehicle/Cabin/Sunroof") == sunroof);
+    BOOST_TEST(matchingSignals("Vehicle/Speed") == std::vector<std::string>{"Vehicle/Speed"});
+    BOOST_TEST(matchingSignals("Vehicle/Cabin/Sun").empty());
+    BOOST_TEST(matchingSignals("Sunroof").empty());
+}
+
+BOOST_AUTO_TEST_CASE(Single_Asterisk_Matches_One_Element) {
+    BOOST_TEST(matchingSignals("Vehicle/Cabin/Sunroof/*") ==
+               (std::vector<std::string>{"Vehicle/Cabin/Sunroof/Position", "Vehicle/Cabin/Sunroof/Switch"}));
+    BOOST_TEST(matchingSignals("Vehicle/Cabin/Sunroof/*/Position") ==
+               std::vector<std::string>{"Vehicle/Cabin/Sunroof/Shade/Position"});
+    BOOST_TEST(matchingSignals("*/*/*/*/Position") ==
+               std::vector<std::string>{"Vehicle/Cabin/Sunroof/Shade/Position"});
+    BOOST_TEST(matchingSignals("*/Sunroof").empty());
+}
+
+BOOST_AUTO_TEST_CASE(Double_Asterisk_Matches_Any_Depth) {
+    std::vector<std::string> sunroof(Signals.begin(), Signals.begin() + 4);
+    BOOST_TEST(matchingSignals("Vehicle/Cabin/Sunroof/**") == sunroof);
+    BOOST_TEST(matchingSignals("**/Sunroof/**") == sunroof);
+    BOOST_TEST(matchingSignals("Vehicle/Cabin/Sunroof/**/Position") ==
+               (std::vector<std::string>{"Vehicle/Cabin/Sunroof/Position", "Vehicle/Cabin/Sunroof/Shade/Position"}));
+    BOOST_TEST(matchingSignals("**/Sunroof/*/Position") ==
+               std::vector<std::string>{"Vehicle/Cabin/Sunroof/Shade/Position"});
+    BOOST_TEST(matchingSignals("**/Sunroof").empty());
+}
+
+BOOST_AUTO_TEST_CASE(Match_Reports_Each_Subscription_Once) {
+    SubscriptionTrie trie;
+    auto id = boost::uuids::random_generator()();
+    // "**/**" can match the same signal in many ways
+    trie.insert(SubscriptionTrie::split("**/**"), SubscriptionTrie::Entry{id, KuksaChannel(), true});
+    trie.insert(SubscriptionTrie::split("Vehicle/Speed"), SubscriptionTrie::Entry{id, KuksaChannel(), false});
+
+    std::vector<const SubscriptionTrie::Entry*> matches;
+    trie.match(SubscriptionTrie::split("Vehicle/Cabin/Sunroof/Shade/Position"), matches);
+    BOOST_TEST(matches.size() == 1u);
+    matches.clear();
+    trie.match(SubscriptionTrie::split("Vehicle/Speed"), matches);
+    BOOST_TEST(matches.size() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(Remove_Only_Removes_Entry_Of_Given_Pattern) {
+    SubscriptionTrie trie;
+    auto id = boost::uuids::random_generator()();
+    auto other = boost::uuids::random_generator()();
+    const std::vector<std::string> patterns{"Vehicle/Speed", "Vehicle/*", "**/Speed", "Vehicle/**"};
+    for (const auto &pattern : patterns) {
+      trie.insert(SubscriptionTrie::split(pattern), SubscriptionTrie::Entry{id, KuksaChannel(), true});
+    }
+    trie.insert(SubscriptionTrie::split("Vehicle/Speed"), SubscriptionTrie::Entry{other, KuksaChannel(), false});
+
+    BOOST_TEST(trie.remove(SubscriptionTrie::split("Vehicle/Cabin"), id) == false);
+    BOOST_TEST(trie.remove(SubscriptionTrie::split("Vehicle/Speed"), other));
+    BOOST_TEST(trie.remove(SubscriptionTrie::split("Vehicle/Speed"), other) == false);
+
+    std::vector<const SubscriptionTrie::Entry*> matches;
+    trie.match(SubscriptionTrie::split("Vehicle/Speed"), matches);
+    BOOST_TEST(matches.size() == patterns.size());
+
+    for (const auto &pattern : patterns) {
+      BOOST_TEST(trie.remove(SubscriptionTrie::split(pattern), id), pattern);
+    }
+    BOOST_TEST(trie.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -356,6 +356,57 @@ BOOST_AUTO_TEST_CASE(Given_ValidGetQuery_When_NoValueFromDB_Shall_ReturnError)
   BOOST_TEST(res == jsonPathNotFound);
 }
 
+BOOST_AUTO_TEST_CASE(Given_RevisionTagRequest_When_UserAuthorized_Shall_ReturnRevision)
+{
+  KuksaChannel channel;
+  std::string path{"Vehicle.Speed"};
+  VSSPath path2 = VSSPath::fromVSS(path);
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::HTTP_PLAIN);
+
+  // expectations
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .with(mock::equal(path2))
+    .returns(std::list<VSSPath>{path2});
+  MOCK_EXPECT(accCheckMock->checkReadAccess)
+    .once()
+    .with(mock::any, mock::equal(path2))
+    .returns(true);
+  MOCK_EXPECT(dbMock->getRevision)
+    .once()
+    .with(mock::equal(path2))
+    .returns(VssRevision{3, 42});
+
+  // run UUT and verify
+  BOOST_TEST(processor->getRevisionTag(channel, path) == "3.42");
+}
+
+BOOST_AUTO_TEST_CASE(Given_RevisionTagRequest_When_UserNotAuthorized_Shall_ReturnEmptyTag)
+{
+  KuksaChannel channel;
+  std::string path{"Vehicle.Speed"};
+  VSSPath path2 = VSSPath::fromVSS(path);
+
+  channel.setAuthorized(false);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::HTTP_PLAIN);
+
+  // expectations
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .with(mock::equal(path2))
+    .returns(std::list<VSSPath>{path2});
+  MOCK_EXPECT(accCheckMock->checkReadAccess)
+    .once()
+    .with(mock::any, mock::equal(path2))
+    .returns(false);
+  MOCK_EXPECT(dbMock->getRevision).never();
+
+  // run UUT and verify
+  BOOST_TEST(processor->getRevisionTag(channel, path).empty());
+}
+
 ///////////////////////////
 // Test SET handling
 
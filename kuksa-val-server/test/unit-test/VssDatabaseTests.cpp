@@ -26,6 +26,7 @@
 
 #include "UnitTestHelpers.hpp"
 
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -37,6 +38,14 @@
 
 #include "VssDatabase.hpp"
 
+// Grants the tests access to the model a reader of the database holds
+class w3cunittest {
+  public:
+    static std::shared_ptr<const VssDatabase::VssModel> currentModel(VssDatabase& database) {
+      return database.currentModel();
+    }
+};
+
 namespace {
   // common resources for tests
   std::string validFilename{"test_vss_release_latest.json"};
@@ -234,7 +243,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidVssFilenameAndChannelAuthorized_When_SetSingleSi
 
   MOCK_EXPECT(subHandlerMock->publishForVSSPath)
     .at_least(1)
-    .with(mock::any, "float", "value", mock::any)
+    .with(mock::any, "float", "value", mock::any, mock::any)
     .returns(0);
 
   // verify
@@ -256,7 +265,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidVssFilenameAndChannelAuthorized_When_SetSingleSi
   setValue = 10;
 
   // verify
-  MOCK_EXPECT(subHandlerMock->publishForVSSPath).with(mock::any, "float", "value", mock::any).returns(0);
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).with(mock::any, "float", "value", mock::any, mock::any).returns(0);
 
   BOOST_CHECK_NO_THROW(db->setSignal(signalPath, "value", setValue));
 
@@ -265,6 +274,239 @@ BOOST_AUTO_TEST_CASE(Given_ValidVssFilenameAndChannelAuthorized_When_SetSingleSi
 }
 
 
+BOOST_AUTO_TEST_CASE(Given_ValidVssFilename_When_TreeUpdated_Shall_ResolveNewPaths) {
+  KuksaChannel channel;
+  channel.setConnID(11);
+  channel.enableModifyTree();
+
+  // setup
+  db->initJsonTree(validFilename);
+  VSSPath newPath = VSSPath::fromVSSGen1("Vehicle.Private.ThrustersActive");
+  BOOST_TEST(db->pathExists(newPath) == false);
+
+  jsoncons::json newTree = jsoncons::json::parse(R"({
+    "Vehicle": {
+      "type": "branch",
+      "children": {
+        "Private": {
+          "type": "branch",
+          "children": {
+            "ThrustersActive": { "datatype": "boolean", "type": "actuator" }
+          }
+        }
+      }
+    }
+  })");
+
+  // verify
+
+  BOOST_CHECK_NO_THROW(db->updateJsonTree(channel, newTree));
+  BOOST_TEST(db->pathExists(newPath) == true);
+  BOOST_TEST(db->pathIsWritable(newPath) == true);
+  BOOST_TEST(db->pathIsAttributable(newPath, "targetValue") == true);
+  BOOST_TEST(db->getDatatypeForPath(newPath) == "boolean");
+  BOOST_TEST(db->getLeafPaths(VSSPath::fromVSSGen1("Vehicle.Private")).size() == 1);
+
+  // already existing signals still need to be resolvable, also via wildcards
+  BOOST_TEST(db->pathIsReadable(VSSPath::fromVSSGen1("Vehicle.Speed")) == true);
+  BOOST_TEST(db->pathExists(VSSPath::fromVSSGen1("Vehicle.*.ThrustersActive")) == true);
+  BOOST_TEST(db->pathIsReadable(VSSPath::fromVSSGen1("Vehicle.*.ThrustersActive")) == true);
+}
+
+BOOST_AUTO_TEST_CASE(Given_SetSignal_When_TreeUpdated_Shall_KeepValueOutOfMetadata) {
+  KuksaChannel channel;
+  channel.setConnID(11);
+  channel.enableModifyTree();
+
+  // setup
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSSGen1("Vehicle.Speed");
+  jsoncons::json setValue, returnJson;
+  setValue = 50;
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).with(mock::any, "float", "value", mock::any, mock::any).returns(0);
+  BOOST_CHECK_NO_THROW(db->setSignal(signalPath, "value", setValue));
+
+  jsoncons::json newTree = jsoncons::json::parse(R"({
+    "Vehicle": { "type": "branch", "children": { "Speed": { "max": 9100 } } }
+  })");
+  BOOST_CHECK_NO_THROW(db->updateJsonTree(channel, newTree));
+
+  // verify
+
+  BOOST_CHECK_NO_THROW(returnJson = db->getSignal(signalPath, "value"));
+  BOOST_TEST(returnJson["dp"]["value"].as<float>() == 50);
+  BOOST_TEST(returnJson["dp"]["ts_s"].as<uint64_t>() > 0u);
+
+  BOOST_CHECK_NO_THROW(returnJson = db->getMetaData(signalPath));
+  jsoncons::json speedMeta = returnJson["Vehicle"]["children"]["Speed"];
+  BOOST_TEST(speedMeta["max"].as<int>() == 9100);
+  BOOST_TEST(speedMeta.contains("value") == false);
+  BOOST_TEST(speedMeta.contains("ts_s-value") == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_CompiledTree_When_InitCompiledTree_Shall_RestoreDefaultsOnly) {
+  KuksaChannel channel;
+  channel.setConnID(11);
+  channel.enableModifyTree();
+
+  // setup
+  db->initJsonTree(validFilename);
+  jsoncons::json overlay = jsoncons::json::parse(R"({
+    "Vehicle": { "type": "branch", "children": {
+      "Private": { "type": "branch", "children": {
+        "Paint": { "datatype": "string", "type": "attribute", "default": "blue" }
+      } }
+    } }
+  })");
+  db->updateJsonTree(channel, overlay);
+
+  jsoncons::json setValue = 50;
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).with(mock::any, "float", "value", mock::any, mock::any).returns(0);
+  db->setSignal(VSSPath::fromVSSGen1("Vehicle.Speed"), "value", setValue);
+
+  // verify
+
+  jsoncons::json compiled = db->getCompiledTree();
+  BOOST_TEST(compiled["Vehicle"]["children"]["Private"]["children"]["Paint"]["value"].as<std::string>() == "blue");
+  BOOST_TEST(compiled["Vehicle"]["children"]["Speed"].contains("value") == false);
+
+  auto restoredDb = std::make_unique<VssDatabase>(logMock, subHandlerMock);
+  BOOST_CHECK_NO_THROW(restoredDb->initCompiledTree(compiled));
+
+  jsoncons::json returnJson;
+  BOOST_CHECK_NO_THROW(returnJson = restoredDb->getSignal(VSSPath::fromVSSGen1("Vehicle.Private.Paint"), "value"));
+  BOOST_TEST(returnJson["dp"]["value"].as<std::string>() == "blue");
+  BOOST_CHECK_THROW(restoredDb->getSignal(VSSPath::fromVSSGen1("Vehicle.Speed"), "value"), notSetException);
+  BOOST_TEST(restoredDb->getMetaData(VSSPath::fromVSSGen1("Vehicle.Speed")) == db->getMetaData(VSSPath::fromVSSGen1("Vehicle.Speed")));
+}
+
+BOOST_AUTO_TEST_CASE(Given_ModelInUse_When_TreeUpdated_Shall_KeepModelUnchanged) {
+  KuksaChannel channel;
+  channel.setConnID(11);
+  channel.enableModifyTree();
+
+  // setup
+  db->initJsonTree(validFilename);
+  auto model = w3cunittest::currentModel(*db);
+  jsoncons::json treeBefore = model->tree;
+  size_t indexBefore = model->index.size();
+
+  jsoncons::json newTree = jsoncons::json::parse(R"({
+    "Vehicle": { "type": "branch", "children": {
+      "Private": { "type": "branch", "children": {
+        "ThrustersActive": { "datatype": "boolean", "type": "actuator" }
+      } },
+      "Speed": { "max": 9100 }
+    } }
+  })");
+  BOOST_CHECK_NO_THROW(db->updateJsonTree(channel, newTree));
+
+  // verify
+
+  // a reader that took the model before the update still sees the old tree
+  BOOST_TEST(model->tree == treeBefore);
+  BOOST_TEST(model->index.size() == indexBefore);
+  BOOST_TEST(model->index.count("Vehicle/Private/ThrustersActive") == 0u);
+  BOOST_TEST(model->tree["Vehicle"]["children"]["Speed"].contains("max") == false);
+
+  auto updated = w3cunittest::currentModel(*db);
+  BOOST_TEST(updated != model);
+  BOOST_TEST(updated->index.count("Vehicle/Private/ThrustersActive") == 1u);
+  BOOST_TEST(updated->tree["Vehicle"]["children"]["Speed"]["max"].as<int>() == 9100);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ModelInUse_When_MetadataUpdated_Shall_KeepModelUnchanged) {
+  KuksaChannel channel;
+  channel.setConnID(11);
+  channel.enableModifyTree();
+
+  // setup
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+  auto model = w3cunittest::currentModel(*db);
+  jsoncons::json treeBefore = model->tree;
+
+  jsoncons::json newMetaData = jsoncons::json::parse(R"({"bla":"blu","datatype":"int64"})");
+  BOOST_CHECK_NO_THROW(db->updateMetaData(channel, signalPath, newMetaData));
+
+  // verify
+
+  BOOST_TEST(model->tree == treeBefore);
+  const jsoncons::json* oldNode = model->index.at("Vehicle/Acceleration/Vertical").node;
+  BOOST_TEST((*oldNode)["datatype"].as<std::string>() == "float");
+  BOOST_TEST((model->index.at("Vehicle/Acceleration/Vertical").type == VssValue::Type::FLOAT));
+
+  auto updated = w3cunittest::currentModel(*db);
+  const jsoncons::json* newNode = updated->index.at("Vehicle/Acceleration/Vertical").node;
+  BOOST_TEST((*newNode)["datatype"].as<std::string>() == "int64");
+  BOOST_TEST((updated->index.at("Vehicle/Acceleration/Vertical").type == VssValue::Type::INT64));
+}
+
+BOOST_AUTO_TEST_CASE(Given_SetSignal_When_ModelRepublished_Shall_KeepValue) {
+  KuksaChannel channel;
+  channel.setConnID(11);
+  channel.enableModifyTree();
+
+  // setup
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSSGen1("Vehicle.Speed");
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).returns(0);
+  db->setSignalValue(signalPath, "value", VssValue::fromFloat(42.0f));
+  VssValueSlot before = db->getSignalValue(signalPath, "value");
+  auto model = w3cunittest::currentModel(*db);
+
+  jsoncons::json newMetaData = jsoncons::json::parse(R"({"max":9100})");
+  BOOST_CHECK_NO_THROW(db->updateMetaData(channel, signalPath, newMetaData));
+  jsoncons::json newTree = jsoncons::json::parse(R"({
+    "Vehicle": { "type": "branch", "children": { "Speed": { "min": -10 } } }
+  })");
+  BOOST_CHECK_NO_THROW(db->updateJsonTree(channel, newTree));
+
+  // verify
+
+  // the signal keeps its value slot, so value and timestamp carry over
+  auto updated = w3cunittest::currentModel(*db);
+  BOOST_TEST(updated != model);
+  BOOST_TEST(updated->index.at("Vehicle/Speed").id == model->index.at("Vehicle/Speed").id);
+
+  VssValueSlot after = db->getSignalValue(signalPath, "value");
+  BOOST_TEST((after.value == VssValue::fromFloat(42.0f)));
+  BOOST_TEST(after.ts_s == before.ts_s);
+  BOOST_TEST(after.ts_ns == before.ts_ns);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidVssFilename_When_TreeUpdated_Shall_IncreaseRevision) {
+  KuksaChannel channel;
+  channel.setConnID(11);
+  channel.enableModifyTree();
+
+  // setup
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSSGen1("Vehicle.Speed");
+  VSSPath otherPath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+  VssRevision signalRevision = db->getRevision(signalPath);
+  VssRevision otherRevision = db->getRevision(otherPath);
+
+  jsoncons::json newTree = jsoncons::json::parse(R"({
+    "Vehicle": { "type": "branch", "children": { "Speed": { "max": 9100 } } }
+  })");
+  BOOST_CHECK_NO_THROW(db->updateJsonTree(channel, newTree));
+
+  // verify
+
+  // metadata of every node, and the signals a path covers, may have
+  // changed, so every revision changes. Values did not
+  VssRevision updatedSignalRevision = db->getRevision(signalPath);
+  BOOST_TEST(updatedSignalRevision.tree > signalRevision.tree);
+  BOOST_TEST(updatedSignalRevision.values == signalRevision.values);
+  BOOST_TEST(db->getRevision(otherPath).tree > otherRevision.tree);
+
+  jsoncons::json newMetaData = jsoncons::json::parse(R"({"min":-10})");
+  BOOST_CHECK_NO_THROW(db->updateMetaData(channel, signalPath, newMetaData));
+  BOOST_TEST(db->getRevision(signalPath).tree > updatedSignalRevision.tree);
+}
+
 /*********************** isActor() tests ************************/
 BOOST_AUTO_TEST_CASE(Check_IsActor_ForActor) {
     std::string inputJsonString{R"({
@@ -485,6 +727,29 @@ BOOST_AUTO_TEST_CASE(applyDefaultValues_Recurse) {
 }
 
 
+BOOST_AUTO_TEST_CASE(Given_ValidVssFilename_When_SetSignal_Shall_IncreaseRevisionOfSignalAndBranch) {
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+  VSSPath siblingPath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Lateral");
+  VSSPath branchPath = VSSPath::fromVSSGen1("Vehicle.Acceleration");
+
+  jsoncons::json setValue = 10;
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).returns(0);
+
+  VssRevision signalRevision = db->getRevision(signalPath);
+  VssRevision siblingRevision = db->getRevision(siblingPath);
+  VssRevision branchRevision = db->getRevision(branchPath);
+
+  db->setSignal(signalPath, "value", setValue);
+
+  BOOST_TEST(db->getRevision(signalPath).values > signalRevision.values);
+  BOOST_TEST(db->getRevision(siblingPath).values == siblingRevision.values);
+  BOOST_TEST(db->getRevision(branchPath).values > branchRevision.values);
+  // the tree did not change
+  BOOST_TEST(db->getRevision(branchPath).tree == branchRevision.tree);
+  BOOST_CHECK_THROW(db->getRevision(VSSPath::fromVSS("Vehicle/FluxCapacitor")), noPathFoundonTree);
+}
+
 /** getDataTypeTests **/
 BOOST_AUTO_TEST_CASE(getDataTypeForSensor) {
   db->initJsonTree(validFilename);
@@ -519,4 +784,100 @@ BOOST_AUTO_TEST_CASE(getDataTypeForNonExistingPath) {
   BOOST_CHECK_THROW(db->getDatatypeForPath(VSSPath::fromVSS(path)), noPathFoundonTree);
 }
 
+/** Typed set and get **/
+BOOST_AUTO_TEST_CASE(Given_NativeValue_When_SetSignalValue_Shall_ConvertToDatatype) {
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSS("Vehicle.Body.Mirrors.DriverSide.Pan");
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).once().with(signalPath, "int8", "value", mock::any, mock::any).returns(0);
+  BOOST_CHECK_NO_THROW(db->setSignalValue(signalPath, "value", VssValue::fromUInt64(42, VssValue::Type::UINT32),
+                                          1500000000123456789u));
+
+  VssValueSlot slot = db->getSignalValue(signalPath, "value");
+  BOOST_TEST((slot.value == VssValue::fromInt64(42, VssValue::Type::INT8)));
+  BOOST_TEST(slot.ts_s == 1500000000u);
+  BOOST_TEST(slot.ts_ns == 123456789u);
+  // visible to JSON clients as well
+  BOOST_TEST(db->getSignal(signalPath, "value")["dp"]["value"].as<int>() == 42);
+}
+
+BOOST_AUTO_TEST_CASE(Given_NativeValue_When_OutOfLimits_Shall_Throw) {
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSS("Vehicle.Body.Mirrors.DriverSide.Pan");
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).never();
+  // beyond the max of the signal
+  BOOST_CHECK_THROW(db->setSignalValue(signalPath, "value", VssValue::fromInt64(101)), outOfBoundException);
+  // beyond the range of int8
+  BOOST_CHECK_THROW(db->setSignalValue(signalPath, "value", VssValue::fromInt64(-300)), outOfBoundException);
+  BOOST_CHECK_THROW(db->setSignalValue(signalPath, "value", VssValue::fromDouble(1e10)), outOfBoundException);
+  BOOST_CHECK_THROW(db->setSignalValue(signalPath, "value", VssValue::fromBool(true)), outOfBoundException);
+  BOOST_CHECK_THROW(db->setSignalValue(signalPath, "value", VssValue()), outOfBoundException);
+  BOOST_CHECK_THROW(db->setSignalValue(VSSPath::fromVSS("Vehicle.Speed"), "value",
+                                       VssValue::fromDouble(std::numeric_limits<double>::infinity())),
+                    outOfBoundException);
+  BOOST_CHECK_THROW(db->setSignalValue(VSSPath::fromVSS("Vehicle.Body.Lights.LightSwitch"), "value",
+                                       VssValue::fromString("DISCO")),
+                    outOfBoundException);
+  BOOST_CHECK_THROW(db->getSignalValue(signalPath, "value"), notSetException);
+}
+
+BOOST_AUTO_TEST_CASE(Given_NativeValue_When_PathNotWritable_Shall_Throw) {
+  db->initJsonTree(validFilename);
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).never();
+  BOOST_CHECK_THROW(db->setSignalValue(VSSPath::fromVSS("Vehicle.FluxCapacitor"), "value", VssValue::fromBool(true)),
+                    noPathFoundonTree);
+  BOOST_CHECK_THROW(db->setSignalValue(VSSPath::fromVSS("Vehicle.Body"), "value", VssValue::fromBool(true)),
+                    noPermissionException);
+  BOOST_CHECK_THROW(db->setSignalValue(VSSPath::fromVSS("Vehicle.VehicleIdentification.VIN"), "value",
+                                       VssValue::fromString("1234")),
+                    noPermissionException);
+  // only actuators have target values
+  BOOST_CHECK_THROW(db->setSignalValue(VSSPath::fromVSS("Vehicle.Speed"), "targetValue", VssValue::fromFloat(1)),
+                    noPermissionException);
+  BOOST_CHECK_THROW(db->getSignalValue(VSSPath::fromVSS("Vehicle.FluxCapacitor"), "value"), noPathFoundonTree);
+}
+
+BOOST_AUTO_TEST_CASE(Given_BranchOrWildcard_When_GetSignalValue_Shall_Throw) {
+  db->initJsonTree(validFilename);
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).returns(0);
+  db->setSignalValue(VSSPath::fromVSS("Vehicle.Body.Mirrors.DriverSide.Pan"), "value", VssValue::fromInt64(1));
+  db->setSignalValue(VSSPath::fromVSS("Vehicle.Body.Mirrors.DriverSide.Tilt"), "value", VssValue::fromInt64(2));
+
+  BOOST_CHECK_THROW(db->getSignalValue(VSSPath::fromVSS("Vehicle.Body.Mirrors.DriverSide.*"), "value"),
+                    notValidException);
+  BOOST_CHECK_THROW(db->getSignalValue(VSSPath::fromVSS("Vehicle.Body.Mirrors.DriverSide"), "value"),
+                    notValidException);
+  BOOST_TEST((db->getSignalValue(VSSPath::fromVSS("Vehicle.Body.Mirrors.DriverSide.Tilt"), "value").value ==
+              VssValue::fromInt64(2, VssValue::Type::INT8)));
+}
+
+BOOST_AUTO_TEST_CASE(Given_NativeString_When_SetSignalValue_Shall_AcceptAllowedValue) {
+  db->initJsonTree(validFilename);
+  VSSPath signalPath = VSSPath::fromVSS("Vehicle.Body.Lights.LightSwitch");
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).once().with(signalPath, "string", "targetValue", mock::any, mock::any).returns(0);
+  BOOST_CHECK_NO_THROW(db->setSignalValue(signalPath, "targetValue", VssValue::fromString("AUTO")));
+
+  BOOST_TEST((db->getSignalValue(signalPath, "targetValue").value == VssValue::fromString("AUTO")));
+  BOOST_TEST(db->getSignalValue(signalPath, "targetValue").ts_s > 0u);
+  BOOST_CHECK_THROW(db->getSignalValue(signalPath, "value"), notSetException);
+}
+
+BOOST_AUTO_TEST_CASE(Given_Path_When_GetNodeMetaData_Shall_ReturnNodeWithoutChildren) {
+  db->initJsonTree(validFilename);
+
+  jsoncons::json meta = db->getNodeMetaData(VSSPath::fromVSS("Vehicle.Speed"));
+  BOOST_TEST(meta["datatype"].as<std::string>() == "float");
+  BOOST_TEST(meta["type"].as<std::string>() == "sensor");
+
+  meta = db->getNodeMetaData(VSSPath::fromVSS("Vehicle.Body"));
+  BOOST_TEST(meta["type"].as<std::string>() == "branch");
+  BOOST_TEST(!meta.contains("children"));
+
+  BOOST_CHECK_THROW(db->getNodeMetaData(VSSPath::fromVSS("Vehicle.FluxCapacitor")), noPathFoundonTree);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <turtle/mock.hpp>
+#undef BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+#include <boost/filesystem.hpp>
+#include <jsoncons/json.hpp>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "ILoggerMock.hpp"
+#include "VssModelCache.hpp"
+
+namespace {
+  std::shared_ptr<ILoggerMock> logMock;
+  boost::filesystem::path cacheDir;
+
+  const char *modelJson = R"({
+    "Vehicle": { "type": "branch", "children": {
+      "Speed": { "datatype": "float", "type": "sensor", "min": 0, "max": 250 },
+      "Paint": { "datatype": "string", "type": "attribute", "default": "blue", "value": "blue",
+                 "allowed": ["blue", "red"] }
+    } }
+  })";
+
+  struct TestSuiteFixture {
+    TestSuiteFixture() {
+      logMock = std::make_shared<ILoggerMock>();
+      MOCK_EXPECT(logMock->Log).at_least(0); // ignore log events
+      cacheDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    }
+    ~TestSuiteFixture() {
+      boost::filesystem::remove_all(cacheDir);
+      logMock.reset();
+    }
+  };
+
+  boost::filesystem::path writeFile(const std::string &name, const std::string &content) {
+    boost::filesystem::create_directories(cacheDir);
+    auto file = cacheDir / name;
+    std::ofstream os(file.string());
+    os << content;
+    return file;
+  }
+}
+
+BOOST_FIXTURE_TEST_SUITE(VssModelCacheTests, TestSuiteFixture)
+
+BOOST_AUTO_TEST_CASE(Given_StoredModel_When_LoadWithSameHash_Shall_ReturnModel) {
+  VssModelCache cache(logMock, cacheDir);
+  jsoncons::json model = jsoncons::json::parse(modelJson);
+  jsoncons::json loaded;
+
+  cache.store(42, model);
+
+  BOOST_TEST(cache.load(42, loaded) == true);
+  BOOST_TEST(loaded == model);
+}
+
+BOOST_AUTO_TEST_CASE(Given_StoredModel_When_LoadWithOtherHash_Shall_Fail) {
+  VssModelCache cache(logMock, cacheDir);
+  jsoncons::json loaded;
+
+  cache.store(42, jsoncons::json::parse(modelJson));
+
+  BOOST_TEST(cache.load(43, loaded) == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_NoCache_When_Load_Shall_Fail) {
+  VssModelCache cache(logMock, cacheDir);
+  jsoncons::json loaded;
+
+  BOOST_TEST(cache.load(42, loaded) == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_CorruptCache_When_Load_Shall_Fail) {
+  VssModelCache cache(logMock, cacheDir);
+  jsoncons::json loaded;
+
+  writeFile(cache.cacheFile().filename().string(), "KUKSAVSS but not a valid cache");
+
+  BOOST_TEST(cache.load(42, loaded) == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ModelFiles_When_ContentChanges_Shall_ChangeHash) {
+  auto vss = writeFile("vss.json", modelJson);
+  auto overlay = writeFile("overlay.json", "{}");
+
+  uint64_t hash = VssModelCache::hashFiles({vss, overlay});
+  BOOST_TEST(VssModelCache::hashFiles({vss, overlay}) == hash);
+  BOOST_TEST(VssModelCache::hashFiles({vss}) != hash);
+
+  writeFile("overlay.json", R"({"Vehicle": {}})");
+  BOOST_TEST(VssModelCache::hashFiles({vss, overlay}) != hash);
+}
+
+BOOST_AUTO_TEST_CASE(Given_MissingModelFile_When_Hashing_Shall_Throw) {
+  BOOST_CHECK_THROW(VssModelCache::hashFiles({cacheDir / "missing.json"}), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <jsoncons/json.hpp>
+
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "VssValueStore.hpp"
+
+
+BOOST_AUTO_TEST_SUITE( VssValueStoreTests )
+
+BOOST_AUTO_TEST_CASE(Default_Value_Is_Not_Set) {
+    VssValue v;
+    BOOST_TEST(v.isSet() == false);
+    BOOST_TEST(v.type() == VssValue::Type::NONE);
+}
+
+BOOST_AUTO_TEST_CASE(Typed_Unsigned_Roundtrip) {
+    jsoncons::json val(uint8_t(200));
+    VssValue v = VssValue::fromJson(val, VssValue::typeFromDatatype("uint8"));
+    BOOST_TEST((v.type() == VssValue::Type::UINT8));
+    BOOST_TEST(v.asUInt64() == 200u);
+    BOOST_TEST(v.toJson() == val);
+    BOOST_TEST(v.toString() == "200");
+}
+
+BOOST_AUTO_TEST_CASE(Typed_Signed_Roundtrip) {
+    jsoncons::json val(int16_t(-1234));
+    VssValue v = VssValue::fromJson(val, VssValue::typeFromDatatype("int16"));
+    BOOST_TEST((v.type() == VssValue::Type::INT16));
+    BOOST_TEST(v.asInt64() == -1234);
+    BOOST_TEST(v.toJson() == val);
+}
+
+BOOST_AUTO_TEST_CASE(Typed_Float_Roundtrip) {
+    jsoncons::json val(10.5f);
+    VssValue v = VssValue::fromJson(val, VssValue::typeFromDatatype("float"));
+    BOOST_TEST((v.type() == VssValue::Type::FLOAT));
+    BOOST_TEST(v.asFloat() == 10.5f);
+    BOOST_TEST(v.toJson() == val);
+}
+
+BOOST_AUTO_TEST_CASE(Typed_Bool_Roundtrip) {
+    jsoncons::json val(true);
+    VssValue v = VssValue::fromJson(val, VssValue::typeFromDatatype("boolean"));
+    BOOST_TEST((v.type() == VssValue::Type::BOOLEAN));
+    BOOST_TEST(v.asBool() == true);
+    BOOST_TEST(v.toJson() == val);
+    BOOST_TEST(v.toString() == "true");
+}
+
+BOOST_AUTO_TEST_CASE(String_Is_Kept_Unchanged) {
+    jsoncons::json val("100");
+    VssValue v = VssValue::fromJson(val, VssValue::typeFromDatatype("string"));
+    BOOST_TEST((v.type() == VssValue::Type::STRING));
+    BOOST_TEST(v.asString() == "100");
+    BOOST_TEST(v.toJson() == val);
+    BOOST_TEST(v.toString() == "100");
+}
+
+BOOST_AUTO_TEST_CASE(Array_Roundtrip) {
+    jsoncons::json val = jsoncons::json::parse(R"(["a", "b", 3])");
+    VssValue v = VssValue::fromJson(val, VssValue::typeFromDatatype("string[]"));
+    BOOST_TEST((v.type() == VssValue::Type::ARRAY));
+    BOOST_TEST(v.asArray().size() == 3u);
+    BOOST_TEST(v.toJson() == val);
+}
+
+BOOST_AUTO_TEST_CASE(Unknown_Datatype) {
+    BOOST_TEST((VssValue::typeFromDatatype("struct") == VssValue::Type::NONE));
+}
+
+BOOST_AUTO_TEST_CASE(Store_Resize_Keeps_Values) {
+    VssValueStore store;
+    store.resize(2);
+    store[1].value.value = VssValue::fromJson(jsoncons::json(5.0));
+    store[1].value.ts_s = 42;
+
+    store.resize(100);
+    BOOST_TEST(store.size() == 100u);
+    BOOST_TEST(store[1].value.value.asDouble() == 5.0);
+    BOOST_TEST(store[1].value.ts_s == 42u);
+    BOOST_TEST(store[1].attribute("targetValue")->value.isSet() == false);
+    BOOST_TEST(store[1].attribute("description") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(SlotLock_Serializes_Writers) {
+    VssSignalSlot slot;
+    slot.value.value = VssValue::fromJson(jsoncons::json(uint64_t(0)));
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 4; i++) {
+        writers.emplace_back([&slot]() {
+            for (int n = 0; n < 10000; n++) {
+                std::unique_lock<VssSlotLock> lock(slot.lock);
+                slot.value.ts_s++;
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    BOOST_TEST(slot.value.ts_s == 40000u);
+}
+
+BOOST_AUTO_TEST_CASE(SlotLock_Allows_Concurrent_Readers) {
+    VssSignalSlot slot;
+    std::shared_lock<VssSlotLock> first(slot.lock);
+    bool acquired = false;
+    std::thread reader([&slot, &acquired]() {
+        std::shared_lock<VssSlotLock> second(slot.lock);
+        acquired = true;
+    });
+    reader.join();
+    BOOST_TEST(acquired == true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -31,4 +31,6 @@ MOCK_BASE_CLASS( IServerMock, IServer )
   MOCK_METHOD(AddListener, 2)
   MOCK_METHOD(RemoveListener, 2)
   MOCK_METHOD(SendToConnection, 2, bool( ConnectionId, const std::string & ) )
+  // keep default implementation of OutboundMessage overload, it forwards to the mocked one
+  using IServer::SendToConnection;
 };
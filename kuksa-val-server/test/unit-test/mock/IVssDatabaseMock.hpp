@@ -32,13 +32,17 @@ MOCK_BASE_CLASS( IVssDatabaseMock, IVssDatabase )
   MOCK_METHOD(updateJsonTree, 2)
   MOCK_METHOD(updateMetaData, 3)
   MOCK_METHOD(getMetaData, 1)
+  MOCK_METHOD(getNodeMetaData, 1)
   MOCK_METHOD(setSignal, 3)
   MOCK_METHOD(getSignal, 3 )
+  MOCK_METHOD(setSignalValue, 4)
+  MOCK_METHOD(getSignalValue, 2)
   MOCK_METHOD(pathExists, 1)
   MOCK_METHOD(pathIsWritable, 1)
   MOCK_METHOD(pathIsReadable, 1)
   MOCK_METHOD(pathIsAttributable, 2)
   MOCK_METHOD(getLeafPaths,1)
+  MOCK_METHOD(getRevision,1)
   MOCK_METHOD(getDatatypeForPath,1)
   MOCK_METHOD(checkAndSanitizeType,2)
 };